@@ -448,7 +448,7 @@
         
     """
     # Import solvers
-    from .simulated_annealing.send_to_SA import SA
+    from .simulated_annealing.send_to_SA import SA_batch
     from .dwave_interface.Problem_Post import post_problem
     from numpy import log
     
@@ -461,6 +461,10 @@
     if type(instances) == dict:
         instances = [instances]
         
+    # Instance files for the simulated annealer, which solves all of them
+    # in one run after the loop
+    sa_files = []
+        
     for count, instance in enumerate(instances):
         # Run on D-Wave
         if settings['dwave']:
@@ -508,10 +512,6 @@
         # Run Simulated Annealing
         if settings["sa"]:
             
-            # Initialize Simulated Annealing result list
-            if "sa" not in result.keys():
-                result["sa"] = []
-            
             # Set defaults
             if count == 0:
                 solver_sa = "an_ss_ge_fi_vdeg"
@@ -536,7 +536,8 @@
             dir_path = path.dirname(path.realpath(__file__))
             
             # Write instance data into a file in the same directory as this script
-            instance_file = open(dir_path+"/temp_file.txt", "w")
+            sa_files.append("temp_file_"+str(count)+".txt")
+            instance_file = open(dir_path+"/"+sa_files[-1], "w")
             instance_file.write("This file is written automatically for the purposes "+
             "of evaluation by the Simulated Annealing algorithm and is safe to delete.\n")
             for key in instance:
@@ -545,24 +546,40 @@
                 instance_file.write(str(instance[key])+"\n")
             instance_file.close()
             
-            # Locate the solver directory (by finding solver "an_ms_r1_fi.h")
-            for root, dirs, files in walk(dir_path):
-                if "an_ms_r1_fi.h" in files:
-                     solver_path = path.join(root)
-                    
-            # Run simulated annealer
-            if verbose:
-                sa = SA(dir_path, "temp_file.txt", verbose=True, solverDir=solver_path, solver=solver_sa, save=save, solver_params=settings["sa_params"])
-
-            else:
-                sa = SA(dir_path, "temp_file.txt", verbose=False, solverDir=solver_path, solver=solver_sa, save=save, solver_params=settings["sa_params"])
+    # Run Simulated Annealing on all instances at once with the batch
+    # version of the solver, which runs them on one pool of threads
+    if settings["sa"] and sa_files:
+        
+        # Locate the solver directory (by finding solver "an_ms_r1_fi.h")
+        for root, dirs, files in walk(dir_path):
+            if "an_ms_r1_fi.h" in files:
+                 solver_path = path.join(root)
                 
-            # Delete instance data file
-            remove(dir_path+"/temp_file.txt")
-            
-            # Compute TTS
-            result['sa'].append(sa[2]/sa[3]*log(0.01)/log(1-sa[1]))
-            print(result)
+        # Run simulated annealer
+        sa_results = SA_batch(dir_path, sa_files, verbose=verbose, solverDir=solver_path, solver=solver_sa, solver_params=settings["sa_params"])
+        
+        # Save the output if desired
+        if save != None:
+            if save[:4:-1] != "txt.":
+                save = save+".txt"
+            f = open(save, "a+")
+            f.write("    Energy:  Success Rate:  Work Time:  Repetitions:\n")
+            for sa in sa_results:
+                f.write(str(sa)+"\n")
+            f.close()
+        
+        # Delete instance data files
+        for sa_file in sa_files:
+            remove(dir_path+"/"+sa_file)
+        
+        # Compute TTS
+        result['sa'] = []
+        for sa in sa_results:
+            if sa is None:
+                result['sa'].append(float("nan"))
+            else:
+                result['sa'].append(sa[2]/sa[3]*log(0.01)/log(1-sa[1]))
+        print(result)
             
     if plot_settings != None:
         
@@ -34,12 +34,17 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <cmath>
 #include <random>
 #include <vector>
+#include <memory>
 #include <string>
 
 #include "bits.h"
 #include "lattice.h"
 #include "ms_config.h"
 #include "utils.h"
+#include "words.h"
+
+#define MULTI_SPIN
+#define LANE_EXCHANGE
 
 template <typename T = uint64_t, std::size_t depth = 18>
 class Algorithm {
@@ -53,7 +58,6 @@ public:
 	typedef Lattice<value_type, index_type> lattice_type;
 
 	struct site_type {
-		word_type spin;
 		word_type hzw;
 		word_type jzw[MAXNB];
 		value_type hzv;
@@ -72,17 +76,31 @@ public:
 		unsigned r2;
 	};
 
+	// couplings and thresholds are shared by all copies of an instance
+	struct model_type {
+		aligned_vector<site_type> sites;
+		std::vector<sched_type> sched;
+		lane_energies<word_type> terms;
+	};
+
+	typedef typename word_traits<word_type>::rand_type rand_type;
+
 	static const std::size_t word_size = 8 * sizeof(word_type);
+	static const std::size_t rand_bits = 8 * sizeof(rand_type);
 	static const std::size_t rand_size = std::size_t(1) << depth;
 
-	typedef bitgen_lincon<word_type> bgen_type;
-//	typedef bitgen_lagfib<word_type> bgen_type;
+	typedef bitgen_lincon<rand_type> bgen_type;
+//	typedef bitgen_lagfib<rand_type> bgen_type;
 
 	Algorithm() {}
 
 	template <typename SE>
 	Algorithm(const lattice_type& lattice, const std::vector<SE>& sched0)
 	{
+		std::shared_ptr<model_type> m = std::make_shared<model_type>();
+		aligned_vector<site_type>& sites = m->sites;
+		std::vector<sched_type>& sched = m->sched;
+
 		lattice.init_sites(sites, MAXNB);
 
 		for (std::size_t i = 0; i < sites.size(); ++i) {
@@ -117,6 +135,11 @@ public:
 			p *= p0;
 			sched[sweep].r7 = rand_size * p;
 		}
+
+		m->terms.add_sites(sites);
+
+		model = m;
+		spins.resize(sites.size());
 	}
 
 	void reset_sites(std::size_t rep)
@@ -125,44 +148,49 @@ public:
 		bgen.seed(rep + 1);
 
 		// startconf
-		for (std::size_t i = 0; i < sites.size(); ++i)
-			sites[i].spin = random_word(rgen, sites[i].spin);
+		for (std::size_t i = 0; i < spins.size(); ++i)
+			spins[i] = random_word(rgen, spins[i]);
+
+		best.reset();
 	}
 
 	void do_sweep(size_t sweep)
 	{
+		const aligned_vector<site_type>& sites = model->sites;
+		const std::vector<sched_type>& sched = model->sched;
+
 		for (std::size_t i = 0; i < sites.size(); ++i) {
-			site_type& site = sites[i];
+			const site_type& site = sites[i];
 			if (site.hzv != 0) {
 				switch (site.nneighbs) {
 #	ifdef USE_1_NEIGHB
 				case 1:
-					update_site1field(site, sched[sweep]);
+					update_site1field(i, site, sched[sweep]);
 					break;
 #	endif
 #	ifdef USE_2_NEIGHB
 				case 2:
-					update_site2field(site, sched[sweep]);
+					update_site2field(i, site, sched[sweep]);
 					break;
 #	endif
 #	ifdef USE_3_NEIGHB
 				case 3:
-					update_site3field(site, sched[sweep]);
+					update_site3field(i, site, sched[sweep]);
 					break;
 #	endif
 #	ifdef USE_4_NEIGHB
 				case 4:
-					update_site4field(site, sched[sweep]);
+					update_site4field(i, site, sched[sweep]);
 					break;
 #	endif
 #	ifdef USE_5_NEIGHB
 				case 5:
-					update_site5field(site, sched[sweep]);
+					update_site5field(i, site, sched[sweep]);
 					break;
 #	endif
 #	ifdef USE_6_NEIGHB
 				case 6:
-					update_site6field(site, sched[sweep]);
+					update_site6field(i, site, sched[sweep]);
 					break;
 #	endif
 				}
@@ -170,32 +198,32 @@ public:
 				switch (site.nneighbs) {
 #	ifdef USE_1_NEIGHB
 				case 1:
-					update_site1nofield(site, sched[sweep]);
+					update_site1nofield(i, site, sched[sweep]);
 					break;
 #	endif
 #	ifdef USE_2_NEIGHB
 				case 2:
-					update_site2nofield(site, sched[sweep]);
+					update_site2nofield(i, site, sched[sweep]);
 					break;
 #	endif
 #	ifdef USE_3_NEIGHB
 				case 3:
-					update_site3nofield(site, sched[sweep]);
+					update_site3nofield(i, site, sched[sweep]);
 					break;
 #	endif
 #	ifdef USE_4_NEIGHB
 				case 4:
-					update_site4nofield(site, sched[sweep]);
+					update_site4nofield(i, site, sched[sweep]);
 					break;
 #	endif
 #	ifdef USE_5_NEIGHB
 				case 5:
-					update_site5nofield(site, sched[sweep]);
+					update_site5nofield(i, site, sched[sweep]);
 					break;
 #	endif
 #	ifdef USE_6_NEIGHB
 				case 6:
-					update_site6nofield(site, sched[sweep]);
+					update_site6nofield(i, site, sched[sweep]);
 					break;
 #	endif
 				}
@@ -213,41 +241,93 @@ public:
 	{
 		return "algorithm: multi-spin, range-1 couplings, with fields";
 	}
+
+	// swaps the replicas in the given lanes with those of another instance
+	void exchange_lanes(Algorithm& other, const std::vector<char>& lanes)
+	{
+		word_type mask = lanes_to_word<word_type>(lanes);
+		for (std::size_t i = 0; i < spins.size(); ++i) {
+			word_type t = (spins[i] ^ other.spins[i]) & mask;
+			spins[i] ^= t;
+			other.spins[i] ^= t;
+		}
+	}
+
+	// copies the replicas in the given lanes from another instance
+	void copy_lanes(const Algorithm& src, const std::vector<char>& lanes)
+	{
+		word_type mask = lanes_to_word<word_type>(lanes);
+		for (std::size_t i = 0; i < spins.size(); ++i)
+			spins[i] ^= (spins[i] ^ src.spins[i]) & mask;
+	}
+
+	// spins of the replica in lane k in the order of the sites, 1 for up
+	void get_spins(std::size_t k, std::vector<char>& s) const
+	{
+		s.resize(spins.size());
+		for (std::size_t i = 0; i < spins.size(); ++i)
+			s[i] = word_bit(spins[i], k);
+	}
+
+	// tells whether the energy of one of the lanes is at most e; the
+	// unsatisfied couplings of all lanes are counted at once
+	bool reached_energy(double e)
+	{
+		model->terms.count(&spins[0], counts);
+		return word_any(model->terms.at_most(counts, e));
+	}
+
+	// keeps the spins of every lane whose energy is lower than any it
+	// had at a call before
+	void update_best()
+	{
+		model->terms.count(&spins[0], counts);
+		best.update(counts, &spins[0], spins.size());
+	}
+
+	// puts back the lowest energy state of every lane kept by update_best
+	void restore_best()
+	{
+		spins = best.get_spins();
+	}
 private:
-	std::vector<site_type> sites;
-	std::vector<sched_type> sched;
+	std::shared_ptr<const model_type> model;
+
+	aligned_vector<word_type> spins;
+	aligned_vector<word_type> counts;
+	lane_best<word_type> best;
 
 	std::mt19937 rgen;
 	bgen_type bgen;
 
-	void update_site1field(site_type& site, const sched_type& sched)
+	void update_site1field(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
-		word_type l0 = site.jzw[0] ^ (spin ^ sites[site.neighbs[0]].spin);
-		word_type l1 = site.hzw ^ site.spin;
+		word_type l0 = site.jzw[0] ^ (spin ^ spins[site.neighbs[0]]);
+		word_type l1 = site.hzw ^ spin;
 
 		word_type j0 = l0 ^ l1;
 		word_type j1 = l0 & l1;
 
 		if (r >= sched.r2) {
 			word_type mask = j0 | j1;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 
-	void update_site2field(site_type& site, const sched_type& sched)
+	void update_site2field(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
-		word_type l0 = site.jzw[0] ^ (spin ^ sites[site.neighbs[0]].spin);
-		word_type l1 = site.jzw[1] ^ (spin ^ sites[site.neighbs[1]].spin);
-		word_type l2 = site.hzw ^ site.spin;
+		word_type l0 = site.jzw[0] ^ (spin ^ spins[site.neighbs[0]]);
+		word_type l1 = site.jzw[1] ^ (spin ^ spins[site.neighbs[1]]);
+		word_type l2 = site.hzw ^ spin;
 
 		word_type j1 = l0 ^ l1;
 		word_type j0 = j1 ^ l2;
@@ -255,25 +335,25 @@ private:
 
 		if (r >= sched.r1) {
 			word_type mask = j1;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r3) {
 			word_type mask = j1 | j0;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 
-	void update_site3field(site_type& site, const sched_type& sched)
+	void update_site3field(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
-		word_type l0 = site.jzw[0] ^ (spin ^ sites[site.neighbs[0]].spin);
-		word_type l1 = site.jzw[1] ^ (spin ^ sites[site.neighbs[1]].spin);
-		word_type l2 = site.jzw[2] ^ (spin ^ sites[site.neighbs[2]].spin);
-		word_type l3 = site.hzw ^ site.spin;
+		word_type l0 = site.jzw[0] ^ (spin ^ spins[site.neighbs[0]]);
+		word_type l1 = site.jzw[1] ^ (spin ^ spins[site.neighbs[1]]);
+		word_type l2 = site.jzw[2] ^ (spin ^ spins[site.neighbs[2]]);
+		word_type l3 = site.hzw ^ spin;
 
 		word_type j0 = l0 ^ l1;
 		word_type j1 = l0 & l1;
@@ -282,26 +362,26 @@ private:
 
 		if (r >= sched.r2) {
 			word_type mask = j1 | j3 | (j0 & j2);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r4) {
 			word_type mask = j1 | j3 | j0 | j2;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 
-	void update_site4field(site_type& site, const sched_type& sched)
+	void update_site4field(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
-		word_type l0 = site.jzw[0] ^ (spin ^ sites[site.neighbs[0]].spin);
-		word_type l1 = site.jzw[1] ^ (spin ^ sites[site.neighbs[1]].spin);
-		word_type l2 = site.jzw[2] ^ (spin ^ sites[site.neighbs[2]].spin);
-		word_type l3 = site.jzw[3] ^ (spin ^ sites[site.neighbs[3]].spin);
-		word_type l4 = site.hzw ^ site.spin;
+		word_type l0 = site.jzw[0] ^ (spin ^ spins[site.neighbs[0]]);
+		word_type l1 = site.jzw[1] ^ (spin ^ spins[site.neighbs[1]]);
+		word_type l2 = site.jzw[2] ^ (spin ^ spins[site.neighbs[2]]);
+		word_type l3 = site.jzw[3] ^ (spin ^ spins[site.neighbs[3]]);
+		word_type l4 = site.hzw ^ spin;
 
 		word_type j1 = l0 ^ l1;
 		word_type j0 = j1 ^ l2;
@@ -312,30 +392,30 @@ private:
 
 		if (r >= sched.r1) {
 			word_type mask = ((j1 | j3) & (j0 | j2)) | (j1 & j3);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r3) {
 			word_type mask = (j0 & j2) | j1 | j3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r5) {
 			word_type mask = j0 | j2 | j1 | j3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 
-	void update_site5field(site_type& site, const sched_type& sched)
+	void update_site5field(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
-		word_type l0 = site.jzw[0] ^ (spin ^ sites[site.neighbs[0]].spin);
-		word_type l1 = site.jzw[1] ^ (spin ^ sites[site.neighbs[1]].spin);
-		word_type l2 = site.jzw[2] ^ (spin ^ sites[site.neighbs[2]].spin);
-		word_type l3 = site.jzw[3] ^ (spin ^ sites[site.neighbs[3]].spin);
-		word_type l4 = site.jzw[4] ^ (spin ^ sites[site.neighbs[4]].spin);
-		word_type l5 = site.hzw ^ site.spin;
+		word_type l0 = site.jzw[0] ^ (spin ^ spins[site.neighbs[0]]);
+		word_type l1 = site.jzw[1] ^ (spin ^ spins[site.neighbs[1]]);
+		word_type l2 = site.jzw[2] ^ (spin ^ spins[site.neighbs[2]]);
+		word_type l3 = site.jzw[3] ^ (spin ^ spins[site.neighbs[3]]);
+		word_type l4 = site.jzw[4] ^ (spin ^ spins[site.neighbs[4]]);
+		word_type l5 = site.hzw ^ spin;
 
 		word_type j1 = l0 ^ l1;
 		word_type j0 = j1 ^ l2;
@@ -347,31 +427,31 @@ private:
 
 		if (r >= sched.r2) {
 			word_type mask = ((j1 | j3) & (j0 | j2)) | (j1 & j3);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r4) {
 			word_type mask = (j0 & j2) | j1 | j3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r6) {
 			word_type mask = j0 | j2 | j1 | j3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 
-	void update_site6field(site_type& site, const sched_type& sched)
+	void update_site6field(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
-		word_type l0 = site.jzw[0] ^ (spin ^ sites[site.neighbs[0]].spin);
-		word_type l1 = site.jzw[1] ^ (spin ^ sites[site.neighbs[1]].spin);
-		word_type l2 = site.jzw[2] ^ (spin ^ sites[site.neighbs[2]].spin);
-		word_type l3 = site.jzw[3] ^ (spin ^ sites[site.neighbs[3]].spin);
-		word_type l4 = site.jzw[4] ^ (spin ^ sites[site.neighbs[4]].spin);
-		word_type l5 = site.jzw[5] ^ (spin ^ sites[site.neighbs[5]].spin);
-		word_type l6 = site.hzw ^ site.spin;
+		word_type l0 = site.jzw[0] ^ (spin ^ spins[site.neighbs[0]]);
+		word_type l1 = site.jzw[1] ^ (spin ^ spins[site.neighbs[1]]);
+		word_type l2 = site.jzw[2] ^ (spin ^ spins[site.neighbs[2]]);
+		word_type l3 = site.jzw[3] ^ (spin ^ spins[site.neighbs[3]]);
+		word_type l4 = site.jzw[4] ^ (spin ^ spins[site.neighbs[4]]);
+		word_type l5 = site.jzw[5] ^ (spin ^ spins[site.neighbs[5]]);
+		word_type l6 = site.hzw ^ spin;
 
 		word_type j1, j2, j3, m;
 
@@ -404,66 +484,66 @@ private:
 
 		if (r >= sched.r1) {
 			word_type mask = j3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r3) {
 			word_type mask = j3 | (j2 & j1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r5) {
 			word_type mask = j3 | j2;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r7) {
 			word_type mask = j3 | j2 | j1;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 
-	void update_site1nofield(site_type& site, const sched_type& sched)
+	void update_site1nofield(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
-		word_type l0 = site.jzw[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		word_type l0 = site.jzw[0] ^ (spin ^ spins[site.neighbs[0]]);
 
 		if (r >= sched.r1) {
 			word_type mask = l0;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 
-	void update_site2nofield(site_type& site, const sched_type& sched)
+	void update_site2nofield(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
-		word_type l0 = site.jzw[0] ^ (spin ^ sites[site.neighbs[0]].spin);
-		word_type l1 = site.jzw[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		word_type l0 = site.jzw[0] ^ (spin ^ spins[site.neighbs[0]]);
+		word_type l1 = site.jzw[1] ^ (spin ^ spins[site.neighbs[1]]);
 
 		word_type j0 = l0 ^ l1;
 		word_type j1 = l0 & l1;
 
 		if (r >= sched.r2) {
 			word_type mask = j0 | j1;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 
-	void update_site3nofield(site_type& site, const sched_type& sched)
+	void update_site3nofield(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
-		word_type l0 = site.jzw[0] ^ (spin ^ sites[site.neighbs[0]].spin);
-		word_type l1 = site.jzw[1] ^ (spin ^ sites[site.neighbs[1]].spin);
-		word_type l2 = site.jzw[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		word_type l0 = site.jzw[0] ^ (spin ^ spins[site.neighbs[0]]);
+		word_type l1 = site.jzw[1] ^ (spin ^ spins[site.neighbs[1]]);
+		word_type l2 = site.jzw[2] ^ (spin ^ spins[site.neighbs[2]]);
 
 		word_type j1 = l0 ^ l1;
 		word_type j0 = j1 ^ l2;
@@ -471,25 +551,25 @@ private:
 
 		if (r >= sched.r1) {
 			word_type mask = j1;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r3) {
 			word_type mask = j1 | j0;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 
-	void update_site4nofield(site_type& site, const sched_type& sched)
+	void update_site4nofield(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
-		word_type l0 = site.jzw[0] ^ (spin ^ sites[site.neighbs[0]].spin);
-		word_type l1 = site.jzw[1] ^ (spin ^ sites[site.neighbs[1]].spin);
-		word_type l2 = site.jzw[2] ^ (spin ^ sites[site.neighbs[2]].spin);
-		word_type l3 = site.jzw[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		word_type l0 = site.jzw[0] ^ (spin ^ spins[site.neighbs[0]]);
+		word_type l1 = site.jzw[1] ^ (spin ^ spins[site.neighbs[1]]);
+		word_type l2 = site.jzw[2] ^ (spin ^ spins[site.neighbs[2]]);
+		word_type l3 = site.jzw[3] ^ (spin ^ spins[site.neighbs[3]]);
 
 		word_type j0 = l0 ^ l1;
 		word_type j1 = l0 & l1;
@@ -499,26 +579,26 @@ private:
 
 		if (r >= sched.r2) {
 			word_type mask = j1 | j3 | (j0 & j2);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r4) {
 			word_type mask = j1 | j3 | j0 | j2;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 
-	void update_site5nofield(site_type& site, const sched_type& sched)
+	void update_site5nofield(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
-		word_type l0 = site.jzw[0] ^ (spin ^ sites[site.neighbs[0]].spin);
-		word_type l1 = site.jzw[1] ^ (spin ^ sites[site.neighbs[1]].spin);
-		word_type l2 = site.jzw[2] ^ (spin ^ sites[site.neighbs[2]].spin);
-		word_type l3 = site.jzw[3] ^ (spin ^ sites[site.neighbs[3]].spin);
-		word_type l4 = site.jzw[4] ^ (spin ^ sites[site.neighbs[4]].spin);
+		word_type l0 = site.jzw[0] ^ (spin ^ spins[site.neighbs[0]]);
+		word_type l1 = site.jzw[1] ^ (spin ^ spins[site.neighbs[1]]);
+		word_type l2 = site.jzw[2] ^ (spin ^ spins[site.neighbs[2]]);
+		word_type l3 = site.jzw[3] ^ (spin ^ spins[site.neighbs[3]]);
+		word_type l4 = site.jzw[4] ^ (spin ^ spins[site.neighbs[4]]);
 
 		word_type j1 = l0 ^ l1;
 		word_type j0 = j1 ^ l2;
@@ -529,30 +609,30 @@ private:
 
 		if (r >= sched.r1) {
 			word_type mask = ((j1 | j3) & (j0 | j2)) | (j1 & j3);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r3) {
 			word_type mask = (j0 & j2) | j1 | j3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r5) {
 			word_type mask = j0 | j2 | j1 | j3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 
-	void update_site6nofield(site_type& site, const sched_type& sched)
+	void update_site6nofield(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
-		word_type l0 = site.jzw[0] ^ (spin ^ sites[site.neighbs[0]].spin);
-		word_type l1 = site.jzw[1] ^ (spin ^ sites[site.neighbs[1]].spin);
-		word_type l2 = site.jzw[2] ^ (spin ^ sites[site.neighbs[2]].spin);
-		word_type l3 = site.jzw[3] ^ (spin ^ sites[site.neighbs[3]].spin);
-		word_type l4 = site.jzw[4] ^ (spin ^ sites[site.neighbs[4]].spin);
-		word_type l5 = site.jzw[5] ^ (spin ^ sites[site.neighbs[5]].spin);
+		word_type l0 = site.jzw[0] ^ (spin ^ spins[site.neighbs[0]]);
+		word_type l1 = site.jzw[1] ^ (spin ^ spins[site.neighbs[1]]);
+		word_type l2 = site.jzw[2] ^ (spin ^ spins[site.neighbs[2]]);
+		word_type l3 = site.jzw[3] ^ (spin ^ spins[site.neighbs[3]]);
+		word_type l4 = site.jzw[4] ^ (spin ^ spins[site.neighbs[4]]);
+		word_type l5 = site.jzw[5] ^ (spin ^ spins[site.neighbs[5]]);
 
 		word_type j1 = l0 ^ l1;
 		word_type j0 = j1 ^ l2;
@@ -564,33 +644,35 @@ private:
 
 		if (r >= sched.r2) {
 			word_type mask = ((j1 | j3) & (j0 | j2)) | (j1 & j3);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r4) {
 			word_type mask = (j0 & j2) | j1 | j3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r6) {
 			word_type mask = j0 | j2 | j1 | j3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 
 	void calc_energies(std::vector<value_type>& en, std::size_t offs) const
 	{
+		const aligned_vector<site_type>& sites = model->sites;
+
 		for (unsigned k = 0; k < word_size; ++k) {
 			for (std::size_t i = 0; i < sites.size(); ++i) {
 				const site_type& site = sites[i];
 
-				int spin = 2 * int((site.spin >> k) & 1) - 1;
+				int spin = 2 * int(word_bit(spins[i], k)) - 1;
 
 				value_type h = 0;
 				for (std::size_t l = 0; l < site.nneighbs; ++l) {
 					std::size_t j = site.neighbs[l];
 					if (i > j) continue;
 
-					int nspin = 2 * int((sites[j].spin >> k) & 1) - 1;
+					int nspin = 2 * int(word_bit(spins[j], k)) - 1;
 					h += site.jzv[l] * nspin;
 				}
 
@@ -34,12 +34,19 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <cmath>
 #include <random>
 #include <vector>
+#include <memory>
 #include <string>
+#include <unordered_map>
 
 #include "bits.h"
 #include "lattice.h"
 #include "ms_config.h"
 #include "utils.h"
+#include "words.h"
+
+#define MULTI_SPIN
+#define LANE_EXCHANGE
+#define LANE_INSTANCES
 
 template <typename T = uint64_t, std::size_t depth = 18>
 class Algorithm {
@@ -53,7 +60,6 @@ public:
 	typedef Lattice<value_type, index_type> lattice_type;
 
 	struct site_type {
-		word_type spin;
 		word_type hzw;
 		word_type jzw[MAXNB];
 		value_type hzv;
@@ -71,17 +77,33 @@ public:
 		unsigned r1;
 	};
 
+	// couplings and thresholds are shared by all copies of an instance;
+	// lane_couplings is set if the lanes have different couplings
+	struct model_type {
+		aligned_vector<site_type> sites;
+		std::vector<sched_type> sched;
+		lane_energies<word_type> terms;
+		bool lane_couplings;
+	};
+
+	typedef typename word_traits<word_type>::rand_type rand_type;
+
 	static const std::size_t word_size = 8 * sizeof(word_type);
+	static const std::size_t rand_bits = 8 * sizeof(rand_type);
 	static const std::size_t rand_size = std::size_t(1) << depth;
 
-	typedef bitgen_lincon<word_type> bgen_type;
-//	typedef bitgen_lagfib<word_type> bgen_type;
+	typedef bitgen_lincon<rand_type> bgen_type;
+//	typedef bitgen_lagfib<rand_type> bgen_type;
 
 	Algorithm() {}
 
 	template <typename SE>
 	Algorithm(const lattice_type& lattice, const std::vector<SE>& sched0)
 	{
+		std::shared_ptr<model_type> m = std::make_shared<model_type>();
+		aligned_vector<site_type>& sites = m->sites;
+		std::vector<sched_type>& sched = m->sched;
+
 		lattice.init_sites(sites, MAXNB);
 
 		for (std::size_t i = 0; i < sites.size(); ++i) {
@@ -112,6 +134,36 @@ public:
 			p *= p0;
 			sched[sweep].r6 = rand_size * p;
 		}
+
+		m->lane_couplings = false;
+		m->terms.add_sites(sites);
+
+		model = m;
+		spins.resize(sites.size());
+	}
+
+	// lane k of every word anneals the instance lanes[k % lanes.size()]
+	// instead of lattice; the instances must have the sites and links of
+	// lattice and may differ in the signs of the couplings
+	template <typename SE>
+	Algorithm(const lattice_type& lattice, const std::vector<SE>& sched0,
+		const std::vector<const lattice_type*>& lanes) : Algorithm(lattice, sched0)
+	{
+		if (lanes.empty()) return;
+
+		std::shared_ptr<model_type> m = std::make_shared<model_type>(*model);
+		set_lane_couplings(m->sites, lattice, lanes);
+		m->lane_couplings = true;
+
+		m->terms = lane_energies<word_type>();
+		for (std::size_t i = 0; i < m->sites.size(); ++i) {
+			const site_type& site = m->sites[i];
+			for (std::size_t l = 0; l < site.nneighbs; ++l)
+				if (i < site.neighbs[l])
+					m->terms.add_lanes(i, site.neighbs[l], site.jzw[l]);
+		}
+
+		model = m;
 	}
 
 	void reset_sites(std::size_t rep)
@@ -120,43 +172,48 @@ public:
 		bgen.seed(rep + 1);
 
 		// startconf
-		for (std::size_t i = 0; i < sites.size(); ++i)
-			sites[i].spin = random_word(rgen, sites[i].spin);
+		for (std::size_t i = 0; i < spins.size(); ++i)
+			spins[i] = random_word(rgen, spins[i]);
+
+		best.reset();
 	}
 
 	void do_sweep(std::size_t sweep)
 	{
+		const aligned_vector<site_type>& sites = model->sites;
+		const std::vector<sched_type>& sched = model->sched;
+
 		for (std::size_t i = 0; i < sites.size(); ++i) {
-			site_type& site = sites[i];
+			const site_type& site = sites[i];
 			switch (site.nneighbs) {
 #	ifdef USE_1_NEIGHB
 			case 1:
-				update_site1(site, sched[sweep]);
+				update_site1(i, site, sched[sweep]);
 				break;
 #	endif
 #	ifdef USE_2_NEIGHB
 			case 2:
-				update_site2(site, sched[sweep]);
+				update_site2(i, site, sched[sweep]);
 				break;
 #	endif
 #	ifdef USE_3_NEIGHB
 			case 3:
-				update_site3(site, sched[sweep]);
+				update_site3(i, site, sched[sweep]);
 				break;
 #	endif
 #	ifdef USE_4_NEIGHB
 			case 4:
-				update_site4(site, sched[sweep]);
+				update_site4(i, site, sched[sweep]);
 				break;
 #	endif
 #	ifdef USE_5_NEIGHB
 			case 5:
-				update_site5(site, sched[sweep]);
+				update_site5(i, site, sched[sweep]);
 				break;
 #	endif
 #	ifdef USE_6_NEIGHB
 			case 6:
-				update_site6(site, sched[sweep]);
+				update_site6(i, site, sched[sweep]);
 				break;
 #	endif
 			}
@@ -173,57 +230,154 @@ public:
 	{
 		return "algorithm: multi-spin, range-1 couplings, without fields";
 	}
+
+	// swaps the replicas in the given lanes with those of another instance
+	void exchange_lanes(Algorithm& other, const std::vector<char>& lanes)
+	{
+		word_type mask = lanes_to_word<word_type>(lanes);
+		for (std::size_t i = 0; i < spins.size(); ++i) {
+			word_type t = (spins[i] ^ other.spins[i]) & mask;
+			spins[i] ^= t;
+			other.spins[i] ^= t;
+		}
+	}
+
+	// copies the replicas in the given lanes from another instance
+	void copy_lanes(const Algorithm& src, const std::vector<char>& lanes)
+	{
+		word_type mask = lanes_to_word<word_type>(lanes);
+		for (std::size_t i = 0; i < spins.size(); ++i)
+			spins[i] ^= (spins[i] ^ src.spins[i]) & mask;
+	}
+
+	// spins of the replica in lane k in the order of the sites, 1 for up
+	void get_spins(std::size_t k, std::vector<char>& s) const
+	{
+		s.resize(spins.size());
+		for (std::size_t i = 0; i < spins.size(); ++i)
+			s[i] = word_bit(spins[i], k);
+	}
+
+	// tells whether the energy of one of the lanes is at most e; the
+	// unsatisfied couplings of all lanes are counted at once
+	bool reached_energy(double e)
+	{
+		model->terms.count(&spins[0], counts);
+		return word_any(model->terms.at_most(counts, e));
+	}
+
+	// keeps the spins of every lane whose energy is lower than any it
+	// had at a call before
+	void update_best()
+	{
+		model->terms.count(&spins[0], counts);
+		best.update(counts, &spins[0], spins.size());
+	}
+
+	// puts back the lowest energy state of every lane kept by update_best
+	void restore_best()
+	{
+		spins = best.get_spins();
+	}
 private:
-	std::vector<site_type> sites;
-	std::vector<sched_type> sched;
+	std::shared_ptr<const model_type> model;
+
+	static void set_lane_couplings(aligned_vector<site_type>& sites,
+		const lattice_type& lattice, const std::vector<const lattice_type*>& lanes)
+	{
+		// instances are matched to lattice by the labels of their sites
+		const std::vector<index_type>& labels = lattice.get_labels();
+		std::unordered_map<index_type, index_type> index;
+		for (std::size_t i = 0; i < labels.size(); ++i)
+			index[labels[i]] = i;
+
+		for (std::size_t n = 0; n < lanes.size(); ++n) {
+			std::vector<char> lane_set(word_size, 0);
+			for (std::size_t k = n; k < word_size; k += lanes.size())
+				lane_set[k] = 1;
+			word_type mask = lanes_to_word<word_type>(lane_set);
+
+			aligned_vector<site_type> lsites;
+			lanes[n]->init_sites(lsites, MAXNB);
+			const std::vector<index_type>& llabels = lanes[n]->get_labels();
+
+			bool same = lsites.size() == sites.size();
+			for (std::size_t i0 = 0; same && i0 < lsites.size(); ++i0) {
+				auto it = index.find(llabels[i0]);
+				same = it != index.end() && sites[it->second].nneighbs == lsites[i0].nneighbs;
+				if (!same) break;
+
+				site_type& site = sites[it->second];
+				for (std::size_t l0 = 0; same && l0 < lsites[i0].nneighbs; ++l0) {
+					auto jt = index.find(llabels[lsites[i0].neighbs[l0]]);
+					std::size_t l = 0;
+					while (l < site.nneighbs && (jt == index.end() || site.neighbs[l] != jt->second))
+						++l;
+					same = l < site.nneighbs;
+					if (!same) break;
+
+					word_type j = lsites[i0].jzv[l0] == 1 ? word_type(-1) : 0;
+					site.jzw[l] ^= (site.jzw[l] ^ j) & mask;
+				}
+			}
+
+			if (!same)
+				throw std::runtime_error("instance " + to_s(n + 1) +
+					" of the list does not have the sites and links of the first one");
+		}
+	}
+
+	aligned_vector<word_type> spins;
+	aligned_vector<word_type> counts;
+	lane_best<word_type> best;
 
 	std::mt19937 rgen;
 	bgen_type bgen;
 
-	void update_site1(site_type& site, const sched_type& sched)
+	void update_site1(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
-		word_type l0 = site.jzw[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		word_type l0 = site.jzw[0] ^ (spin ^ spins[site.neighbs[0]]);
 
 		if (r >= sched.r1) {
 			word_type mask = l0;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 
-	void update_site2(site_type& site, const sched_type& sched)
+	void update_site2(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
-		word_type l0 = site.jzw[0] ^ (spin ^ sites[site.neighbs[0]].spin);
-		word_type l1 = site.jzw[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		word_type l0 = site.jzw[0] ^ (spin ^ spins[site.neighbs[0]]);
+		word_type l1 = site.jzw[1] ^ (spin ^ spins[site.neighbs[1]]);
 
 		word_type j0 = l0 ^ l1;
 		word_type j1 = l0 & l1;
 
 		if (r >= sched.r2) {
 			word_type mask = j0 | j1;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 
-	void update_site3(site_type& site, const sched_type& sched)
+	void update_site3(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
-		word_type l0 = site.jzw[0] ^ (spin ^ sites[site.neighbs[0]].spin);
-		word_type l1 = site.jzw[1] ^ (spin ^ sites[site.neighbs[1]].spin);
-		word_type l2 = site.jzw[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		word_type l0 = site.jzw[0] ^ (spin ^ spins[site.neighbs[0]]);
+		word_type l1 = site.jzw[1] ^ (spin ^ spins[site.neighbs[1]]);
+		word_type l2 = site.jzw[2] ^ (spin ^ spins[site.neighbs[2]]);
 
 		word_type j1 = l0 ^ l1;
 		word_type j0 = j1 ^ l2;
@@ -231,25 +385,25 @@ private:
 
 		if (r >= sched.r1) {
 			word_type mask = j1;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r3) {
 			word_type mask = j1 | j0;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 
-	void update_site4(site_type& site, const sched_type& sched)
+	void update_site4(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
-		word_type l0 = site.jzw[0] ^ (spin ^ sites[site.neighbs[0]].spin);
-		word_type l1 = site.jzw[1] ^ (spin ^ sites[site.neighbs[1]].spin);
-		word_type l2 = site.jzw[2] ^ (spin ^ sites[site.neighbs[2]].spin);
-		word_type l3 = site.jzw[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		word_type l0 = site.jzw[0] ^ (spin ^ spins[site.neighbs[0]]);
+		word_type l1 = site.jzw[1] ^ (spin ^ spins[site.neighbs[1]]);
+		word_type l2 = site.jzw[2] ^ (spin ^ spins[site.neighbs[2]]);
+		word_type l3 = site.jzw[3] ^ (spin ^ spins[site.neighbs[3]]);
 
 		word_type j0 = l0 ^ l1;
 		word_type j1 = l0 & l1;
@@ -259,26 +413,26 @@ private:
 
 		if (r >= sched.r2) {
 			word_type mask = j1 | j3 | (j0 & j2);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r4) {
 			word_type mask = j1 | j3 | j0 | j2;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 
-	void update_site5(site_type& site, const sched_type& sched)
+	void update_site5(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
-		word_type l0 = site.jzw[0] ^ (spin ^ sites[site.neighbs[0]].spin);
-		word_type l1 = site.jzw[1] ^ (spin ^ sites[site.neighbs[1]].spin);
-		word_type l2 = site.jzw[2] ^ (spin ^ sites[site.neighbs[2]].spin);
-		word_type l3 = site.jzw[3] ^ (spin ^ sites[site.neighbs[3]].spin);
-		word_type l4 = site.jzw[4] ^ (spin ^ sites[site.neighbs[4]].spin);
+		word_type l0 = site.jzw[0] ^ (spin ^ spins[site.neighbs[0]]);
+		word_type l1 = site.jzw[1] ^ (spin ^ spins[site.neighbs[1]]);
+		word_type l2 = site.jzw[2] ^ (spin ^ spins[site.neighbs[2]]);
+		word_type l3 = site.jzw[3] ^ (spin ^ spins[site.neighbs[3]]);
+		word_type l4 = site.jzw[4] ^ (spin ^ spins[site.neighbs[4]]);
 
 		word_type j1 = l0 ^ l1;
 		word_type j0 = j1 ^ l2;
@@ -289,30 +443,30 @@ private:
 
 		if (r >= sched.r1) {
 			word_type mask = ((j1 | j3) & (j0 | j2)) | (j1 & j3);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r3) {
 			word_type mask = (j0 & j2) | j1 | j3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r5) {
 			word_type mask = j0 | j2 | j1 | j3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 
-	void update_site6(site_type& site, const sched_type& sched)
+	void update_site6(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
-		word_type l0 = site.jzw[0] ^ (spin ^ sites[site.neighbs[0]].spin);
-		word_type l1 = site.jzw[1] ^ (spin ^ sites[site.neighbs[1]].spin);
-		word_type l2 = site.jzw[2] ^ (spin ^ sites[site.neighbs[2]].spin);
-		word_type l3 = site.jzw[3] ^ (spin ^ sites[site.neighbs[3]].spin);
-		word_type l4 = site.jzw[4] ^ (spin ^ sites[site.neighbs[4]].spin);
-		word_type l5 = site.jzw[5] ^ (spin ^ sites[site.neighbs[5]].spin);
+		word_type l0 = site.jzw[0] ^ (spin ^ spins[site.neighbs[0]]);
+		word_type l1 = site.jzw[1] ^ (spin ^ spins[site.neighbs[1]]);
+		word_type l2 = site.jzw[2] ^ (spin ^ spins[site.neighbs[2]]);
+		word_type l3 = site.jzw[3] ^ (spin ^ spins[site.neighbs[3]]);
+		word_type l4 = site.jzw[4] ^ (spin ^ spins[site.neighbs[4]]);
+		word_type l5 = site.jzw[5] ^ (spin ^ spins[site.neighbs[5]]);
 
 		word_type j1 = l0 ^ l1;
 		word_type j0 = j1 ^ l2;
@@ -324,34 +478,39 @@ private:
 
 		if (r >= sched.r2) {
 			word_type mask = ((j1 | j3) & (j0 | j2)) | (j1 & j3);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r4) {
 			word_type mask = (j0 & j2) | j1 | j3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r6) {
 			word_type mask = j0 | j2 | j1 | j3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 
 	void calc_energies(std::vector<value_type>& en, std::size_t offs) const
 	{
+		const aligned_vector<site_type>& sites = model->sites;
+
 		for (unsigned k = 0; k < word_size; ++k) {
 			for (std::size_t i = 0; i < sites.size(); ++i) {
 				const site_type& site = sites[i];
 
-				int spin = 2 * int((site.spin >> k) & 1) - 1;
+				int spin = 2 * int(word_bit(spins[i], k)) - 1;
 
 				value_type h = 0;
 				for (std::size_t l = 0; l < site.nneighbs; ++l) {
 					std::size_t j = site.neighbs[l];
 					if (i > j) continue;
 
-					int nspin = 2 * int((sites[j].spin >> k) & 1) - 1;
-					h += site.jzv[l] * nspin;
+					int nspin = 2 * int(word_bit(spins[j], k)) - 1;
+					if (model->lane_couplings)
+						h += (2 * int(word_bit(site.jzw[l], k)) - 1) * nspin;
+					else
+						h += site.jzv[l] * nspin;
 				}
 
 				en[offs + k] += h * spin;
@@ -0,0 +1,540 @@
+/******************************************************************************
+
+Simulated annealing codes
+v1.0
+
+---------------------------------------------------------------------
+
+Implementation of multi-spin simulated annealing algorithm for
+Ising spin glasses with range-1 interactions without magnetic field
+on Chimera graphs of M x N unit cells with 2L qubits each. Spins are
+stored by qubit label, so the spins of a unit cell are contiguous and
+the neighbors of complete unit cells are found from the label. Sites
+of incomplete unit cells are updated with explicit neighbor lists.
+
+---------------------------------------------------------------------
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*******************************************************************************/
+
+#ifndef __ALGORITHM_H__
+#define __ALGORITHM_H__
+
+#include <cmath>
+#include <random>
+#include <vector>
+#include <memory>
+#include <string>
+#include <cstdint>
+#include <stdexcept>
+
+#include "bits.h"
+#include "lattice.h"
+#include "ms_config.h"
+#include "utils.h"
+#include "words.h"
+
+#define MULTI_SPIN
+#define LANE_EXCHANGE
+
+// default size of the Chimera graph; qubit k of side u of the cell
+// in row r and column c has label 2L (N r + c) + L u + k, side 0
+// couples to the cells above and below, side 1 to the left and right
+
+#ifndef CHIMERA_M
+#define CHIMERA_M 8
+#endif
+
+#ifndef CHIMERA_N
+#define CHIMERA_N 8
+#endif
+
+#ifndef CHIMERA_L
+#define CHIMERA_L 4
+#endif
+
+template <typename T = uint64_t, std::size_t depth = 18,
+	unsigned M = CHIMERA_M, unsigned N = CHIMERA_N, unsigned L = CHIMERA_L>
+class Algorithm {
+public:
+	typedef T word_type;
+	typedef int value_type;
+	typedef unsigned index_type;
+
+	static const unsigned MAXNB = 6;
+
+	static_assert(L + 2 <= MAXNB, "unit cells with more than 4 qubits per side are not supported");
+
+	static const std::size_t cell_size = 2 * L;
+	static const std::size_t row_size = cell_size * N;
+	static const std::size_t nqubits = row_size * M;
+
+	typedef Lattice<value_type, index_type> lattice_type;
+
+	struct site_type {
+		word_type jzw[MAXNB];
+		value_type hzv;
+		value_type jzv[MAXNB];
+		index_type nneighbs;
+		index_type neighbs[MAXNB];
+	};
+
+	struct sched_type {
+		unsigned r6;
+		unsigned r4;
+		unsigned r2;
+		unsigned r5;
+		unsigned r3;
+		unsigned r1;
+	};
+
+	typedef typename word_traits<word_type>::rand_type rand_type;
+
+	static const std::size_t word_size = 8 * sizeof(word_type);
+	static const std::size_t rand_bits = 8 * sizeof(rand_type);
+	static const std::size_t rand_size = std::size_t(1) << depth;
+
+	typedef bitgen_lincon<rand_type> bgen_type;
+
+	Algorithm() {}
+
+	template <typename SE>
+	Algorithm(const lattice_type& lattice, const std::vector<SE>& sched0)
+	{
+		std::shared_ptr<model_type> m = std::make_shared<model_type>();
+		aligned_vector<site_type>& sites = m->sites;
+		std::vector<index_type>& qubits = m->qubits;
+		std::vector<index_type>& site_index = m->site_index;
+		std::vector<index_type>& cell_begin = m->cell_begin;
+		std::vector<unsigned char>& kinds = m->kinds;
+		aligned_vector<word_type>& cell_jzw = m->cell_jzw;
+		std::vector<sched_type>& sched = m->sched;
+
+		std::vector<site_type> sites0;
+		lattice.init_sites(sites0, MAXNB);
+
+		// sites by qubit label
+
+		const std::vector<index_type>& labels = lattice.get_labels();
+		m->lattice_qubits = labels;
+
+		site_index.assign(nqubits, index_type(-1));
+		for (std::size_t i = 0; i < sites0.size(); ++i) {
+			if (labels[i] >= nqubits)
+				throw std::runtime_error("qubit " + to_s(labels[i])
+					+ " is not in a Chimera graph of " + to_s(M) + "x"
+					+ to_s(N) + " unit cells with " + to_s(2 * L) + " qubits");
+			site_index[labels[i]] = 0;
+		}
+
+		cell_begin.assign(M * N + 1, 0);
+		for (std::size_t q = 0; q < nqubits; ++q) {
+			if (site_index[q] != index_type(-1)) {
+				site_index[q] = qubits.size();
+				qubits.push_back(q);
+			}
+			cell_begin[q / cell_size + 1] = qubits.size();
+		}
+
+		sites.resize(qubits.size());
+		for (std::size_t i = 0; i < sites0.size(); ++i) {
+			site_type& site = sites[site_index[labels[i]]];
+			site = sites0[i];
+
+			if (!check_number_of_neighbors(site.nneighbs))
+				throw std::runtime_error(to_s(site.nneighbs) +
+					" neighbors is not defined in ms_config.h");
+
+			for (std::size_t l = 0; l < site.nneighbs; ++l) {
+				site.neighbs[l] = labels[site.neighbs[l]];
+				site.jzw[l] = site.jzv[l] == 1 ? word_type(-1) : 0;
+			}
+		}
+
+		// a complete cell has all qubits and every qubit all couplings;
+		// their couplings are stored in the order they are used, that is
+		// the other side of the cell first, then the cell above or left
+		// and the cell below or right
+
+		for (std::size_t i = 0; i < sites.size(); ++i) {
+			const site_type& site = sites[i];
+			const std::size_t q = qubits[i];
+
+			for (std::size_t l = 0; l < site.nneighbs; ++l) {
+				const std::size_t j = site.neighbs[l];
+				bool same_row = q / row_size == j / row_size;
+				bool intra = q / cell_size == j / cell_size && (q % cell_size < L) != (j % cell_size < L);
+				bool vertical = q % cell_size < L && (j == q + row_size || j + row_size == q);
+				bool horizontal = q % cell_size >= L && same_row && (j == q + cell_size || j + cell_size == q);
+
+				if (!intra && !vertical && !horizontal)
+					throw std::runtime_error("coupling between qubits " + to_s(q)
+						+ " and " + to_s(j) + " is not a Chimera coupling");
+			}
+		}
+
+		kinds.assign(M * N, incomplete);
+		cell_jzw.resize(M * N * cell_size * MAXNB);
+
+		for (std::size_t c = 0; c < M * N; ++c) {
+			const bool up = c / N > 0, down = c / N + 1 < M;
+			const bool left = c % N > 0, right = c % N + 1 < N;
+
+			for (std::size_t q = c * cell_size; q < (c + 1) * cell_size; ++q) {
+				const bool side0 = q % cell_size < L;
+				const std::size_t nb = L + (side0 ? up + down : left + right);
+
+				if (site_index[q] == index_type(-1) || sites[site_index[q]].nneighbs != nb)
+					break;
+
+				const site_type& site = sites[site_index[q]];
+				word_type* jzw = &cell_jzw[q * MAXNB];
+				const std::size_t stride = side0 ? row_size : cell_size;
+				for (std::size_t l = 0; l < site.nneighbs; ++l) {
+					const std::size_t j = site.neighbs[l];
+					std::size_t slot;
+					if (j + stride == q)
+						slot = L;
+					else if (j == q + stride)
+						slot = L + (side0 ? up : left);
+					else
+						slot = j % L;
+
+					jzw[slot] = site.jzw[l];
+				}
+
+				if (q + 1 == (c + 1) * cell_size)
+					kinds[c] = 8 * up + 4 * down + 2 * left + right;
+			}
+		}
+
+		sched.resize(sched0.size());
+		for (std::size_t sweep = 0; sweep < sched0.size(); ++sweep) {
+			double p = std::exp(-2 * sched0[sweep].beta);
+			double p0 = p;
+			sched[sweep].r1 = rand_size * p;
+			p *= p0;
+			sched[sweep].r2 = rand_size * p;
+			p *= p0;
+			sched[sweep].r3 = rand_size * p;
+			p *= p0;
+			sched[sweep].r4 = rand_size * p;
+			p *= p0;
+			sched[sweep].r5 = rand_size * p;
+			p *= p0;
+			sched[sweep].r6 = rand_size * p;
+		}
+
+		m->terms.add_sites(sites, [&](std::size_t i) { return qubits[i]; });
+
+		model = m;
+		spins.resize(nqubits);
+	}
+
+	void reset_sites(std::size_t rep)
+	{
+		rgen.seed(rep + 1);
+		bgen.seed(rep + 1);
+
+		const std::vector<index_type>& qubits = model->qubits;
+
+		// startconf
+		for (std::size_t i = 0; i < qubits.size(); ++i)
+			spins[qubits[i]] = random_word(rgen, spins[qubits[i]]);
+
+		best.reset();
+	}
+
+	void do_sweep(std::size_t sweep)
+	{
+		const std::vector<unsigned char>& kinds = model->kinds;
+		const sched_type& s = model->sched[sweep];
+
+		for (std::size_t c = 0; c < M * N; ++c)
+			switch (kinds[c]) {
+			case 0: update_complete_cell<false, false, false, false>(c, s); break;
+			case 1: update_complete_cell<false, false, false, true>(c, s); break;
+			case 2: update_complete_cell<false, false, true, false>(c, s); break;
+			case 3: update_complete_cell<false, false, true, true>(c, s); break;
+			case 4: update_complete_cell<false, true, false, false>(c, s); break;
+			case 5: update_complete_cell<false, true, false, true>(c, s); break;
+			case 6: update_complete_cell<false, true, true, false>(c, s); break;
+			case 7: update_complete_cell<false, true, true, true>(c, s); break;
+			case 8: update_complete_cell<true, false, false, false>(c, s); break;
+			case 9: update_complete_cell<true, false, false, true>(c, s); break;
+			case 10: update_complete_cell<true, false, true, false>(c, s); break;
+			case 11: update_complete_cell<true, false, true, true>(c, s); break;
+			case 12: update_complete_cell<true, true, false, false>(c, s); break;
+			case 13: update_complete_cell<true, true, false, true>(c, s); break;
+			case 14: update_complete_cell<true, true, true, false>(c, s); break;
+			case 15: update_complete_cell<true, true, true, true>(c, s); break;
+			default: update_incomplete_cell(c, s);
+			}
+	}
+
+	std::size_t get_energies(std::vector<value_type>& en, std::size_t offs) const
+	{
+		calc_energies(en, offs);
+		return offs + word_size;
+	}
+
+	std::string get_info() const
+	{
+		std::size_t ncomplete = 0;
+		for (std::size_t c = 0; c < M * N; ++c)
+			ncomplete += model->kinds[c] != incomplete;
+
+		return "algorithm: multi-spin, range-1 couplings, without fields, chimera "
+			+ to_s(M) + "x" + to_s(N) + "x" + to_s(L) + ", "
+			+ to_s(ncomplete) + " complete unit cells";
+	}
+
+	// swaps the replicas in the given lanes with those of another instance
+	void exchange_lanes(Algorithm& other, const std::vector<char>& lanes)
+	{
+		word_type mask = lanes_to_word<word_type>(lanes);
+		for (std::size_t q = 0; q < nqubits; ++q) {
+			word_type t = (spins[q] ^ other.spins[q]) & mask;
+			spins[q] ^= t;
+			other.spins[q] ^= t;
+		}
+	}
+
+	// copies the replicas in the given lanes from another instance
+	void copy_lanes(const Algorithm& src, const std::vector<char>& lanes)
+	{
+		word_type mask = lanes_to_word<word_type>(lanes);
+		for (std::size_t q = 0; q < nqubits; ++q)
+			spins[q] ^= (spins[q] ^ src.spins[q]) & mask;
+	}
+
+	// spins of the replica in lane k in the order of the sites of the
+	// lattice, 1 for up
+	void get_spins(std::size_t k, std::vector<char>& s) const
+	{
+		const std::vector<index_type>& lattice_qubits = model->lattice_qubits;
+
+		s.resize(lattice_qubits.size());
+		for (std::size_t i = 0; i < lattice_qubits.size(); ++i)
+			s[i] = word_bit(spins[lattice_qubits[i]], k);
+	}
+
+	// tells whether the energy of one of the lanes is at most e; the
+	// unsatisfied couplings of all lanes are counted at once
+	bool reached_energy(double e)
+	{
+		model->terms.count(&spins[0], counts);
+		return word_any(model->terms.at_most(counts, e));
+	}
+
+	// keeps the spins of every lane whose energy is lower than any it
+	// had at a call before
+	void update_best()
+	{
+		model->terms.count(&spins[0], counts);
+		best.update(counts, &spins[0], spins.size());
+	}
+
+	// puts back the lowest energy state of every lane kept by update_best
+	void restore_best()
+	{
+		spins = best.get_spins();
+	}
+private:
+	// kind of a complete cell: 8 up + 4 down + 2 left + right, where up
+	// etc. tell whether the neighboring cell exists
+	enum { incomplete = 16 };
+
+	// the graph, couplings and thresholds are shared by all copies of
+	// an instance
+	struct model_type {
+		aligned_vector<site_type> sites;
+		std::vector<index_type> qubits;
+		std::vector<index_type> site_index;
+		std::vector<index_type> lattice_qubits;
+		std::vector<index_type> cell_begin;
+		std::vector<unsigned char> kinds;
+		aligned_vector<word_type> cell_jzw;
+		std::vector<sched_type> sched;
+		lane_energies<word_type> terms;
+	};
+
+	std::shared_ptr<const model_type> model;
+
+	aligned_vector<word_type> spins;
+	aligned_vector<word_type> counts;
+	lane_best<word_type> best;
+
+	std::mt19937 rgen;
+	bgen_type bgen;
+
+	// flip mask of a site with NL neighbors, where l[i] is set if the
+	// coupling to neighbor i is not satisfied
+	template <unsigned NL>
+	static word_type flip_mask(const word_type* l, unsigned r, const sched_type& sched)
+	{
+		switch (NL) {
+		case 1:
+			return r >= sched.r1 ? l[0] : word_type(-1);
+		case 2:
+			return r >= sched.r2 ? (l[0] ^ l[1]) | (l[0] & l[1]) : word_type(-1);
+		case 3: {
+			word_type j1 = l[0] ^ l[1];
+			word_type j0 = j1 ^ l[2];
+			j1 = (l[0] & l[1]) ^ (j1 & l[2]);
+
+			if (r >= sched.r1) return j1;
+			if (r >= sched.r3) return j1 | j0;
+			return word_type(-1);
+		}
+		case 4: {
+			word_type j0 = l[0] ^ l[1];
+			word_type j1 = l[0] & l[1];
+			word_type j2 = l[2] ^ l[3];
+			word_type j3 = l[2] & l[3];
+
+			if (r >= sched.r2) return j1 | j3 | (j0 & j2);
+			if (r >= sched.r4) return j1 | j3 | j0 | j2;
+			return word_type(-1);
+		}
+		case 5: {
+			word_type j1 = l[0] ^ l[1];
+			word_type j0 = j1 ^ l[2];
+			j1 = (l[0] & l[1]) ^ (j1 & l[2]);
+
+			word_type j2 = l[3] ^ l[4];
+			word_type j3 = l[3] & l[4];
+
+			if (r >= sched.r1) return ((j1 | j3) & (j0 | j2)) | (j1 & j3);
+			if (r >= sched.r3) return (j0 & j2) | j1 | j3;
+			if (r >= sched.r5) return j0 | j2 | j1 | j3;
+			return word_type(-1);
+		}
+		default: {
+			word_type j1 = l[0] ^ l[1];
+			word_type j0 = j1 ^ l[2];
+			j1 = (l[0] & l[1]) ^ (j1 & l[2]);
+
+			word_type j3 = l[3] ^ l[4];
+			word_type j2 = j3 ^ l[5];
+			j3 = (l[3] & l[4]) ^ (j3 & l[5]);
+
+			if (r >= sched.r2) return ((j1 | j3) & (j0 | j2)) | (j1 & j3);
+			if (r >= sched.r4) return (j0 & j2) | j1 | j3;
+			if (r >= sched.r6) return j0 | j2 | j1 | j3;
+			return word_type(-1);
+		}
+		}
+	}
+
+	// update of a complete cell; UP, DOWN, LEFT and RIGHT tell which
+	// neighboring cells exist, so the number of neighbors of every
+	// qubit is known at compile time
+	template <bool UP, bool DOWN, bool LEFT, bool RIGHT>
+	void update_complete_cell(std::size_t c, const sched_type& sched)
+	{
+		word_type* s = &spins[c * cell_size];
+		const word_type* jzw = &model->cell_jzw[c * cell_size * MAXNB];
+		word_type l[MAXNB];
+
+		for (std::size_t k = 0; k < L; ++k, jzw += MAXNB) {
+			unsigned r = bgen() >> (rand_bits - depth);
+			word_type spin = s[k];
+
+			for (std::size_t k1 = 0; k1 < L; ++k1)
+				l[k1] = jzw[k1] ^ (spin ^ s[L + k1]);
+			if (UP)
+				l[L] = jzw[L] ^ (spin ^ (s - row_size)[k]);
+			if (DOWN)
+				l[L + UP] = jzw[L + UP] ^ (spin ^ s[row_size + k]);
+
+			s[k] = spin ^ flip_mask<L + UP + DOWN>(l, r, sched);
+		}
+
+		for (std::size_t k = 0; k < L; ++k, jzw += MAXNB) {
+			unsigned r = bgen() >> (rand_bits - depth);
+			word_type spin = s[L + k];
+
+			for (std::size_t k0 = 0; k0 < L; ++k0)
+				l[k0] = jzw[k0] ^ (spin ^ s[k0]);
+			if (LEFT)
+				l[L] = jzw[L] ^ (spin ^ (s - cell_size)[L + k]);
+			if (RIGHT)
+				l[L + LEFT] = jzw[L + LEFT] ^ (spin ^ s[cell_size + L + k]);
+
+			s[L + k] = spin ^ flip_mask<L + LEFT + RIGHT>(l, r, sched);
+		}
+	}
+
+	// update of a site with NL neighbors from its neighbor list
+	template <unsigned NL>
+	void update_site(std::size_t i, const sched_type& sched)
+	{
+		const site_type& site = model->sites[i];
+		const index_type q = model->qubits[i];
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[q];
+		word_type l[MAXNB];
+
+		for (std::size_t k = 0; k < NL; ++k)
+			l[k] = site.jzw[k] ^ (spin ^ spins[site.neighbs[k]]);
+
+		spins[q] = spin ^ flip_mask<NL>(l, r, sched);
+	}
+
+	// update of the qubits of an incomplete cell
+	void update_incomplete_cell(std::size_t c, const sched_type& sched)
+	{
+		const std::vector<index_type>& cell_begin = model->cell_begin;
+
+		for (std::size_t i = cell_begin[c]; i < cell_begin[c + 1]; ++i)
+			switch (model->sites[i].nneighbs) {
+			case 1: update_site<1>(i, sched); break;
+			case 2: update_site<2>(i, sched); break;
+			case 3: update_site<3>(i, sched); break;
+			case 4: update_site<4>(i, sched); break;
+			case 5: update_site<5>(i, sched); break;
+			case 6: update_site<6>(i, sched); break;
+			}
+	}
+
+	void calc_energies(std::vector<value_type>& en, std::size_t offs) const
+	{
+		const aligned_vector<site_type>& sites = model->sites;
+		const std::vector<index_type>& qubits = model->qubits;
+
+		for (unsigned k = 0; k < word_size; ++k) {
+			for (std::size_t i = 0; i < sites.size(); ++i) {
+				const site_type& site = sites[i];
+				const std::size_t q = qubits[i];
+
+				int spin = 2 * int(word_bit(spins[q], k)) - 1;
+
+				value_type h = 0;
+				for (std::size_t l = 0; l < site.nneighbs; ++l) {
+					std::size_t j = site.neighbs[l];
+					if (q > j) continue;
+
+					int nspin = 2 * int(word_bit(spins[j], k)) - 1;
+					h += site.jzv[l] * nspin;
+				}
+
+				en[offs + k] += h * spin;
+			}
+		}
+	}
+};
+
+#endif
@@ -0,0 +1,384 @@
+/******************************************************************************
+
+Simulated annealing codes
+v1.0
+
+---------------------------------------------------------------------
+
+Implementation of multi-spin simulated quantum annealing (path-integral
+Monte Carlo) for Ising spin glasses with range-1 couplings without
+fields in a transverse field. Each site has TROTTER_SLICES copies
+along imaginary time; every bit of a word is an independent replica.
+
+---------------------------------------------------------------------
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*******************************************************************************/
+
+#ifndef __ALGORITHM_H__
+#define __ALGORITHM_H__
+
+#include <cmath>
+#include <random>
+#include <vector>
+#include <memory>
+#include <string>
+#include <algorithm>
+
+#include "bits.h"
+#include "lattice.h"
+#include "utils.h"
+#include "words.h"
+
+#define MULTI_SPIN
+#define LANE_EXCHANGE
+#define TRANSVERSE_FIELD
+
+#ifndef TROTTER_SLICES
+#	define TROTTER_SLICES 32
+#endif
+
+// The action of P Trotter slices s(0), ..., s(P-1) is
+//   beta/P sum_t E(s(t)) - J sum_t sum_i s_i(t) s_i(t+1),
+// with J = -1/2 ln tanh(beta gamma / P) and periodic boundary
+// conditions in imaginary time. The change of the action due to a flip
+// of a spin with d neighbors, u unsatisfied couplings in space and v
+// unsatisfied couplings in imaginary time is
+//   2 beta/P (d - 2u) + 4 J (1 - v).
+// The slices of a replica are updated one after another, so only the
+// replicas in different bits share random numbers.
+
+template <typename T = uint64_t, std::size_t depth = 18,
+	std::size_t P = TROTTER_SLICES>
+class Algorithm {
+public:
+	typedef T word_type;
+	typedef int value_type;
+	typedef unsigned index_type;
+
+	static const unsigned MAXNB = 6;
+
+	static_assert(P >= 2, "at least two Trotter slices are required");
+
+	typedef Lattice<value_type, index_type> lattice_type;
+
+	struct site_type {
+		word_type jzw[MAXNB];
+		value_type hzv;
+		value_type jzv[MAXNB];
+		index_type nneighbs;
+		index_type neighbs[MAXNB];
+	};
+
+	// r[d][v][u] is the threshold of a site with d neighbors, u unsatisfied
+	// couplings in space and v unsatisfied couplings in imaginary time
+	struct sched_type {
+		unsigned r[MAXNB + 1][3][MAXNB + 1];
+	};
+
+	// couplings and thresholds are shared by all copies of an instance
+	struct model_type {
+		aligned_vector<site_type> sites;
+		std::vector<sched_type> sched;
+		lane_energies<word_type> terms;
+	};
+
+	typedef typename word_traits<word_type>::rand_type rand_type;
+
+	static const std::size_t word_size = 8 * sizeof(word_type);
+	static const std::size_t rand_bits = 8 * sizeof(rand_type);
+	static const std::size_t rand_size = std::size_t(1) << depth;
+
+	typedef bitgen_lincon<rand_type> bgen_type;
+
+	Algorithm() {}
+
+	template <typename SE>
+	Algorithm(const lattice_type& lattice, const std::vector<SE>& sched0)
+	{
+		std::shared_ptr<model_type> m = std::make_shared<model_type>();
+		aligned_vector<site_type>& sites = m->sites;
+		std::vector<sched_type>& sched = m->sched;
+
+		lattice.init_sites(sites, MAXNB);
+
+		for (std::size_t i = 0; i < sites.size(); ++i) {
+			site_type& site = sites[i];
+			for (std::size_t l = 0; l < site.nneighbs; ++l)
+				site.jzw[l] = site.jzv[l] == 1 ? word_type(-1) : 0;
+		}
+
+		sched.resize(sched0.size());
+		for (std::size_t sweep = 0; sweep < sched0.size(); ++sweep) {
+			double beta = sched0[sweep].beta;
+			double jt = -0.5 * std::log(std::tanh(beta * sched0[sweep].gamma / P));
+
+			for (int d = 0; d <= int(MAXNB); ++d)
+				for (int v = 0; v < 3; ++v)
+					for (int u = 0; u <= int(MAXNB); ++u) {
+						// jt is infinite if gamma is zero
+						double ds = 2 * beta / P * (d - 2 * u);
+						if (v != 1) ds += 4 * jt * (1 - v);
+						sched[sweep].r[d][v][u] =
+							ds <= 0 ? unsigned(rand_size) : unsigned(rand_size * std::exp(-ds));
+					}
+		}
+
+		m->terms.add_sites(sites);
+
+		model = m;
+		spins.resize(P * sites.size());
+	}
+
+	void reset_sites(std::size_t rep)
+	{
+		rgen.seed(rep + 1);
+		bgen.seed(rep + 1);
+
+		// startconf
+		for (std::size_t i = 0; i < spins.size(); ++i)
+			spins[i] = random_word(rgen, spins[i]);
+
+		best.reset();
+	}
+
+	void do_sweep(std::size_t sweep)
+	{
+		for (std::size_t t = 0; t < P; ++t)
+			update_slice(t, model->sched[sweep]);
+	}
+
+	// the energy of a replica is the lowest classical energy of its slices
+	std::size_t get_energies(std::vector<value_type>& en, std::size_t offs) const
+	{
+		calc_energies(en, offs);
+		return offs + word_size;
+	}
+
+	std::string get_info() const
+	{
+		return "algorithm: simulated quantum annealing, multi-spin, range-1 couplings, without fields, "
+			+ to_s(P) + " Trotter slices";
+	}
+
+	// swaps the replicas in the given lanes with those of another instance
+	void exchange_lanes(Algorithm& other, const std::vector<char>& lanes)
+	{
+		word_type mask = lanes_to_word<word_type>(lanes);
+		for (std::size_t i = 0; i < spins.size(); ++i) {
+			word_type t = (spins[i] ^ other.spins[i]) & mask;
+			spins[i] ^= t;
+			other.spins[i] ^= t;
+		}
+	}
+
+	// copies the replicas in the given lanes from another instance
+	void copy_lanes(const Algorithm& src, const std::vector<char>& lanes)
+	{
+		word_type mask = lanes_to_word<word_type>(lanes);
+		for (std::size_t i = 0; i < spins.size(); ++i)
+			spins[i] ^= (spins[i] ^ src.spins[i]) & mask;
+	}
+
+	// spins of the replica in lane k in the order of the sites, 1 for up;
+	// these are the spins of its slice with the lowest classical energy
+	void get_spins(std::size_t k, std::vector<char>& s) const
+	{
+		const std::size_t n = model->sites.size();
+
+		std::size_t tmin = 0;
+		value_type emin = 0;
+		for (std::size_t t = 0; t < P; ++t) {
+			value_type e = slice_energy(t, k);
+			if (t == 0 || e < emin) {
+				emin = e;
+				tmin = t;
+			}
+		}
+
+		s.resize(n);
+		for (std::size_t i = 0; i < n; ++i)
+			s[i] = word_bit(spins[tmin * n + i], k);
+	}
+
+	// tells whether the lowest classical energy of the slices of one of
+	// the lanes is at most e; the unsatisfied couplings of all lanes are
+	// counted at once
+	bool reached_energy(double e)
+	{
+		const std::size_t n = model->sites.size();
+
+		word_type lanes = word_type(0);
+		for (std::size_t t = 0; t < P; ++t) {
+			model->terms.count(&spins[t * n], counts);
+			lanes |= model->terms.at_most(counts, e);
+		}
+
+		return word_any(lanes);
+	}
+
+	// keeps the spins of every lane whose lowest classical energy among
+	// the slices is lower than any it had at a call before
+	void update_best()
+	{
+		const std::size_t n = model->sites.size();
+
+		for (std::size_t t = 0; t < P; ++t) {
+			model->terms.count(&spins[t * n], counts);
+			best.update(counts, &spins[t * n], n);
+		}
+	}
+
+	// puts the lowest energy state of every lane kept by update_best
+	// back into all slices
+	void restore_best()
+	{
+		const std::size_t n = model->sites.size();
+		const aligned_vector<word_type>& s = best.get_spins();
+
+		for (std::size_t t = 0; t < P; ++t)
+			std::copy(s.begin(), s.end(), spins.begin() + t * n);
+	}
+private:
+	std::shared_ptr<const model_type> model;
+
+	// spins[t * nsites + i] is site i in slice t
+	aligned_vector<word_type> spins;
+	aligned_vector<word_type> counts;
+	lane_best<word_type> best;
+
+	std::mt19937 rgen;
+	bgen_type bgen;
+
+	// bits of the replicas with at least k unsatisfied couplings;
+	// c0, c1, c2 are the bits of the number of unsatisfied couplings
+	static word_type at_least(word_type c0, word_type c1, word_type c2, unsigned k)
+	{
+		switch (k) {
+		case 0:
+			return word_type(-1);
+		case 1:
+			return c0 | c1 | c2;
+		case 2:
+			return c1 | c2;
+		case 3:
+			return c2 | (c1 & c0);
+		case 4:
+			return c2;
+		case 5:
+			return c2 & (c1 | c0);
+		case 6:
+			return c2 & c1;
+		case 7:
+			return c2 & c1 & c0;
+		default:
+			return 0;
+		}
+	}
+
+	// the smallest number of unsatisfied couplings in space for which
+	// the flip is accepted; the thresholds grow with u
+	static unsigned min_unsat(const unsigned* rv, unsigned d, unsigned r)
+	{
+		unsigned u = 0;
+		for (unsigned k = 0; k <= d; ++k)
+			u += r >= rv[k];
+		return u;
+	}
+
+	void update_slice(std::size_t t, const sched_type& sched)
+	{
+		const aligned_vector<site_type>& sites = model->sites;
+		const std::size_t n = sites.size();
+
+		word_type* s = &spins[t * n];
+		const word_type* sp = &spins[(t + P - 1) % P * n];
+		const word_type* sn = &spins[(t + 1) % P * n];
+
+		for (std::size_t i = 0; i < n; ++i) {
+			const site_type& site = sites[i];
+
+			unsigned r = bgen() >> (rand_bits - depth);
+			word_type spin = s[i];
+
+			// number of unsatisfied couplings in space
+			word_type c0 = 0, c1 = 0, c2 = 0;
+			for (std::size_t l = 0; l < site.nneighbs; ++l) {
+				word_type x = site.jzw[l] ^ (spin ^ s[site.neighbs[l]]);
+				word_type carry = c0 & x;
+				c0 ^= x;
+				c2 |= c1 & carry;
+				c1 ^= carry;
+			}
+
+			// unsatisfied couplings in imaginary time
+			word_type a = spin ^ sp[i];
+			word_type b = spin ^ sn[i];
+
+			const unsigned (*rv)[MAXNB + 1] = sched.r[site.nneighbs];
+
+			word_type mask =
+				(~(a | b) & at_least(c0, c1, c2, min_unsat(rv[0], site.nneighbs, r)))
+				| ((a ^ b) & at_least(c0, c1, c2, min_unsat(rv[1], site.nneighbs, r)))
+				| ((a & b) & at_least(c0, c1, c2, min_unsat(rv[2], site.nneighbs, r)));
+
+			s[i] = spin ^ mask;
+		}
+	}
+
+	// classical energy of lane k of slice t
+	value_type slice_energy(std::size_t t, unsigned k) const
+	{
+		const aligned_vector<site_type>& sites = model->sites;
+		const std::size_t n = sites.size();
+		const word_type* s = &spins[t * n];
+
+		value_type e = 0;
+		for (std::size_t i = 0; i < n; ++i) {
+			const site_type& site = sites[i];
+
+			int spin = 2 * int(word_bit(s[i], k)) - 1;
+
+			value_type h = 0;
+			for (std::size_t l = 0; l < site.nneighbs; ++l) {
+				std::size_t j = site.neighbs[l];
+				if (i > j) continue;
+
+				int nspin = 2 * int(word_bit(s[j], k)) - 1;
+				h += site.jzv[l] * nspin;
+			}
+
+			e += h * spin;
+		}
+
+		return e;
+	}
+
+	void calc_energies(std::vector<value_type>& en, std::size_t offs) const
+	{
+		for (unsigned k = 0; k < word_size; ++k) {
+			value_type emin = 0;
+
+			for (std::size_t t = 0; t < P; ++t) {
+				value_type e = slice_energy(t, k);
+				if (t == 0 || e < emin) emin = e;
+			}
+
+			en[offs + k] += emin;
+		}
+	}
+};
+
+#endif
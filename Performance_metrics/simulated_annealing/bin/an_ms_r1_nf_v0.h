@@ -34,13 +34,15 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <cmath>
 #include <random>
 #include <vector>
+#include <memory>
 #include <string>
 
 #include "bits.h"
 #include "lattice.h"
 #include "utils.h"
+#include "words.h"
 
-#define OMP_VERSION_2
+#define LANE_EXCHANGE
 
 template <typename T = uint64_t>
 class Algorithm {
@@ -54,7 +56,6 @@ public:
 	typedef Lattice<value_type, index_type> lattice_type;
 
 	struct site_type {
-		word_type spin;
 		word_type hzw;
 		word_type jzw[MAXNB];
 		value_type hzv;
@@ -74,6 +75,10 @@ public:
 	template <typename SE>
 	Algorithm(const lattice_type& lattice, const std::vector<SE>& sched0)
 	{
+		std::shared_ptr<model_type> m = std::make_shared<model_type>();
+		aligned_vector<site_type>& sites = m->sites;
+		std::vector<std::vector<sched_type> >& sched = m->sched;
+
 		lattice.init_sites(sites, MAXNB);
 
 		maxnb = 0;
@@ -142,6 +147,11 @@ public:
 			for (std::size_t i = 0; i < word_size; ++i)
 				sched[sweep][0].r0[i] = p2mask(pch, i);
 		}
+
+		m->terms.add_sites(sites);
+
+		model = m;
+		spins.resize(sites.size());
 	}
 
 	void reset_sites(std::size_t rep)
@@ -150,21 +160,26 @@ public:
 		bgen.seed(rep + 1);
 
 		// startconf
-		for (std::size_t i = 0; i < sites.size(); ++i)
-			sites[i].spin = random_word(rgen, sites[i].spin);
+		for (std::size_t i = 0; i < spins.size(); ++i)
+			spins[i] = random_word(rgen, spins[i]);
+
+		best.reset();
 	}
 
 	void do_sweep(size_t sweep)
 	{
+		const aligned_vector<site_type>& sites = model->sites;
+		const std::vector<std::vector<sched_type> >& sched = model->sched;
+
 		if (maxnb <= 4)
 			for (std::size_t i = 0; i < sites.size(); ++i) {
-				site_type& site = sites[i];
-				update_site4(site, sched[sweep]);
+				const site_type& site = sites[i];
+				update_site4(i, site, sched[sweep]);
 			}
 		else
 			for (std::size_t i = 0; i < sites.size(); ++i) {
-				site_type& site = sites[i];
-				update_site6(site, sched[sweep]);
+				const site_type& site = sites[i];
+				update_site6(i, site, sched[sweep]);
 			}
 	}
 
@@ -178,9 +193,56 @@ public:
 	{
 		return "algorithm: multi-spin, range-1 couplings, without fields, vesion 0";
 	}
-private:
-	std::vector<site_type> sites;
 
+	// swaps the replicas in the given lanes with those of another instance
+	void exchange_lanes(Algorithm& other, const std::vector<char>& lanes)
+	{
+		word_type mask = lanes_to_word<word_type>(lanes);
+		for (std::size_t i = 0; i < spins.size(); ++i) {
+			word_type t = (spins[i] ^ other.spins[i]) & mask;
+			spins[i] ^= t;
+			other.spins[i] ^= t;
+		}
+	}
+
+	// copies the replicas in the given lanes from another instance
+	void copy_lanes(const Algorithm& src, const std::vector<char>& lanes)
+	{
+		word_type mask = lanes_to_word<word_type>(lanes);
+		for (std::size_t i = 0; i < spins.size(); ++i)
+			spins[i] ^= (spins[i] ^ src.spins[i]) & mask;
+	}
+
+	// spins of the replica in lane k in the order of the sites, 1 for up
+	void get_spins(std::size_t k, std::vector<char>& s) const
+	{
+		s.resize(spins.size());
+		for (std::size_t i = 0; i < spins.size(); ++i)
+			s[i] = (spins[i] >> k) & 1;
+	}
+
+	// tells whether the energy of one of the lanes is at most e; the
+	// unsatisfied couplings of all lanes are counted at once
+	bool reached_energy(double e)
+	{
+		model->terms.count(&spins[0], counts);
+		return word_any(model->terms.at_most(counts, e));
+	}
+
+	// keeps the spins of every lane whose energy is lower than any it
+	// had at a call before
+	void update_best()
+	{
+		model->terms.count(&spins[0], counts);
+		best.update(counts, &spins[0], spins.size());
+	}
+
+	// puts back the lowest energy state of every lane kept by update_best
+	void restore_best()
+	{
+		spins = best.get_spins();
+	}
+private:
 	std::mt19937 rgen;
 	bgen_type bgen;
 
@@ -192,7 +254,18 @@ private:
 		word_type r2[word_size];
 	};
 
-	std::vector<std::vector<sched_type> > sched;
+	// couplings and thresholds are shared by all copies of an instance
+	struct model_type {
+		aligned_vector<site_type> sites;
+		std::vector<std::vector<sched_type> > sched;
+		lane_energies<word_type> terms;
+	};
+
+	std::shared_ptr<const model_type> model;
+
+	aligned_vector<word_type> spins;
+	aligned_vector<word_type> counts;
+	lane_best<word_type> best;
 
 	word_type p2mask(word_type p, std::size_t i) const
 	{
@@ -225,14 +298,14 @@ private:
 		return r;
 	}
 
-	void update_site4(site_type& site, const std::vector<sched_type>& sched)
+	void update_site4(std::size_t i, const site_type& site, const std::vector<sched_type>& sched)
 	{
-		word_type spin = site.spin;
+		word_type spin = spins[i];
 
-		word_type l0 = site.jzw[0] ^ (spin ^ sites[site.neighbs[0]].spin);
-		word_type l1 = site.jzw[1] ^ (spin ^ sites[site.neighbs[1]].spin);
-		word_type l2 = site.jzw[2] ^ (spin ^ sites[site.neighbs[2]].spin);
-		word_type l3 = site.jzw[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		word_type l0 = site.jzw[0] ^ (spin ^ spins[site.neighbs[0]]);
+		word_type l1 = site.jzw[1] ^ (spin ^ spins[site.neighbs[1]]);
+		word_type l2 = site.jzw[2] ^ (spin ^ spins[site.neighbs[2]]);
+		word_type l3 = site.jzw[3] ^ (spin ^ spins[site.neighbs[3]]);
 
 		word_type t0 = l0 & l1;
 		l1 = l0 | l1;
@@ -251,19 +324,19 @@ private:
 		word_type mask = mask1 | mask2;
 
 		index_type k = site.nneighbs % 2;
-		site.spin = spin ^ (~mask | flippable4(mask, mask1, mask2, sched[k]));
+		spins[i] = spin ^ (~mask | flippable4(mask, mask1, mask2, sched[k]));
 	}
 
-	void update_site6(site_type& site, const std::vector<sched_type>& sched)
+	void update_site6(std::size_t i, const site_type& site, const std::vector<sched_type>& sched)
 	{
-		word_type spin = site.spin;
+		word_type spin = spins[i];
 
-		word_type l0 = site.jzw[0] ^ (spin ^ sites[site.neighbs[0]].spin);
-		word_type l1 = site.jzw[1] ^ (spin ^ sites[site.neighbs[1]].spin);
-		word_type l2 = site.jzw[2] ^ (spin ^ sites[site.neighbs[2]].spin);
-		word_type l3 = site.jzw[3] ^ (spin ^ sites[site.neighbs[3]].spin);
-		word_type l4 = site.jzw[4] ^ (spin ^ sites[site.neighbs[4]].spin);
-		word_type l5 = site.jzw[5] ^ (spin ^ sites[site.neighbs[5]].spin);
+		word_type l0 = site.jzw[0] ^ (spin ^ spins[site.neighbs[0]]);
+		word_type l1 = site.jzw[1] ^ (spin ^ spins[site.neighbs[1]]);
+		word_type l2 = site.jzw[2] ^ (spin ^ spins[site.neighbs[2]]);
+		word_type l3 = site.jzw[3] ^ (spin ^ spins[site.neighbs[3]]);
+		word_type l4 = site.jzw[4] ^ (spin ^ spins[site.neighbs[4]]);
+		word_type l5 = site.jzw[5] ^ (spin ^ spins[site.neighbs[5]]);
 
 		word_type t0 = l0 & l1;
 		l1 = l0 | l1;
@@ -300,23 +373,25 @@ private:
 		word_type mask = mask0 | mask1 | mask2;
 
 		index_type k = site.nneighbs % 2;
-		site.spin = spin ^ (~mask | flippable6(mask, mask0, mask1, mask2, sched[k]));
+		spins[i] = spin ^ (~mask | flippable6(mask, mask0, mask1, mask2, sched[k]));
 	}
 
 	void calc_energies(std::vector<value_type>& en, std::size_t offs) const
 	{
+		const aligned_vector<site_type>& sites = model->sites;
+
 		for (unsigned k = 0; k < word_size; ++k)
 			for (std::size_t i = 0; i < sites.size(); ++i) {
 				const site_type& site = sites[i];
 
-				int spin = 2 * int((site.spin >> k) & 1) - 1;
+				int spin = 2 * int((spins[i] >> k) & 1) - 1;
 
 				value_type h = 0;
 				for (std::size_t l = 0; l < site.nneighbs; ++l) {
 					std::size_t j = site.neighbs[l];
 					if (i > j) continue;
 
-					int nspin = 2 * int((sites[j].spin >> k) & 1) - 1;
+					int nspin = 2 * int((spins[j] >> k) & 1) - 1;
 					h += site.jzv[l] * nspin;
 				}
 
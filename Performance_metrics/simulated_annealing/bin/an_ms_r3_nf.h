@@ -34,12 +34,17 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <cmath>
 #include <random>
 #include <vector>
+#include <memory>
 #include <string>
 
 #include "bits.h"
 #include "lattice.h"
 #include "ms_config.h"
 #include "utils.h"
+#include "words.h"
+
+#define MULTI_SPIN
+#define LANE_EXCHANGE
 
 template <typename T = uint64_t, std::size_t depth = 18>
 class Algorithm {
@@ -53,7 +58,6 @@ public:
 	typedef Lattice<value_type, index_type> lattice_type;
 
 	struct site_type {
-		word_type spin;
 		word_type hzw;
 		word_type jzw0[MAXNB];
 		word_type jzw1[MAXNB];
@@ -85,17 +89,31 @@ public:
 		unsigned r18;
 	};
 
+	// couplings and thresholds are shared by all copies of an instance
+	struct model_type {
+		aligned_vector<site_type> sites;
+		std::vector<sched_type> sched;
+		lane_energies<word_type> terms;
+	};
+
+	typedef typename word_traits<word_type>::rand_type rand_type;
+
 	static const std::size_t word_size = 8 * sizeof(word_type);
+	static const std::size_t rand_bits = 8 * sizeof(rand_type);
 	static const std::size_t rand_size = std::size_t(1) << depth;
 
-	typedef bitgen_lincon<word_type> bgen_type;
-//	typedef bitgen_lagfib<word_type> bgen_type;
+	typedef bitgen_lincon<rand_type> bgen_type;
+//	typedef bitgen_lagfib<rand_type> bgen_type;
 
 	Algorithm() {}
 
 	template <typename SE>
 	Algorithm(const lattice_type& lattice, const std::vector<SE>& sched0)
 	{
+		std::shared_ptr<model_type> m = std::make_shared<model_type>();
+		aligned_vector<site_type>& sites = m->sites;
+		std::vector<sched_type>& sched = m->sched;
+
 		lattice.init_sites(sites, MAXNB);
 
 		for (std::size_t i = 0; i < sites.size(); ++i) {
@@ -167,6 +185,11 @@ public:
 			p *= p0;
 			sched[sweep].r18 = rand_size * p;
 		}
+
+		m->terms.add_sites(sites);
+
+		model = m;
+		spins.resize(sites.size());
 	}
 
 	void reset_sites(std::size_t rep)
@@ -175,429 +198,434 @@ public:
 		bgen.seed(rep + 1);
 
 		// startconf
-		for (std::size_t i = 0; i < sites.size(); ++i)
-			sites[i].spin = random_word(rgen, sites[i].spin);
+		for (std::size_t i = 0; i < spins.size(); ++i)
+			spins[i] = random_word(rgen, spins[i]);
+
+		best.reset();
 	}
 
 	void do_sweep(size_t sweep)
 	{
+		const aligned_vector<site_type>& sites = model->sites;
+		const std::vector<sched_type>& sched = model->sched;
+
 		// machine-generated code; do not edit
 		for (std::size_t i = 0; i < sites.size(); ++i) {
-			site_type& site = sites[i];
+			const site_type& site = sites[i];
 			switch (site.cs) {
 		#ifdef USE_1_NEIGHB
 			case 1000001:
-				update_site1_1(site, sched[sweep]);
+				update_site1_1(i, site, sched[sweep]);
 				break;
 		#endif
 		#ifdef USE_1_NEIGHB
 			case 1000002:
-				update_site1_2(site, sched[sweep]);
+				update_site1_2(i, site, sched[sweep]);
 				break;
 		#endif
 		#ifdef USE_1_NEIGHB
 			case 1000003:
-				update_site1_3(site, sched[sweep]);
+				update_site1_3(i, site, sched[sweep]);
 				break;
 		#endif
 		#ifdef USE_2_NEIGHB
 			case 2000005:
-				update_site2_11(site, sched[sweep]);
+				update_site2_11(i, site, sched[sweep]);
 				break;
 		#endif
 		#ifdef USE_2_NEIGHB
 			case 2000006:
-				update_site2_12(site, sched[sweep]);
+				update_site2_12(i, site, sched[sweep]);
 				break;
 		#endif
 		#ifdef USE_2_NEIGHB
 			case 2000010:
-				update_site2_22(site, sched[sweep]);
+				update_site2_22(i, site, sched[sweep]);
 				break;
 		#endif
 		#ifdef USE_2_NEIGHB
 			case 2000007:
-				update_site2_13(site, sched[sweep]);
+				update_site2_13(i, site, sched[sweep]);
 				break;
 		#endif
 		#ifdef USE_2_NEIGHB
 			case 2000011:
-				update_site2_23(site, sched[sweep]);
+				update_site2_23(i, site, sched[sweep]);
 				break;
 		#endif
 		#ifdef USE_2_NEIGHB
 			case 2000015:
-				update_site2_33(site, sched[sweep]);
+				update_site2_33(i, site, sched[sweep]);
 				break;
 		#endif
 		#ifdef USE_3_NEIGHB
 			case 3000021:
-				update_site3_111(site, sched[sweep]);
+				update_site3_111(i, site, sched[sweep]);
 				break;
 		#endif
 		#ifdef USE_3_NEIGHB
 			case 3000022:
-				update_site3_112(site, sched[sweep]);
+				update_site3_112(i, site, sched[sweep]);
 				break;
 		#endif
 		#ifdef USE_3_NEIGHB
 			case 3000026:
-				update_site3_122(site, sched[sweep]);
+				update_site3_122(i, site, sched[sweep]);
 				break;
 		#endif
 		#ifdef USE_3_NEIGHB
 			case 3000042:
-				update_site3_222(site, sched[sweep]);
+				update_site3_222(i, site, sched[sweep]);
 				break;
 		#endif
 		#ifdef USE_3_NEIGHB
 			case 3000023:
-				update_site3_113(site, sched[sweep]);
+				update_site3_113(i, site, sched[sweep]);
 				break;
 		#endif
 		#ifdef USE_3_NEIGHB
 			case 3000027:
-				update_site3_123(site, sched[sweep]);
+				update_site3_123(i, site, sched[sweep]);
 				break;
 		#endif
 		#ifdef USE_3_NEIGHB
 			case 3000043:
-				update_site3_223(site, sched[sweep]);
+				update_site3_223(i, site, sched[sweep]);
 				break;
 		#endif
 		#ifdef USE_3_NEIGHB
 			case 3000031:
-				update_site3_133(site, sched[sweep]);
+				update_site3_133(i, site, sched[sweep]);
 				break;
 		#endif
 		#ifdef USE_3_NEIGHB
 			case 3000047:
-				update_site3_233(site, sched[sweep]);
+				update_site3_233(i, site, sched[sweep]);
 				break;
 		#endif
 		#ifdef USE_3_NEIGHB
 			case 3000063:
-				update_site3_333(site, sched[sweep]);
+				update_site3_333(i, site, sched[sweep]);
 				break;
 		#endif
 		#ifdef USE_4_NEIGHB
 			case 4000085:
-				update_site4_1111(site, sched[sweep]);
+				update_site4_1111(i, site, sched[sweep]);
 				break;
 		#endif
 		#ifdef USE_4_NEIGHB
 			case 4000086:
-				update_site4_1112(site, sched[sweep]);
+				update_site4_1112(i, site, sched[sweep]);
 				break;
 		#endif
 		#ifdef USE_4_NEIGHB
 			case 4000090:
-				update_site4_1122(site, sched[sweep]);
+				update_site4_1122(i, site, sched[sweep]);
 				break;
 		#endif
 		#ifdef USE_4_NEIGHB
 			case 4000106:
-				update_site4_1222(site, sched[sweep]);
+				update_site4_1222(i, site, sched[sweep]);
 				break;
 		#endif
 		#ifdef USE_4_NEIGHB
 			case 4000170:
-				update_site4_2222(site, sched[sweep]);
+				update_site4_2222(i, site, sched[sweep]);
 				break;
 		#endif
 		#ifdef USE_4_NEIGHB
 			case 4000087:
-				update_site4_1113(site, sched[sweep]);
+				update_site4_1113(i, site, sched[sweep]);
 				break;
 		#endif
 		#ifdef USE_4_NEIGHB
 			case 4000091:
-				update_site4_1123(site, sched[sweep]);
+				update_site4_1123(i, site, sched[sweep]);
 				break;
 		#endif
 		#ifdef USE_4_NEIGHB
 			case 4000107:
-				update_site4_1223(site, sched[sweep]);
+				update_site4_1223(i, site, sched[sweep]);
 				break;
 		#endif
 		#ifdef USE_4_NEIGHB
 			case 4000171:
-				update_site4_2223(site, sched[sweep]);
+				update_site4_2223(i, site, sched[sweep]);
 				break;
 		#endif
 		#ifdef USE_4_NEIGHB
 			case 4000095:
-				update_site4_1133(site, sched[sweep]);
+				update_site4_1133(i, site, sched[sweep]);
 				break;
 		#endif
 		#ifdef USE_4_NEIGHB
 			case 4000111:
-				update_site4_1233(site, sched[sweep]);
+				update_site4_1233(i, site, sched[sweep]);
 				break;
 		#endif
 		#ifdef USE_4_NEIGHB
 			case 4000175:
-				update_site4_2233(site, sched[sweep]);
+				update_site4_2233(i, site, sched[sweep]);
 				break;
 		#endif
 		#ifdef USE_4_NEIGHB
 			case 4000127:
-				update_site4_1333(site, sched[sweep]);
+				update_site4_1333(i, site, sched[sweep]);
 				break;
 		#endif
 		#ifdef USE_4_NEIGHB
 			case 4000191:
-				update_site4_2333(site, sched[sweep]);
+				update_site4_2333(i, site, sched[sweep]);
 				break;
 		#endif
 		#ifdef USE_4_NEIGHB
 			case 4000255:
-				update_site4_3333(site, sched[sweep]);
+				update_site4_3333(i, site, sched[sweep]);
 				break;
 		#endif
 		#ifdef USE_5_NEIGHB
 			case 5000341:
-				update_site5_11111(site, sched[sweep]);
+				update_site5_11111(i, site, sched[sweep]);
 				break;
 		#endif
 		#ifdef USE_5_NEIGHB
 			case 5000342:
-				update_site5_11112(site, sched[sweep]);
+				update_site5_11112(i, site, sched[sweep]);
 				break;
 		#endif
 		#ifdef USE_5_NEIGHB
 			case 5000346:
-				update_site5_11122(site, sched[sweep]);
+				update_site5_11122(i, site, sched[sweep]);
 				break;
 		#endif
 		#ifdef USE_5_NEIGHB
 			case 5000362:
-				update_site5_11222(site, sched[sweep]);
+				update_site5_11222(i, site, sched[sweep]);
 				break;
 		#endif
 		#ifdef USE_5_NEIGHB
 			case 5000426:
-				update_site5_12222(site, sched[sweep]);
+				update_site5_12222(i, site, sched[sweep]);
 				break;
 		#endif
 		#ifdef USE_5_NEIGHB
 			case 5000682:
-				update_site5_22222(site, sched[sweep]);
+				update_site5_22222(i, site, sched[sweep]);
 				break;
 		#endif
 		#ifdef USE_5_NEIGHB
 			case 5000343:
-				update_site5_11113(site, sched[sweep]);
+				update_site5_11113(i, site, sched[sweep]);
 				break;
 		#endif
 		#ifdef USE_5_NEIGHB
 			case 5000347:
-				update_site5_11123(site, sched[sweep]);
+				update_site5_11123(i, site, sched[sweep]);
 				break;
 		#endif
 		#ifdef USE_5_NEIGHB
 			case 5000363:
-				update_site5_11223(site, sched[sweep]);
+				update_site5_11223(i, site, sched[sweep]);
 				break;
 		#endif
 		#ifdef USE_5_NEIGHB
 			case 5000427:
-				update_site5_12223(site, sched[sweep]);
+				update_site5_12223(i, site, sched[sweep]);
 				break;
 		#endif
 		#ifdef USE_5_NEIGHB
 			case 5000683:
-				update_site5_22223(site, sched[sweep]);
+				update_site5_22223(i, site, sched[sweep]);
 				break;
 		#endif
 		#ifdef USE_5_NEIGHB
 			case 5000351:
-				update_site5_11133(site, sched[sweep]);
+				update_site5_11133(i, site, sched[sweep]);
 				break;
 		#endif
 		#ifdef USE_5_NEIGHB
 			case 5000367:
-				update_site5_11233(site, sched[sweep]);
+				update_site5_11233(i, site, sched[sweep]);
 				break;
 		#endif
 		#ifdef USE_5_NEIGHB
 			case 5000431:
-				update_site5_12233(site, sched[sweep]);
+				update_site5_12233(i, site, sched[sweep]);
 				break;
 		#endif
 		#ifdef USE_5_NEIGHB
 			case 5000687:
-				update_site5_22233(site, sched[sweep]);
+				update_site5_22233(i, site, sched[sweep]);
 				break;
 		#endif
 		#ifdef USE_5_NEIGHB
 			case 5000383:
-				update_site5_11333(site, sched[sweep]);
+				update_site5_11333(i, site, sched[sweep]);
 				break;
 		#endif
 		#ifdef USE_5_NEIGHB
 			case 5000447:
-				update_site5_12333(site, sched[sweep]);
+				update_site5_12333(i, site, sched[sweep]);
 				break;
 		#endif
 		#ifdef USE_5_NEIGHB
 			case 5000703:
-				update_site5_22333(site, sched[sweep]);
+				update_site5_22333(i, site, sched[sweep]);
 				break;
 		#endif
 		#ifdef USE_5_NEIGHB
 			case 5000511:
-				update_site5_13333(site, sched[sweep]);
+				update_site5_13333(i, site, sched[sweep]);
 				break;
 		#endif
 		#ifdef USE_5_NEIGHB
 			case 5000767:
-				update_site5_23333(site, sched[sweep]);
+				update_site5_23333(i, site, sched[sweep]);
 				break;
 		#endif
 		#ifdef USE_5_NEIGHB
 			case 5001023:
-				update_site5_33333(site, sched[sweep]);
+				update_site5_33333(i, site, sched[sweep]);
 				break;
 		#endif
 		#ifdef USE_6_NEIGHB
 			case 6001365:
-				update_site6_111111(site, sched[sweep]);
+				update_site6_111111(i, site, sched[sweep]);
 				break;
 		#endif
 		#ifdef USE_6_NEIGHB
 			case 6001366:
-				update_site6_111112(site, sched[sweep]);
+				update_site6_111112(i, site, sched[sweep]);
 				break;
 		#endif
 		#ifdef USE_6_NEIGHB
 			case 6001370:
-				update_site6_111122(site, sched[sweep]);
+				update_site6_111122(i, site, sched[sweep]);
 				break;
 		#endif
 		#ifdef USE_6_NEIGHB
 			case 6001386:
-				update_site6_111222(site, sched[sweep]);
+				update_site6_111222(i, site, sched[sweep]);
 				break;
 		#endif
 		#ifdef USE_6_NEIGHB
 			case 6001450:
-				update_site6_112222(site, sched[sweep]);
+				update_site6_112222(i, site, sched[sweep]);
 				break;
 		#endif
 		#ifdef USE_6_NEIGHB
 			case 6001706:
-				update_site6_122222(site, sched[sweep]);
+				update_site6_122222(i, site, sched[sweep]);
 				break;
 		#endif
 		#ifdef USE_6_NEIGHB
 			case 6002730:
-				update_site6_222222(site, sched[sweep]);
+				update_site6_222222(i, site, sched[sweep]);
 				break;
 		#endif
 		#ifdef USE_6_NEIGHB
 			case 6001367:
-				update_site6_111113(site, sched[sweep]);
+				update_site6_111113(i, site, sched[sweep]);
 				break;
 		#endif
 		#ifdef USE_6_NEIGHB
 			case 6001371:
-				update_site6_111123(site, sched[sweep]);
+				update_site6_111123(i, site, sched[sweep]);
 				break;
 		#endif
 		#ifdef USE_6_NEIGHB
 			case 6001387:
-				update_site6_111223(site, sched[sweep]);
+				update_site6_111223(i, site, sched[sweep]);
 				break;
 		#endif
 		#ifdef USE_6_NEIGHB
 			case 6001451:
-				update_site6_112223(site, sched[sweep]);
+				update_site6_112223(i, site, sched[sweep]);
 				break;
 		#endif
 		#ifdef USE_6_NEIGHB
 			case 6001707:
-				update_site6_122223(site, sched[sweep]);
+				update_site6_122223(i, site, sched[sweep]);
 				break;
 		#endif
 		#ifdef USE_6_NEIGHB
 			case 6002731:
-				update_site6_222223(site, sched[sweep]);
+				update_site6_222223(i, site, sched[sweep]);
 				break;
 		#endif
 		#ifdef USE_6_NEIGHB
 			case 6001375:
-				update_site6_111133(site, sched[sweep]);
+				update_site6_111133(i, site, sched[sweep]);
 				break;
 		#endif
 		#ifdef USE_6_NEIGHB
 			case 6001391:
-				update_site6_111233(site, sched[sweep]);
+				update_site6_111233(i, site, sched[sweep]);
 				break;
 		#endif
 		#ifdef USE_6_NEIGHB
 			case 6001455:
-				update_site6_112233(site, sched[sweep]);
+				update_site6_112233(i, site, sched[sweep]);
 				break;
 		#endif
 		#ifdef USE_6_NEIGHB
 			case 6001711:
-				update_site6_122233(site, sched[sweep]);
+				update_site6_122233(i, site, sched[sweep]);
 				break;
 		#endif
 		#ifdef USE_6_NEIGHB
 			case 6002735:
-				update_site6_222233(site, sched[sweep]);
+				update_site6_222233(i, site, sched[sweep]);
 				break;
 		#endif
 		#ifdef USE_6_NEIGHB
 			case 6001407:
-				update_site6_111333(site, sched[sweep]);
+				update_site6_111333(i, site, sched[sweep]);
 				break;
 		#endif
 		#ifdef USE_6_NEIGHB
 			case 6001471:
-				update_site6_112333(site, sched[sweep]);
+				update_site6_112333(i, site, sched[sweep]);
 				break;
 		#endif
 		#ifdef USE_6_NEIGHB
 			case 6001727:
-				update_site6_122333(site, sched[sweep]);
+				update_site6_122333(i, site, sched[sweep]);
 				break;
 		#endif
 		#ifdef USE_6_NEIGHB
 			case 6002751:
-				update_site6_222333(site, sched[sweep]);
+				update_site6_222333(i, site, sched[sweep]);
 				break;
 		#endif
 		#ifdef USE_6_NEIGHB
 			case 6001535:
-				update_site6_113333(site, sched[sweep]);
+				update_site6_113333(i, site, sched[sweep]);
 				break;
 		#endif
 		#ifdef USE_6_NEIGHB
 			case 6001791:
-				update_site6_123333(site, sched[sweep]);
+				update_site6_123333(i, site, sched[sweep]);
 				break;
 		#endif
 		#ifdef USE_6_NEIGHB
 			case 6002815:
-				update_site6_223333(site, sched[sweep]);
+				update_site6_223333(i, site, sched[sweep]);
 				break;
 		#endif
 		#ifdef USE_6_NEIGHB
 			case 6002047:
-				update_site6_133333(site, sched[sweep]);
+				update_site6_133333(i, site, sched[sweep]);
 				break;
 		#endif
 		#ifdef USE_6_NEIGHB
 			case 6003071:
-				update_site6_233333(site, sched[sweep]);
+				update_site6_233333(i, site, sched[sweep]);
 				break;
 		#endif
 		#ifdef USE_6_NEIGHB
 			case 6004095:
-				update_site6_333333(site, sched[sweep]);
+				update_site6_333333(i, site, sched[sweep]);
 				break;
 		#endif
 			}
@@ -614,109 +642,161 @@ public:
 	{
 		return "algorithm: multi-spin, range-3 couplings, without fields";
 	}
+
+	// swaps the replicas in the given lanes with those of another instance
+	void exchange_lanes(Algorithm& other, const std::vector<char>& lanes)
+	{
+		word_type mask = lanes_to_word<word_type>(lanes);
+		for (std::size_t i = 0; i < spins.size(); ++i) {
+			word_type t = (spins[i] ^ other.spins[i]) & mask;
+			spins[i] ^= t;
+			other.spins[i] ^= t;
+		}
+	}
+
+	// copies the replicas in the given lanes from another instance
+	void copy_lanes(const Algorithm& src, const std::vector<char>& lanes)
+	{
+		word_type mask = lanes_to_word<word_type>(lanes);
+		for (std::size_t i = 0; i < spins.size(); ++i)
+			spins[i] ^= (spins[i] ^ src.spins[i]) & mask;
+	}
+
+	// spins of the replica in lane k in the order of the sites, 1 for up
+	void get_spins(std::size_t k, std::vector<char>& s) const
+	{
+		s.resize(spins.size());
+		for (std::size_t i = 0; i < spins.size(); ++i)
+			s[i] = word_bit(spins[i], k);
+	}
+
+	// tells whether the energy of one of the lanes is at most e; the
+	// unsatisfied couplings of all lanes are counted at once
+	bool reached_energy(double e)
+	{
+		model->terms.count(&spins[0], counts);
+		return word_any(model->terms.at_most(counts, e));
+	}
+
+	// keeps the spins of every lane whose energy is lower than any it
+	// had at a call before
+	void update_best()
+	{
+		model->terms.count(&spins[0], counts);
+		best.update(counts, &spins[0], spins.size());
+	}
+
+	// puts back the lowest energy state of every lane kept by update_best
+	void restore_best()
+	{
+		spins = best.get_spins();
+	}
 private:
-	std::vector<site_type> sites;
-	std::vector<sched_type> sched;
+	std::shared_ptr<const model_type> model;
+
+	aligned_vector<word_type> spins;
+	aligned_vector<word_type> counts;
+	lane_best<word_type> best;
 
 	std::mt19937 rgen;
 	bgen_type bgen;
 
 	// machine-generated code; do not edit
 	#ifdef USE_1_NEIGHB
-	void update_site1_1(site_type& site, const sched_type& sched)
+	void update_site1_1(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
 		word_type c, s;
 
 		word_type b0 = 0;
 
-		c = site.jzw0[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		c = site.jzw0[0] ^ (spin ^ spins[site.neighbs[0]]);
 		s = b0 ^ c;
 		b0 = s;
 
 		if (r >= sched.r1) {
 			word_type mask = b0;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 	#endif
 
 	// machine-generated code; do not edit
 	#ifdef USE_1_NEIGHB
-	void update_site1_2(site_type& site, const sched_type& sched)
+	void update_site1_2(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
 		word_type c, s;
 
 		word_type b0 = 0, b1 = 0;
 
-		c = site.jzw1[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		c = site.jzw1[0] ^ (spin ^ spins[site.neighbs[0]]);
 		s = b1 ^ c;
 		b1 = s;
 
 		if (r >= sched.r2) {
 			word_type mask = b0 | b1;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 	#endif
 
 	// machine-generated code; do not edit
 	#ifdef USE_1_NEIGHB
-	void update_site1_3(site_type& site, const sched_type& sched)
+	void update_site1_3(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
 		word_type c, s;
 
 		word_type b0 = 0, b1 = 0;
 
-		c = site.jzw0[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		c = site.jzw0[0] ^ (spin ^ spins[site.neighbs[0]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw1[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		c = site.jzw1[0] ^ (spin ^ spins[site.neighbs[0]]);
 		s = b1 ^ c;
 		b1 = s;
 
 		if (r >= sched.r3) {
 			word_type mask = b0 | b1;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 	#endif
 
 	// machine-generated code; do not edit
 	#ifdef USE_2_NEIGHB
-	void update_site2_11(site_type& site, const sched_type& sched)
+	void update_site2_11(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
 		word_type c, s;
 
 		word_type b0 = 0, b1 = 0;
 
-		c = site.jzw0[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		c = site.jzw0[0] ^ (spin ^ spins[site.neighbs[0]]);
 		s = b0 ^ c;
 		b0 = s;
-		c = site.jzw0[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw0[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -725,60 +805,60 @@ private:
 
 		if (r >= sched.r2) {
 			word_type mask = b0 | b1;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 	#endif
 
 	// machine-generated code; do not edit
 	#ifdef USE_2_NEIGHB
-	void update_site2_12(site_type& site, const sched_type& sched)
+	void update_site2_12(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
 		word_type c, s;
 
 		word_type b0 = 0, b1 = 0;
 
-		c = site.jzw0[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		c = site.jzw0[0] ^ (spin ^ spins[site.neighbs[0]]);
 		s = b0 ^ c;
 		b0 = s;
-		c = site.jzw1[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw1[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b1 ^ c;
 		b1 = s;
 
 		if (r >= sched.r1) {
 			word_type mask = b1;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r3) {
 			word_type mask = b0 | b1;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 	#endif
 
 	// machine-generated code; do not edit
 	#ifdef USE_2_NEIGHB
-	void update_site2_22(site_type& site, const sched_type& sched)
+	void update_site2_22(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
 		word_type c, s;
 
 		word_type b0 = 0, b1 = 0, b2 = 0;
 
-		c = site.jzw1[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		c = site.jzw1[0] ^ (spin ^ spins[site.neighbs[0]]);
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw1[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw1[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -787,29 +867,29 @@ private:
 
 		if (r >= sched.r4) {
 			word_type mask = (b0 | b1) | b2;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 	#endif
 
 	// machine-generated code; do not edit
 	#ifdef USE_2_NEIGHB
-	void update_site2_13(site_type& site, const sched_type& sched)
+	void update_site2_13(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
 		word_type c, s;
 
 		word_type b0 = 0, b1 = 0, b2 = 0;
 
-		c = site.jzw0[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		c = site.jzw0[0] ^ (spin ^ spins[site.neighbs[0]]);
 		s = b0 ^ c;
 		b0 = s;
-		c = site.jzw0[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw0[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -818,7 +898,7 @@ private:
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw1[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw1[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -827,32 +907,32 @@ private:
 
 		if (r >= sched.r2) {
 			word_type mask = b1 | b2;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r4) {
 			word_type mask = (b0 | b1) | b2;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 	#endif
 
 	// machine-generated code; do not edit
 	#ifdef USE_2_NEIGHB
-	void update_site2_23(site_type& site, const sched_type& sched)
+	void update_site2_23(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
 		word_type c, s;
 
 		word_type b0 = 0, b1 = 0, b2 = 0;
 
-		c = site.jzw1[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		c = site.jzw1[0] ^ (spin ^ spins[site.neighbs[0]]);
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw0[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw0[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -861,7 +941,7 @@ private:
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw1[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw1[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -870,38 +950,38 @@ private:
 
 		if (r >= sched.r1) {
 			word_type mask = (b0 & b1) | b2;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r5) {
 			word_type mask = (b0 | b1) | b2;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 	#endif
 
 	// machine-generated code; do not edit
 	#ifdef USE_2_NEIGHB
-	void update_site2_33(site_type& site, const sched_type& sched)
+	void update_site2_33(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
 		word_type c, s;
 
 		word_type b0 = 0, b1 = 0, b2 = 0;
 
-		c = site.jzw0[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		c = site.jzw0[0] ^ (spin ^ spins[site.neighbs[0]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw1[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		c = site.jzw1[0] ^ (spin ^ spins[site.neighbs[0]]);
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw0[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw0[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -910,7 +990,7 @@ private:
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw1[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw1[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -919,35 +999,35 @@ private:
 
 		if (r >= sched.r6) {
 			word_type mask = (b0 | b1) | b2;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 	#endif
 
 	// machine-generated code; do not edit
 	#ifdef USE_3_NEIGHB
-	void update_site3_111(site_type& site, const sched_type& sched)
+	void update_site3_111(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
 		word_type c, s;
 
 		word_type b0 = 0, b1 = 0;
 
-		c = site.jzw0[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		c = site.jzw0[0] ^ (spin ^ spins[site.neighbs[0]]);
 		s = b0 ^ c;
 		b0 = s;
-		c = site.jzw0[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw0[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw0[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw0[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -956,38 +1036,38 @@ private:
 
 		if (r >= sched.r1) {
 			word_type mask = b1;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r3) {
 			word_type mask = b0 | b1;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 	#endif
 
 	// machine-generated code; do not edit
 	#ifdef USE_3_NEIGHB
-	void update_site3_112(site_type& site, const sched_type& sched)
+	void update_site3_112(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
 		word_type c, s;
 
 		word_type b0 = 0, b1 = 0, b2 = 0;
 
-		c = site.jzw0[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		c = site.jzw0[0] ^ (spin ^ spins[site.neighbs[0]]);
 		s = b0 ^ c;
 		b0 = s;
-		c = site.jzw0[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw0[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw1[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw1[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -996,35 +1076,35 @@ private:
 
 		if (r >= sched.r2) {
 			word_type mask = b1 | b2;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r4) {
 			word_type mask = (b0 | b1) | b2;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 	#endif
 
 	// machine-generated code; do not edit
 	#ifdef USE_3_NEIGHB
-	void update_site3_122(site_type& site, const sched_type& sched)
+	void update_site3_122(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
 		word_type c, s;
 
 		word_type b0 = 0, b1 = 0, b2 = 0;
 
-		c = site.jzw0[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		c = site.jzw0[0] ^ (spin ^ spins[site.neighbs[0]]);
 		s = b0 ^ c;
 		b0 = s;
-		c = site.jzw1[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw1[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw1[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw1[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -1033,41 +1113,41 @@ private:
 
 		if (r >= sched.r1) {
 			word_type mask = (b0 & b1) | b2;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r3) {
 			word_type mask = b1 | b2;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r5) {
 			word_type mask = (b0 | b1) | b2;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 	#endif
 
 	// machine-generated code; do not edit
 	#ifdef USE_3_NEIGHB
-	void update_site3_222(site_type& site, const sched_type& sched)
+	void update_site3_222(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
 		word_type c, s;
 
 		word_type b0 = 0, b1 = 0, b2 = 0;
 
-		c = site.jzw1[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		c = site.jzw1[0] ^ (spin ^ spins[site.neighbs[0]]);
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw1[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw1[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw1[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw1[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -1076,38 +1156,38 @@ private:
 
 		if (r >= sched.r2) {
 			word_type mask = (b0 & b1) | b2;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r6) {
 			word_type mask = (b0 | b1) | b2;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 	#endif
 
 	// machine-generated code; do not edit
 	#ifdef USE_3_NEIGHB
-	void update_site3_113(site_type& site, const sched_type& sched)
+	void update_site3_113(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
 		word_type c, s;
 
 		word_type b0 = 0, b1 = 0, b2 = 0;
 
-		c = site.jzw0[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		c = site.jzw0[0] ^ (spin ^ spins[site.neighbs[0]]);
 		s = b0 ^ c;
 		b0 = s;
-		c = site.jzw0[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw0[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw0[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw0[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -1116,7 +1196,7 @@ private:
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw1[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw1[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -1125,38 +1205,38 @@ private:
 
 		if (r >= sched.r1) {
 			word_type mask = (b0 & b1) | b2;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r3) {
 			word_type mask = b1 | b2;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r5) {
 			word_type mask = (b0 | b1) | b2;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 	#endif
 
 	// machine-generated code; do not edit
 	#ifdef USE_3_NEIGHB
-	void update_site3_123(site_type& site, const sched_type& sched)
+	void update_site3_123(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
 		word_type c, s;
 
 		word_type b0 = 0, b1 = 0, b2 = 0;
 
-		c = site.jzw0[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		c = site.jzw0[0] ^ (spin ^ spins[site.neighbs[0]]);
 		s = b0 ^ c;
 		b0 = s;
-		c = site.jzw1[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw1[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw0[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw0[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -1165,7 +1245,7 @@ private:
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw1[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw1[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -1174,41 +1254,41 @@ private:
 
 		if (r >= sched.r2) {
 			word_type mask = (b0 & b1) | b2;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r4) {
 			word_type mask = b1 | b2;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r6) {
 			word_type mask = (b0 | b1) | b2;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 	#endif
 
 	// machine-generated code; do not edit
 	#ifdef USE_3_NEIGHB
-	void update_site3_223(site_type& site, const sched_type& sched)
+	void update_site3_223(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
 		word_type c, s;
 
 		word_type b0 = 0, b1 = 0, b2 = 0;
 
-		c = site.jzw1[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		c = site.jzw1[0] ^ (spin ^ spins[site.neighbs[0]]);
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw1[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw1[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw0[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw0[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -1217,7 +1297,7 @@ private:
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw1[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw1[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -1226,35 +1306,35 @@ private:
 
 		if (r >= sched.r1) {
 			word_type mask = b2;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r3) {
 			word_type mask = (b0 & b1) | b2;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r7) {
 			word_type mask = (b0 | b1) | b2;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 	#endif
 
 	// machine-generated code; do not edit
 	#ifdef USE_3_NEIGHB
-	void update_site3_133(site_type& site, const sched_type& sched)
+	void update_site3_133(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
 		word_type c, s;
 
 		word_type b0 = 0, b1 = 0, b2 = 0;
 
-		c = site.jzw0[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		c = site.jzw0[0] ^ (spin ^ spins[site.neighbs[0]]);
 		s = b0 ^ c;
 		b0 = s;
-		c = site.jzw0[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw0[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -1263,13 +1343,13 @@ private:
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw1[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw1[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw0[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw0[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -1278,7 +1358,7 @@ private:
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw1[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw1[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -1287,35 +1367,35 @@ private:
 
 		if (r >= sched.r1) {
 			word_type mask = b2;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r5) {
 			word_type mask = b1 | b2;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r7) {
 			word_type mask = (b0 | b1) | b2;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 	#endif
 
 	// machine-generated code; do not edit
 	#ifdef USE_3_NEIGHB
-	void update_site3_233(site_type& site, const sched_type& sched)
+	void update_site3_233(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
 		word_type c, s;
 
 		word_type b0 = 0, b1 = 0, b2 = 0, b3 = 0;
 
-		c = site.jzw1[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		c = site.jzw1[0] ^ (spin ^ spins[site.neighbs[0]]);
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw0[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw0[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -1324,13 +1404,13 @@ private:
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw1[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw1[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw0[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw0[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -1342,7 +1422,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw1[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw1[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -1354,41 +1434,41 @@ private:
 
 		if (r >= sched.r2) {
 			word_type mask = b2 | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r4) {
 			word_type mask = ((b0 & b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r8) {
 			word_type mask = ((b0 | b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 	#endif
 
 	// machine-generated code; do not edit
 	#ifdef USE_3_NEIGHB
-	void update_site3_333(site_type& site, const sched_type& sched)
+	void update_site3_333(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
 		word_type c, s;
 
 		word_type b0 = 0, b1 = 0, b2 = 0, b3 = 0;
 
-		c = site.jzw0[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		c = site.jzw0[0] ^ (spin ^ spins[site.neighbs[0]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw1[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		c = site.jzw1[0] ^ (spin ^ spins[site.neighbs[0]]);
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw0[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw0[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -1397,13 +1477,13 @@ private:
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw1[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw1[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw0[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw0[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -1415,7 +1495,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw1[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw1[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -1427,44 +1507,44 @@ private:
 
 		if (r >= sched.r3) {
 			word_type mask = b2 | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r9) {
 			word_type mask = ((b0 | b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 	#endif
 
 	// machine-generated code; do not edit
 	#ifdef USE_4_NEIGHB
-	void update_site4_1111(site_type& site, const sched_type& sched)
+	void update_site4_1111(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
 		word_type c, s;
 
 		word_type b0 = 0, b1 = 0, b2 = 0;
 
-		c = site.jzw0[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		c = site.jzw0[0] ^ (spin ^ spins[site.neighbs[0]]);
 		s = b0 ^ c;
 		b0 = s;
-		c = site.jzw0[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw0[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw0[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw0[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw0[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw0[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -1476,44 +1556,44 @@ private:
 
 		if (r >= sched.r2) {
 			word_type mask = b1 | b2;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r4) {
 			word_type mask = (b0 | b1) | b2;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 	#endif
 
 	// machine-generated code; do not edit
 	#ifdef USE_4_NEIGHB
-	void update_site4_1112(site_type& site, const sched_type& sched)
+	void update_site4_1112(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
 		word_type c, s;
 
 		word_type b0 = 0, b1 = 0, b2 = 0;
 
-		c = site.jzw0[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		c = site.jzw0[0] ^ (spin ^ spins[site.neighbs[0]]);
 		s = b0 ^ c;
 		b0 = s;
-		c = site.jzw0[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw0[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw0[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw0[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw1[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw1[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -1522,47 +1602,47 @@ private:
 
 		if (r >= sched.r1) {
 			word_type mask = (b0 & b1) | b2;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r3) {
 			word_type mask = b1 | b2;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r5) {
 			word_type mask = (b0 | b1) | b2;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 	#endif
 
 	// machine-generated code; do not edit
 	#ifdef USE_4_NEIGHB
-	void update_site4_1122(site_type& site, const sched_type& sched)
+	void update_site4_1122(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
 		word_type c, s;
 
 		word_type b0 = 0, b1 = 0, b2 = 0;
 
-		c = site.jzw0[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		c = site.jzw0[0] ^ (spin ^ spins[site.neighbs[0]]);
 		s = b0 ^ c;
 		b0 = s;
-		c = site.jzw0[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw0[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw1[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw1[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw1[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw1[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -1571,44 +1651,44 @@ private:
 
 		if (r >= sched.r2) {
 			word_type mask = (b0 & b1) | b2;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r4) {
 			word_type mask = b1 | b2;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r6) {
 			word_type mask = (b0 | b1) | b2;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 	#endif
 
 	// machine-generated code; do not edit
 	#ifdef USE_4_NEIGHB
-	void update_site4_1222(site_type& site, const sched_type& sched)
+	void update_site4_1222(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
 		word_type c, s;
 
 		word_type b0 = 0, b1 = 0, b2 = 0;
 
-		c = site.jzw0[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		c = site.jzw0[0] ^ (spin ^ spins[site.neighbs[0]]);
 		s = b0 ^ c;
 		b0 = s;
-		c = site.jzw1[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw1[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw1[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw1[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw1[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw1[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -1617,50 +1697,50 @@ private:
 
 		if (r >= sched.r1) {
 			word_type mask = b2;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r3) {
 			word_type mask = (b0 & b1) | b2;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r5) {
 			word_type mask = b1 | b2;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r7) {
 			word_type mask = (b0 | b1) | b2;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 	#endif
 
 	// machine-generated code; do not edit
 	#ifdef USE_4_NEIGHB
-	void update_site4_2222(site_type& site, const sched_type& sched)
+	void update_site4_2222(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
 		word_type c, s;
 
 		word_type b0 = 0, b1 = 0, b2 = 0, b3 = 0;
 
-		c = site.jzw1[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		c = site.jzw1[0] ^ (spin ^ spins[site.neighbs[0]]);
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw1[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw1[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw1[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw1[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw1[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw1[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -1672,44 +1752,44 @@ private:
 
 		if (r >= sched.r4) {
 			word_type mask = ((b0 & b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r8) {
 			word_type mask = ((b0 | b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 	#endif
 
 	// machine-generated code; do not edit
 	#ifdef USE_4_NEIGHB
-	void update_site4_1113(site_type& site, const sched_type& sched)
+	void update_site4_1113(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
 		word_type c, s;
 
 		word_type b0 = 0, b1 = 0, b2 = 0;
 
-		c = site.jzw0[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		c = site.jzw0[0] ^ (spin ^ spins[site.neighbs[0]]);
 		s = b0 ^ c;
 		b0 = s;
-		c = site.jzw0[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw0[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw0[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw0[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw0[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw0[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -1718,7 +1798,7 @@ private:
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw1[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw1[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -1727,47 +1807,47 @@ private:
 
 		if (r >= sched.r2) {
 			word_type mask = (b0 & b1) | b2;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r4) {
 			word_type mask = b1 | b2;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r6) {
 			word_type mask = (b0 | b1) | b2;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 	#endif
 
 	// machine-generated code; do not edit
 	#ifdef USE_4_NEIGHB
-	void update_site4_1123(site_type& site, const sched_type& sched)
+	void update_site4_1123(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
 		word_type c, s;
 
 		word_type b0 = 0, b1 = 0, b2 = 0;
 
-		c = site.jzw0[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		c = site.jzw0[0] ^ (spin ^ spins[site.neighbs[0]]);
 		s = b0 ^ c;
 		b0 = s;
-		c = site.jzw0[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw0[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw1[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw1[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw0[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw0[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -1776,7 +1856,7 @@ private:
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw1[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw1[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -1785,47 +1865,47 @@ private:
 
 		if (r >= sched.r1) {
 			word_type mask = b2;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r3) {
 			word_type mask = (b0 & b1) | b2;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r5) {
 			word_type mask = b1 | b2;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r7) {
 			word_type mask = (b0 | b1) | b2;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 	#endif
 
 	// machine-generated code; do not edit
 	#ifdef USE_4_NEIGHB
-	void update_site4_1223(site_type& site, const sched_type& sched)
+	void update_site4_1223(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
 		word_type c, s;
 
 		word_type b0 = 0, b1 = 0, b2 = 0, b3 = 0;
 
-		c = site.jzw0[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		c = site.jzw0[0] ^ (spin ^ spins[site.neighbs[0]]);
 		s = b0 ^ c;
 		b0 = s;
-		c = site.jzw1[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw1[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw1[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw1[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw0[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw0[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -1837,7 +1917,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw1[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw1[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -1849,50 +1929,50 @@ private:
 
 		if (r >= sched.r2) {
 			word_type mask = b2 | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r4) {
 			word_type mask = ((b0 & b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r6) {
 			word_type mask = (b1 | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r8) {
 			word_type mask = ((b0 | b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 	#endif
 
 	// machine-generated code; do not edit
 	#ifdef USE_4_NEIGHB
-	void update_site4_2223(site_type& site, const sched_type& sched)
+	void update_site4_2223(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
 		word_type c, s;
 
 		word_type b0 = 0, b1 = 0, b2 = 0, b3 = 0;
 
-		c = site.jzw1[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		c = site.jzw1[0] ^ (spin ^ spins[site.neighbs[0]]);
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw1[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw1[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw1[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw1[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw0[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw0[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -1904,7 +1984,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw1[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw1[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -1916,44 +1996,44 @@ private:
 
 		if (r >= sched.r1) {
 			word_type mask = ((b0 | b1) & b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r3) {
 			word_type mask = b2 | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r5) {
 			word_type mask = ((b0 & b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r9) {
 			word_type mask = ((b0 | b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 	#endif
 
 	// machine-generated code; do not edit
 	#ifdef USE_4_NEIGHB
-	void update_site4_1133(site_type& site, const sched_type& sched)
+	void update_site4_1133(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
 		word_type c, s;
 
 		word_type b0 = 0, b1 = 0, b2 = 0, b3 = 0;
 
-		c = site.jzw0[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		c = site.jzw0[0] ^ (spin ^ spins[site.neighbs[0]]);
 		s = b0 ^ c;
 		b0 = s;
-		c = site.jzw0[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw0[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw0[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw0[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -1962,13 +2042,13 @@ private:
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw1[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw1[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw0[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw0[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -1980,7 +2060,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw1[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw1[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -1992,41 +2072,41 @@ private:
 
 		if (r >= sched.r2) {
 			word_type mask = b2 | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r4) {
 			word_type mask = ((b0 & b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r6) {
 			word_type mask = (b1 | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r8) {
 			word_type mask = ((b0 | b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 	#endif
 
 	// machine-generated code; do not edit
 	#ifdef USE_4_NEIGHB
-	void update_site4_1233(site_type& site, const sched_type& sched)
+	void update_site4_1233(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
 		word_type c, s;
 
 		word_type b0 = 0, b1 = 0, b2 = 0, b3 = 0;
 
-		c = site.jzw0[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		c = site.jzw0[0] ^ (spin ^ spins[site.neighbs[0]]);
 		s = b0 ^ c;
 		b0 = s;
-		c = site.jzw1[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw1[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw0[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw0[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -2035,13 +2115,13 @@ private:
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw1[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw1[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw0[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw0[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -2053,7 +2133,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw1[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw1[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -2065,47 +2145,47 @@ private:
 
 		if (r >= sched.r1) {
 			word_type mask = ((b0 | b1) & b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r3) {
 			word_type mask = b2 | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r5) {
 			word_type mask = ((b0 & b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r7) {
 			word_type mask = (b1 | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r9) {
 			word_type mask = ((b0 | b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 	#endif
 
 	// machine-generated code; do not edit
 	#ifdef USE_4_NEIGHB
-	void update_site4_2233(site_type& site, const sched_type& sched)
+	void update_site4_2233(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
 		word_type c, s;
 
 		word_type b0 = 0, b1 = 0, b2 = 0, b3 = 0;
 
-		c = site.jzw1[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		c = site.jzw1[0] ^ (spin ^ spins[site.neighbs[0]]);
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw1[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw1[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw0[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw0[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -2114,13 +2194,13 @@ private:
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw1[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw1[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw0[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw0[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -2132,7 +2212,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw1[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw1[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -2144,38 +2224,38 @@ private:
 
 		if (r >= sched.r2) {
 			word_type mask = ((b0 | b1) & b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r4) {
 			word_type mask = b2 | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r6) {
 			word_type mask = ((b0 & b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r10) {
 			word_type mask = ((b0 | b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 	#endif
 
 	// machine-generated code; do not edit
 	#ifdef USE_4_NEIGHB
-	void update_site4_1333(site_type& site, const sched_type& sched)
+	void update_site4_1333(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
 		word_type c, s;
 
 		word_type b0 = 0, b1 = 0, b2 = 0, b3 = 0;
 
-		c = site.jzw0[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		c = site.jzw0[0] ^ (spin ^ spins[site.neighbs[0]]);
 		s = b0 ^ c;
 		b0 = s;
-		c = site.jzw0[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw0[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -2184,13 +2264,13 @@ private:
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw1[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw1[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw0[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw0[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -2199,13 +2279,13 @@ private:
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw1[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw1[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw0[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw0[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -2217,7 +2297,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw1[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw1[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -2229,38 +2309,38 @@ private:
 
 		if (r >= sched.r2) {
 			word_type mask = ((b0 | b1) & b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r4) {
 			word_type mask = b2 | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r8) {
 			word_type mask = (b1 | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r10) {
 			word_type mask = ((b0 | b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 	#endif
 
 	// machine-generated code; do not edit
 	#ifdef USE_4_NEIGHB
-	void update_site4_2333(site_type& site, const sched_type& sched)
+	void update_site4_2333(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
 		word_type c, s;
 
 		word_type b0 = 0, b1 = 0, b2 = 0, b3 = 0;
 
-		c = site.jzw1[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		c = site.jzw1[0] ^ (spin ^ spins[site.neighbs[0]]);
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw0[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw0[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -2269,13 +2349,13 @@ private:
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw1[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw1[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw0[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw0[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -2287,7 +2367,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw1[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw1[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -2296,7 +2376,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw0[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw0[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -2308,7 +2388,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw1[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw1[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -2320,44 +2400,44 @@ private:
 
 		if (r >= sched.r1) {
 			word_type mask = (b1 & b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r5) {
 			word_type mask = b2 | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r7) {
 			word_type mask = ((b0 & b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r11) {
 			word_type mask = ((b0 | b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 	#endif
 
 	// machine-generated code; do not edit
 	#ifdef USE_4_NEIGHB
-	void update_site4_3333(site_type& site, const sched_type& sched)
+	void update_site4_3333(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
 		word_type c, s;
 
 		word_type b0 = 0, b1 = 0, b2 = 0, b3 = 0;
 
-		c = site.jzw0[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		c = site.jzw0[0] ^ (spin ^ spins[site.neighbs[0]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw1[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		c = site.jzw1[0] ^ (spin ^ spins[site.neighbs[0]]);
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw0[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw0[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -2366,13 +2446,13 @@ private:
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw1[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw1[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw0[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw0[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -2384,7 +2464,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw1[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw1[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -2393,7 +2473,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw0[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw0[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -2405,7 +2485,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw1[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw1[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -2417,44 +2497,44 @@ private:
 
 		if (r >= sched.r6) {
 			word_type mask = b2 | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r12) {
 			word_type mask = ((b0 | b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 	#endif
 
 	// machine-generated code; do not edit
 	#ifdef USE_5_NEIGHB
-	void update_site5_11111(site_type& site, const sched_type& sched)
+	void update_site5_11111(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
 		word_type c, s;
 
 		word_type b0 = 0, b1 = 0, b2 = 0;
 
-		c = site.jzw0[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		c = site.jzw0[0] ^ (spin ^ spins[site.neighbs[0]]);
 		s = b0 ^ c;
 		b0 = s;
-		c = site.jzw0[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw0[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw0[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw0[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw0[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw0[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -2463,7 +2543,7 @@ private:
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw0[4] ^ (spin ^ sites[site.neighbs[4]].spin);
+		c = site.jzw0[4] ^ (spin ^ spins[site.neighbs[4]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -2475,47 +2555,47 @@ private:
 
 		if (r >= sched.r1) {
 			word_type mask = (b0 & b1) | b2;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r3) {
 			word_type mask = b1 | b2;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r5) {
 			word_type mask = (b0 | b1) | b2;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 	#endif
 
 	// machine-generated code; do not edit
 	#ifdef USE_5_NEIGHB
-	void update_site5_11112(site_type& site, const sched_type& sched)
+	void update_site5_11112(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
 		word_type c, s;
 
 		word_type b0 = 0, b1 = 0, b2 = 0;
 
-		c = site.jzw0[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		c = site.jzw0[0] ^ (spin ^ spins[site.neighbs[0]]);
 		s = b0 ^ c;
 		b0 = s;
-		c = site.jzw0[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw0[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw0[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw0[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw0[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw0[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -2524,7 +2604,7 @@ private:
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw1[4] ^ (spin ^ sites[site.neighbs[4]].spin);
+		c = site.jzw1[4] ^ (spin ^ spins[site.neighbs[4]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -2533,53 +2613,53 @@ private:
 
 		if (r >= sched.r2) {
 			word_type mask = (b0 & b1) | b2;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r4) {
 			word_type mask = b1 | b2;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r6) {
 			word_type mask = (b0 | b1) | b2;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 	#endif
 
 	// machine-generated code; do not edit
 	#ifdef USE_5_NEIGHB
-	void update_site5_11122(site_type& site, const sched_type& sched)
+	void update_site5_11122(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
 		word_type c, s;
 
 		word_type b0 = 0, b1 = 0, b2 = 0;
 
-		c = site.jzw0[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		c = site.jzw0[0] ^ (spin ^ spins[site.neighbs[0]]);
 		s = b0 ^ c;
 		b0 = s;
-		c = site.jzw0[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw0[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw0[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw0[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw1[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw1[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw1[4] ^ (spin ^ sites[site.neighbs[4]].spin);
+		c = site.jzw1[4] ^ (spin ^ spins[site.neighbs[4]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -2588,56 +2668,56 @@ private:
 
 		if (r >= sched.r1) {
 			word_type mask = b2;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r3) {
 			word_type mask = (b0 & b1) | b2;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r5) {
 			word_type mask = b1 | b2;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r7) {
 			word_type mask = (b0 | b1) | b2;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 	#endif
 
 	// machine-generated code; do not edit
 	#ifdef USE_5_NEIGHB
-	void update_site5_11222(site_type& site, const sched_type& sched)
+	void update_site5_11222(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
 		word_type c, s;
 
 		word_type b0 = 0, b1 = 0, b2 = 0, b3 = 0;
 
-		c = site.jzw0[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		c = site.jzw0[0] ^ (spin ^ spins[site.neighbs[0]]);
 		s = b0 ^ c;
 		b0 = s;
-		c = site.jzw0[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw0[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw1[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw1[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw1[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw1[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw1[4] ^ (spin ^ sites[site.neighbs[4]].spin);
+		c = site.jzw1[4] ^ (spin ^ spins[site.neighbs[4]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -2649,53 +2729,53 @@ private:
 
 		if (r >= sched.r2) {
 			word_type mask = b2 | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r4) {
 			word_type mask = ((b0 & b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r6) {
 			word_type mask = (b1 | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r8) {
 			word_type mask = ((b0 | b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 	#endif
 
 	// machine-generated code; do not edit
 	#ifdef USE_5_NEIGHB
-	void update_site5_12222(site_type& site, const sched_type& sched)
+	void update_site5_12222(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
 		word_type c, s;
 
 		word_type b0 = 0, b1 = 0, b2 = 0, b3 = 0;
 
-		c = site.jzw0[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		c = site.jzw0[0] ^ (spin ^ spins[site.neighbs[0]]);
 		s = b0 ^ c;
 		b0 = s;
-		c = site.jzw1[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw1[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw1[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw1[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw1[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw1[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw1[4] ^ (spin ^ sites[site.neighbs[4]].spin);
+		c = site.jzw1[4] ^ (spin ^ spins[site.neighbs[4]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -2707,53 +2787,53 @@ private:
 
 		if (r >= sched.r1) {
 			word_type mask = ((b0 | b1) & b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r3) {
 			word_type mask = b2 | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r5) {
 			word_type mask = ((b0 & b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r7) {
 			word_type mask = (b1 | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r9) {
 			word_type mask = ((b0 | b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 	#endif
 
 	// machine-generated code; do not edit
 	#ifdef USE_5_NEIGHB
-	void update_site5_22222(site_type& site, const sched_type& sched)
+	void update_site5_22222(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
 		word_type c, s;
 
 		word_type b0 = 0, b1 = 0, b2 = 0, b3 = 0;
 
-		c = site.jzw1[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		c = site.jzw1[0] ^ (spin ^ spins[site.neighbs[0]]);
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw1[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw1[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw1[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw1[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw1[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw1[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -2762,7 +2842,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw1[4] ^ (spin ^ sites[site.neighbs[4]].spin);
+		c = site.jzw1[4] ^ (spin ^ spins[site.neighbs[4]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -2774,47 +2854,47 @@ private:
 
 		if (r >= sched.r2) {
 			word_type mask = ((b0 | b1) & b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r6) {
 			word_type mask = ((b0 & b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r10) {
 			word_type mask = ((b0 | b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 	#endif
 
 	// machine-generated code; do not edit
 	#ifdef USE_5_NEIGHB
-	void update_site5_11113(site_type& site, const sched_type& sched)
+	void update_site5_11113(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
 		word_type c, s;
 
 		word_type b0 = 0, b1 = 0, b2 = 0;
 
-		c = site.jzw0[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		c = site.jzw0[0] ^ (spin ^ spins[site.neighbs[0]]);
 		s = b0 ^ c;
 		b0 = s;
-		c = site.jzw0[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw0[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw0[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw0[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw0[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw0[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -2823,7 +2903,7 @@ private:
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw0[4] ^ (spin ^ sites[site.neighbs[4]].spin);
+		c = site.jzw0[4] ^ (spin ^ spins[site.neighbs[4]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -2832,7 +2912,7 @@ private:
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw1[4] ^ (spin ^ sites[site.neighbs[4]].spin);
+		c = site.jzw1[4] ^ (spin ^ spins[site.neighbs[4]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -2841,56 +2921,56 @@ private:
 
 		if (r >= sched.r1) {
 			word_type mask = b2;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r3) {
 			word_type mask = (b0 & b1) | b2;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r5) {
 			word_type mask = b1 | b2;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r7) {
 			word_type mask = (b0 | b1) | b2;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 	#endif
 
 	// machine-generated code; do not edit
 	#ifdef USE_5_NEIGHB
-	void update_site5_11123(site_type& site, const sched_type& sched)
+	void update_site5_11123(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
 		word_type c, s;
 
 		word_type b0 = 0, b1 = 0, b2 = 0, b3 = 0;
 
-		c = site.jzw0[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		c = site.jzw0[0] ^ (spin ^ spins[site.neighbs[0]]);
 		s = b0 ^ c;
 		b0 = s;
-		c = site.jzw0[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw0[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw0[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw0[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw1[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw1[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw0[4] ^ (spin ^ sites[site.neighbs[4]].spin);
+		c = site.jzw0[4] ^ (spin ^ spins[site.neighbs[4]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -2902,7 +2982,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw1[4] ^ (spin ^ sites[site.neighbs[4]].spin);
+		c = site.jzw1[4] ^ (spin ^ spins[site.neighbs[4]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -2914,56 +2994,56 @@ private:
 
 		if (r >= sched.r2) {
 			word_type mask = b2 | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r4) {
 			word_type mask = ((b0 & b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r6) {
 			word_type mask = (b1 | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r8) {
 			word_type mask = ((b0 | b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 	#endif
 
 	// machine-generated code; do not edit
 	#ifdef USE_5_NEIGHB
-	void update_site5_11223(site_type& site, const sched_type& sched)
+	void update_site5_11223(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
 		word_type c, s;
 
 		word_type b0 = 0, b1 = 0, b2 = 0, b3 = 0;
 
-		c = site.jzw0[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		c = site.jzw0[0] ^ (spin ^ spins[site.neighbs[0]]);
 		s = b0 ^ c;
 		b0 = s;
-		c = site.jzw0[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw0[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw1[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw1[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw1[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw1[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw0[4] ^ (spin ^ sites[site.neighbs[4]].spin);
+		c = site.jzw0[4] ^ (spin ^ spins[site.neighbs[4]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -2975,7 +3055,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw1[4] ^ (spin ^ sites[site.neighbs[4]].spin);
+		c = site.jzw1[4] ^ (spin ^ spins[site.neighbs[4]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -2987,56 +3067,56 @@ private:
 
 		if (r >= sched.r1) {
 			word_type mask = ((b0 | b1) & b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r3) {
 			word_type mask = b2 | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r5) {
 			word_type mask = ((b0 & b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r7) {
 			word_type mask = (b1 | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r9) {
 			word_type mask = ((b0 | b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 	#endif
 
 	// machine-generated code; do not edit
 	#ifdef USE_5_NEIGHB
-	void update_site5_12223(site_type& site, const sched_type& sched)
+	void update_site5_12223(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
 		word_type c, s;
 
 		word_type b0 = 0, b1 = 0, b2 = 0, b3 = 0;
 
-		c = site.jzw0[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		c = site.jzw0[0] ^ (spin ^ spins[site.neighbs[0]]);
 		s = b0 ^ c;
 		b0 = s;
-		c = site.jzw1[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw1[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw1[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw1[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw1[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw1[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw0[4] ^ (spin ^ sites[site.neighbs[4]].spin);
+		c = site.jzw0[4] ^ (spin ^ spins[site.neighbs[4]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -3048,7 +3128,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw1[4] ^ (spin ^ sites[site.neighbs[4]].spin);
+		c = site.jzw1[4] ^ (spin ^ spins[site.neighbs[4]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -3060,53 +3140,53 @@ private:
 
 		if (r >= sched.r2) {
 			word_type mask = ((b0 | b1) & b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r4) {
 			word_type mask = b2 | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r6) {
 			word_type mask = ((b0 & b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r8) {
 			word_type mask = (b1 | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r10) {
 			word_type mask = ((b0 | b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 	#endif
 
 	// machine-generated code; do not edit
 	#ifdef USE_5_NEIGHB
-	void update_site5_22223(site_type& site, const sched_type& sched)
+	void update_site5_22223(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
 		word_type c, s;
 
 		word_type b0 = 0, b1 = 0, b2 = 0, b3 = 0;
 
-		c = site.jzw1[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		c = site.jzw1[0] ^ (spin ^ spins[site.neighbs[0]]);
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw1[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw1[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw1[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw1[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw1[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw1[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -3115,7 +3195,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw0[4] ^ (spin ^ sites[site.neighbs[4]].spin);
+		c = site.jzw0[4] ^ (spin ^ spins[site.neighbs[4]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -3127,7 +3207,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw1[4] ^ (spin ^ sites[site.neighbs[4]].spin);
+		c = site.jzw1[4] ^ (spin ^ spins[site.neighbs[4]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -3139,53 +3219,53 @@ private:
 
 		if (r >= sched.r1) {
 			word_type mask = (b1 & b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r3) {
 			word_type mask = ((b0 | b1) & b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r5) {
 			word_type mask = b2 | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r7) {
 			word_type mask = ((b0 & b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r11) {
 			word_type mask = ((b0 | b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 	#endif
 
 	// machine-generated code; do not edit
 	#ifdef USE_5_NEIGHB
-	void update_site5_11133(site_type& site, const sched_type& sched)
+	void update_site5_11133(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
 		word_type c, s;
 
 		word_type b0 = 0, b1 = 0, b2 = 0, b3 = 0;
 
-		c = site.jzw0[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		c = site.jzw0[0] ^ (spin ^ spins[site.neighbs[0]]);
 		s = b0 ^ c;
 		b0 = s;
-		c = site.jzw0[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw0[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw0[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw0[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw0[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw0[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -3194,13 +3274,13 @@ private:
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw1[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw1[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw0[4] ^ (spin ^ sites[site.neighbs[4]].spin);
+		c = site.jzw0[4] ^ (spin ^ spins[site.neighbs[4]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -3212,7 +3292,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw1[4] ^ (spin ^ sites[site.neighbs[4]].spin);
+		c = site.jzw1[4] ^ (spin ^ spins[site.neighbs[4]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -3224,53 +3304,53 @@ private:
 
 		if (r >= sched.r1) {
 			word_type mask = ((b0 | b1) & b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r3) {
 			word_type mask = b2 | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r5) {
 			word_type mask = ((b0 & b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r7) {
 			word_type mask = (b1 | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r9) {
 			word_type mask = ((b0 | b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 	#endif
 
 	// machine-generated code; do not edit
 	#ifdef USE_5_NEIGHB
-	void update_site5_11233(site_type& site, const sched_type& sched)
+	void update_site5_11233(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
 		word_type c, s;
 
 		word_type b0 = 0, b1 = 0, b2 = 0, b3 = 0;
 
-		c = site.jzw0[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		c = site.jzw0[0] ^ (spin ^ spins[site.neighbs[0]]);
 		s = b0 ^ c;
 		b0 = s;
-		c = site.jzw0[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw0[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw1[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw1[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw0[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw0[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -3279,13 +3359,13 @@ private:
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw1[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw1[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw0[4] ^ (spin ^ sites[site.neighbs[4]].spin);
+		c = site.jzw0[4] ^ (spin ^ spins[site.neighbs[4]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -3297,7 +3377,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw1[4] ^ (spin ^ sites[site.neighbs[4]].spin);
+		c = site.jzw1[4] ^ (spin ^ spins[site.neighbs[4]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -3309,50 +3389,50 @@ private:
 
 		if (r >= sched.r2) {
 			word_type mask = ((b0 | b1) & b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r4) {
 			word_type mask = b2 | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r6) {
 			word_type mask = ((b0 & b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r8) {
 			word_type mask = (b1 | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r10) {
 			word_type mask = ((b0 | b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 	#endif
 
 	// machine-generated code; do not edit
 	#ifdef USE_5_NEIGHB
-	void update_site5_12233(site_type& site, const sched_type& sched)
+	void update_site5_12233(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
 		word_type c, s;
 
 		word_type b0 = 0, b1 = 0, b2 = 0, b3 = 0;
 
-		c = site.jzw0[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		c = site.jzw0[0] ^ (spin ^ spins[site.neighbs[0]]);
 		s = b0 ^ c;
 		b0 = s;
-		c = site.jzw1[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw1[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw1[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw1[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw0[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw0[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -3364,7 +3444,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw1[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw1[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -3373,7 +3453,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw0[4] ^ (spin ^ sites[site.neighbs[4]].spin);
+		c = site.jzw0[4] ^ (spin ^ spins[site.neighbs[4]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -3385,7 +3465,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw1[4] ^ (spin ^ sites[site.neighbs[4]].spin);
+		c = site.jzw1[4] ^ (spin ^ spins[site.neighbs[4]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -3397,56 +3477,56 @@ private:
 
 		if (r >= sched.r1) {
 			word_type mask = (b1 & b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r3) {
 			word_type mask = ((b0 | b1) & b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r5) {
 			word_type mask = b2 | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r7) {
 			word_type mask = ((b0 & b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r9) {
 			word_type mask = (b1 | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r11) {
 			word_type mask = ((b0 | b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 	#endif
 
 	// machine-generated code; do not edit
 	#ifdef USE_5_NEIGHB
-	void update_site5_22233(site_type& site, const sched_type& sched)
+	void update_site5_22233(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
 		word_type c, s;
 
 		word_type b0 = 0, b1 = 0, b2 = 0, b3 = 0;
 
-		c = site.jzw1[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		c = site.jzw1[0] ^ (spin ^ spins[site.neighbs[0]]);
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw1[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw1[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw1[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw1[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw0[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw0[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -3458,7 +3538,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw1[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw1[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -3467,7 +3547,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw0[4] ^ (spin ^ sites[site.neighbs[4]].spin);
+		c = site.jzw0[4] ^ (spin ^ spins[site.neighbs[4]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -3479,7 +3559,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw1[4] ^ (spin ^ sites[site.neighbs[4]].spin);
+		c = site.jzw1[4] ^ (spin ^ spins[site.neighbs[4]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -3491,47 +3571,47 @@ private:
 
 		if (r >= sched.r2) {
 			word_type mask = (b1 & b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r4) {
 			word_type mask = ((b0 | b1) & b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r6) {
 			word_type mask = b2 | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r8) {
 			word_type mask = ((b0 & b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r12) {
 			word_type mask = ((b0 | b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 	#endif
 
 	// machine-generated code; do not edit
 	#ifdef USE_5_NEIGHB
-	void update_site5_11333(site_type& site, const sched_type& sched)
+	void update_site5_11333(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
 		word_type c, s;
 
 		word_type b0 = 0, b1 = 0, b2 = 0, b3 = 0;
 
-		c = site.jzw0[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		c = site.jzw0[0] ^ (spin ^ spins[site.neighbs[0]]);
 		s = b0 ^ c;
 		b0 = s;
-		c = site.jzw0[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw0[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw0[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw0[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -3540,13 +3620,13 @@ private:
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw1[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw1[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw0[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw0[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -3558,7 +3638,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw1[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw1[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -3567,7 +3647,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw0[4] ^ (spin ^ sites[site.neighbs[4]].spin);
+		c = site.jzw0[4] ^ (spin ^ spins[site.neighbs[4]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -3579,7 +3659,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw1[4] ^ (spin ^ sites[site.neighbs[4]].spin);
+		c = site.jzw1[4] ^ (spin ^ spins[site.neighbs[4]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -3591,47 +3671,47 @@ private:
 
 		if (r >= sched.r1) {
 			word_type mask = (b1 & b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r3) {
 			word_type mask = ((b0 | b1) & b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r5) {
 			word_type mask = b2 | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r7) {
 			word_type mask = ((b0 & b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r9) {
 			word_type mask = (b1 | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r11) {
 			word_type mask = ((b0 | b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 	#endif
 
 	// machine-generated code; do not edit
 	#ifdef USE_5_NEIGHB
-	void update_site5_12333(site_type& site, const sched_type& sched)
+	void update_site5_12333(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
 		word_type c, s;
 
 		word_type b0 = 0, b1 = 0, b2 = 0, b3 = 0;
 
-		c = site.jzw0[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		c = site.jzw0[0] ^ (spin ^ spins[site.neighbs[0]]);
 		s = b0 ^ c;
 		b0 = s;
-		c = site.jzw1[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw1[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw0[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw0[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -3640,13 +3720,13 @@ private:
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw1[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw1[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw0[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw0[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -3658,7 +3738,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw1[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw1[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -3667,7 +3747,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw0[4] ^ (spin ^ sites[site.neighbs[4]].spin);
+		c = site.jzw0[4] ^ (spin ^ spins[site.neighbs[4]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -3679,7 +3759,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw1[4] ^ (spin ^ sites[site.neighbs[4]].spin);
+		c = site.jzw1[4] ^ (spin ^ spins[site.neighbs[4]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -3691,50 +3771,50 @@ private:
 
 		if (r >= sched.r2) {
 			word_type mask = (b1 & b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r4) {
 			word_type mask = ((b0 | b1) & b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r6) {
 			word_type mask = b2 | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r8) {
 			word_type mask = ((b0 & b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r10) {
 			word_type mask = (b1 | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r12) {
 			word_type mask = ((b0 | b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 	#endif
 
 	// machine-generated code; do not edit
 	#ifdef USE_5_NEIGHB
-	void update_site5_22333(site_type& site, const sched_type& sched)
+	void update_site5_22333(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
 		word_type c, s;
 
 		word_type b0 = 0, b1 = 0, b2 = 0, b3 = 0;
 
-		c = site.jzw1[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		c = site.jzw1[0] ^ (spin ^ spins[site.neighbs[0]]);
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw1[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw1[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw0[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw0[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -3743,13 +3823,13 @@ private:
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw1[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw1[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw0[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw0[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -3761,7 +3841,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw1[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw1[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -3770,7 +3850,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw0[4] ^ (spin ^ sites[site.neighbs[4]].spin);
+		c = site.jzw0[4] ^ (spin ^ spins[site.neighbs[4]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -3782,7 +3862,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw1[4] ^ (spin ^ sites[site.neighbs[4]].spin);
+		c = site.jzw1[4] ^ (spin ^ spins[site.neighbs[4]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -3794,44 +3874,44 @@ private:
 
 		if (r >= sched.r1) {
 			word_type mask = ((b0 & b1) & b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r3) {
 			word_type mask = (b1 & b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r5) {
 			word_type mask = ((b0 | b1) & b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r7) {
 			word_type mask = b2 | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r9) {
 			word_type mask = ((b0 & b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r13) {
 			word_type mask = ((b0 | b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 	#endif
 
 	// machine-generated code; do not edit
 	#ifdef USE_5_NEIGHB
-	void update_site5_13333(site_type& site, const sched_type& sched)
+	void update_site5_13333(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
 		word_type c, s;
 
 		word_type b0 = 0, b1 = 0, b2 = 0, b3 = 0;
 
-		c = site.jzw0[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		c = site.jzw0[0] ^ (spin ^ spins[site.neighbs[0]]);
 		s = b0 ^ c;
 		b0 = s;
-		c = site.jzw0[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw0[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -3840,13 +3920,13 @@ private:
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw1[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw1[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw0[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw0[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -3855,13 +3935,13 @@ private:
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw1[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw1[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw0[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw0[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -3873,7 +3953,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw1[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw1[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -3882,7 +3962,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw0[4] ^ (spin ^ sites[site.neighbs[4]].spin);
+		c = site.jzw0[4] ^ (spin ^ spins[site.neighbs[4]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -3894,7 +3974,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw1[4] ^ (spin ^ sites[site.neighbs[4]].spin);
+		c = site.jzw1[4] ^ (spin ^ spins[site.neighbs[4]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -3906,41 +3986,41 @@ private:
 
 		if (r >= sched.r1) {
 			word_type mask = ((b0 & b1) & b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r5) {
 			word_type mask = ((b0 | b1) & b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r7) {
 			word_type mask = b2 | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r11) {
 			word_type mask = (b1 | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r13) {
 			word_type mask = ((b0 | b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 	#endif
 
 	// machine-generated code; do not edit
 	#ifdef USE_5_NEIGHB
-	void update_site5_23333(site_type& site, const sched_type& sched)
+	void update_site5_23333(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
 		word_type c, s;
 
 		word_type b0 = 0, b1 = 0, b2 = 0, b3 = 0;
 
-		c = site.jzw1[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		c = site.jzw1[0] ^ (spin ^ spins[site.neighbs[0]]);
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw0[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw0[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -3949,13 +4029,13 @@ private:
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw1[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw1[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw0[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw0[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -3967,7 +4047,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw1[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw1[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -3976,7 +4056,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw0[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw0[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -3988,7 +4068,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw1[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw1[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -3997,7 +4077,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw0[4] ^ (spin ^ sites[site.neighbs[4]].spin);
+		c = site.jzw0[4] ^ (spin ^ spins[site.neighbs[4]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -4009,7 +4089,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw1[4] ^ (spin ^ sites[site.neighbs[4]].spin);
+		c = site.jzw1[4] ^ (spin ^ spins[site.neighbs[4]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -4021,47 +4101,47 @@ private:
 
 		if (r >= sched.r2) {
 			word_type mask = ((b0 & b1) & b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r4) {
 			word_type mask = (b1 & b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r8) {
 			word_type mask = b2 | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r10) {
 			word_type mask = ((b0 & b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r14) {
 			word_type mask = ((b0 | b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 	#endif
 
 	// machine-generated code; do not edit
 	#ifdef USE_5_NEIGHB
-	void update_site5_33333(site_type& site, const sched_type& sched)
+	void update_site5_33333(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
 		word_type c, s;
 
 		word_type b0 = 0, b1 = 0, b2 = 0, b3 = 0;
 
-		c = site.jzw0[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		c = site.jzw0[0] ^ (spin ^ spins[site.neighbs[0]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw1[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		c = site.jzw1[0] ^ (spin ^ spins[site.neighbs[0]]);
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw0[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw0[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -4070,13 +4150,13 @@ private:
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw1[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw1[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw0[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw0[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -4088,7 +4168,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw1[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw1[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -4097,7 +4177,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw0[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw0[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -4109,7 +4189,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw1[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw1[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -4118,7 +4198,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw0[4] ^ (spin ^ sites[site.neighbs[4]].spin);
+		c = site.jzw0[4] ^ (spin ^ spins[site.neighbs[4]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -4130,7 +4210,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw1[4] ^ (spin ^ sites[site.neighbs[4]].spin);
+		c = site.jzw1[4] ^ (spin ^ spins[site.neighbs[4]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -4142,47 +4222,47 @@ private:
 
 		if (r >= sched.r3) {
 			word_type mask = ((b0 & b1) & b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r9) {
 			word_type mask = b2 | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r15) {
 			word_type mask = ((b0 | b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 	#endif
 
 	// machine-generated code; do not edit
 	#ifdef USE_6_NEIGHB
-	void update_site6_111111(site_type& site, const sched_type& sched)
+	void update_site6_111111(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
 		word_type c, s;
 
 		word_type b0 = 0, b1 = 0, b2 = 0;
 
-		c = site.jzw0[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		c = site.jzw0[0] ^ (spin ^ spins[site.neighbs[0]]);
 		s = b0 ^ c;
 		b0 = s;
-		c = site.jzw0[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw0[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw0[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw0[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw0[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw0[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -4191,7 +4271,7 @@ private:
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw0[4] ^ (spin ^ sites[site.neighbs[4]].spin);
+		c = site.jzw0[4] ^ (spin ^ spins[site.neighbs[4]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -4200,7 +4280,7 @@ private:
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw0[5] ^ (spin ^ sites[site.neighbs[5]].spin);
+		c = site.jzw0[5] ^ (spin ^ spins[site.neighbs[5]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -4212,47 +4292,47 @@ private:
 
 		if (r >= sched.r2) {
 			word_type mask = (b0 & b1) | b2;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r4) {
 			word_type mask = b1 | b2;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r6) {
 			word_type mask = (b0 | b1) | b2;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 	#endif
 
 	// machine-generated code; do not edit
 	#ifdef USE_6_NEIGHB
-	void update_site6_111112(site_type& site, const sched_type& sched)
+	void update_site6_111112(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
 		word_type c, s;
 
 		word_type b0 = 0, b1 = 0, b2 = 0;
 
-		c = site.jzw0[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		c = site.jzw0[0] ^ (spin ^ spins[site.neighbs[0]]);
 		s = b0 ^ c;
 		b0 = s;
-		c = site.jzw0[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw0[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw0[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw0[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw0[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw0[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -4261,7 +4341,7 @@ private:
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw0[4] ^ (spin ^ sites[site.neighbs[4]].spin);
+		c = site.jzw0[4] ^ (spin ^ spins[site.neighbs[4]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -4270,7 +4350,7 @@ private:
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw1[5] ^ (spin ^ sites[site.neighbs[5]].spin);
+		c = site.jzw1[5] ^ (spin ^ spins[site.neighbs[5]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -4279,50 +4359,50 @@ private:
 
 		if (r >= sched.r1) {
 			word_type mask = b2;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r3) {
 			word_type mask = (b0 & b1) | b2;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r5) {
 			word_type mask = b1 | b2;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r7) {
 			word_type mask = (b0 | b1) | b2;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 	#endif
 
 	// machine-generated code; do not edit
 	#ifdef USE_6_NEIGHB
-	void update_site6_111122(site_type& site, const sched_type& sched)
+	void update_site6_111122(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
 		word_type c, s;
 
 		word_type b0 = 0, b1 = 0, b2 = 0, b3 = 0;
 
-		c = site.jzw0[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		c = site.jzw0[0] ^ (spin ^ spins[site.neighbs[0]]);
 		s = b0 ^ c;
 		b0 = s;
-		c = site.jzw0[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw0[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw0[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw0[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw0[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw0[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -4331,13 +4411,13 @@ private:
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw1[4] ^ (spin ^ sites[site.neighbs[4]].spin);
+		c = site.jzw1[4] ^ (spin ^ spins[site.neighbs[4]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw1[5] ^ (spin ^ sites[site.neighbs[5]].spin);
+		c = site.jzw1[5] ^ (spin ^ spins[site.neighbs[5]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -4349,62 +4429,62 @@ private:
 
 		if (r >= sched.r2) {
 			word_type mask = b2 | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r4) {
 			word_type mask = ((b0 & b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r6) {
 			word_type mask = (b1 | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r8) {
 			word_type mask = ((b0 | b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 	#endif
 
 	// machine-generated code; do not edit
 	#ifdef USE_6_NEIGHB
-	void update_site6_111222(site_type& site, const sched_type& sched)
+	void update_site6_111222(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
 		word_type c, s;
 
 		word_type b0 = 0, b1 = 0, b2 = 0, b3 = 0;
 
-		c = site.jzw0[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		c = site.jzw0[0] ^ (spin ^ spins[site.neighbs[0]]);
 		s = b0 ^ c;
 		b0 = s;
-		c = site.jzw0[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw0[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw0[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw0[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw1[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw1[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw1[4] ^ (spin ^ sites[site.neighbs[4]].spin);
+		c = site.jzw1[4] ^ (spin ^ spins[site.neighbs[4]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw1[5] ^ (spin ^ sites[site.neighbs[5]].spin);
+		c = site.jzw1[5] ^ (spin ^ spins[site.neighbs[5]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -4416,59 +4496,59 @@ private:
 
 		if (r >= sched.r1) {
 			word_type mask = ((b0 | b1) & b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r3) {
 			word_type mask = b2 | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r5) {
 			word_type mask = ((b0 & b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r7) {
 			word_type mask = (b1 | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r9) {
 			word_type mask = ((b0 | b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 	#endif
 
 	// machine-generated code; do not edit
 	#ifdef USE_6_NEIGHB
-	void update_site6_112222(site_type& site, const sched_type& sched)
+	void update_site6_112222(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
 		word_type c, s;
 
 		word_type b0 = 0, b1 = 0, b2 = 0, b3 = 0;
 
-		c = site.jzw0[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		c = site.jzw0[0] ^ (spin ^ spins[site.neighbs[0]]);
 		s = b0 ^ c;
 		b0 = s;
-		c = site.jzw0[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw0[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw1[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw1[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw1[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw1[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw1[4] ^ (spin ^ sites[site.neighbs[4]].spin);
+		c = site.jzw1[4] ^ (spin ^ spins[site.neighbs[4]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -4477,7 +4557,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw1[5] ^ (spin ^ sites[site.neighbs[5]].spin);
+		c = site.jzw1[5] ^ (spin ^ spins[site.neighbs[5]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -4489,56 +4569,56 @@ private:
 
 		if (r >= sched.r2) {
 			word_type mask = ((b0 | b1) & b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r4) {
 			word_type mask = b2 | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r6) {
 			word_type mask = ((b0 & b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r8) {
 			word_type mask = (b1 | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r10) {
 			word_type mask = ((b0 | b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 	#endif
 
 	// machine-generated code; do not edit
 	#ifdef USE_6_NEIGHB
-	void update_site6_122222(site_type& site, const sched_type& sched)
+	void update_site6_122222(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
 		word_type c, s;
 
 		word_type b0 = 0, b1 = 0, b2 = 0, b3 = 0;
 
-		c = site.jzw0[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		c = site.jzw0[0] ^ (spin ^ spins[site.neighbs[0]]);
 		s = b0 ^ c;
 		b0 = s;
-		c = site.jzw1[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw1[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw1[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw1[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw1[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw1[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw1[4] ^ (spin ^ sites[site.neighbs[4]].spin);
+		c = site.jzw1[4] ^ (spin ^ spins[site.neighbs[4]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -4547,7 +4627,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw1[5] ^ (spin ^ sites[site.neighbs[5]].spin);
+		c = site.jzw1[5] ^ (spin ^ spins[site.neighbs[5]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -4559,56 +4639,56 @@ private:
 
 		if (r >= sched.r1) {
 			word_type mask = (b1 & b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r3) {
 			word_type mask = ((b0 | b1) & b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r5) {
 			word_type mask = b2 | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r7) {
 			word_type mask = ((b0 & b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r9) {
 			word_type mask = (b1 | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r11) {
 			word_type mask = ((b0 | b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 	#endif
 
 	// machine-generated code; do not edit
 	#ifdef USE_6_NEIGHB
-	void update_site6_222222(site_type& site, const sched_type& sched)
+	void update_site6_222222(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
 		word_type c, s;
 
 		word_type b0 = 0, b1 = 0, b2 = 0, b3 = 0;
 
-		c = site.jzw1[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		c = site.jzw1[0] ^ (spin ^ spins[site.neighbs[0]]);
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw1[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw1[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw1[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw1[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw1[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw1[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -4617,7 +4697,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw1[4] ^ (spin ^ sites[site.neighbs[4]].spin);
+		c = site.jzw1[4] ^ (spin ^ spins[site.neighbs[4]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -4626,7 +4706,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw1[5] ^ (spin ^ sites[site.neighbs[5]].spin);
+		c = site.jzw1[5] ^ (spin ^ spins[site.neighbs[5]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -4638,47 +4718,47 @@ private:
 
 		if (r >= sched.r4) {
 			word_type mask = ((b0 | b1) & b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r8) {
 			word_type mask = ((b0 & b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r12) {
 			word_type mask = ((b0 | b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 	#endif
 
 	// machine-generated code; do not edit
 	#ifdef USE_6_NEIGHB
-	void update_site6_111113(site_type& site, const sched_type& sched)
+	void update_site6_111113(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
 		word_type c, s;
 
 		word_type b0 = 0, b1 = 0, b2 = 0, b3 = 0;
 
-		c = site.jzw0[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		c = site.jzw0[0] ^ (spin ^ spins[site.neighbs[0]]);
 		s = b0 ^ c;
 		b0 = s;
-		c = site.jzw0[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw0[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw0[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw0[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw0[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw0[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -4687,7 +4767,7 @@ private:
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw0[4] ^ (spin ^ sites[site.neighbs[4]].spin);
+		c = site.jzw0[4] ^ (spin ^ spins[site.neighbs[4]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -4696,7 +4776,7 @@ private:
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw0[5] ^ (spin ^ sites[site.neighbs[5]].spin);
+		c = site.jzw0[5] ^ (spin ^ spins[site.neighbs[5]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -4708,7 +4788,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw1[5] ^ (spin ^ sites[site.neighbs[5]].spin);
+		c = site.jzw1[5] ^ (spin ^ spins[site.neighbs[5]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -4720,50 +4800,50 @@ private:
 
 		if (r >= sched.r2) {
 			word_type mask = b2 | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r4) {
 			word_type mask = ((b0 & b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r6) {
 			word_type mask = (b1 | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r8) {
 			word_type mask = ((b0 | b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 	#endif
 
 	// machine-generated code; do not edit
 	#ifdef USE_6_NEIGHB
-	void update_site6_111123(site_type& site, const sched_type& sched)
+	void update_site6_111123(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
 		word_type c, s;
 
 		word_type b0 = 0, b1 = 0, b2 = 0, b3 = 0;
 
-		c = site.jzw0[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		c = site.jzw0[0] ^ (spin ^ spins[site.neighbs[0]]);
 		s = b0 ^ c;
 		b0 = s;
-		c = site.jzw0[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw0[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw0[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw0[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw0[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw0[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -4772,13 +4852,13 @@ private:
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw1[4] ^ (spin ^ sites[site.neighbs[4]].spin);
+		c = site.jzw1[4] ^ (spin ^ spins[site.neighbs[4]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw0[5] ^ (spin ^ sites[site.neighbs[5]].spin);
+		c = site.jzw0[5] ^ (spin ^ spins[site.neighbs[5]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -4790,7 +4870,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw1[5] ^ (spin ^ sites[site.neighbs[5]].spin);
+		c = site.jzw1[5] ^ (spin ^ spins[site.neighbs[5]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -4802,65 +4882,65 @@ private:
 
 		if (r >= sched.r1) {
 			word_type mask = ((b0 | b1) & b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r3) {
 			word_type mask = b2 | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r5) {
 			word_type mask = ((b0 & b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r7) {
 			word_type mask = (b1 | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r9) {
 			word_type mask = ((b0 | b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 	#endif
 
 	// machine-generated code; do not edit
 	#ifdef USE_6_NEIGHB
-	void update_site6_111223(site_type& site, const sched_type& sched)
+	void update_site6_111223(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
 		word_type c, s;
 
 		word_type b0 = 0, b1 = 0, b2 = 0, b3 = 0;
 
-		c = site.jzw0[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		c = site.jzw0[0] ^ (spin ^ spins[site.neighbs[0]]);
 		s = b0 ^ c;
 		b0 = s;
-		c = site.jzw0[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw0[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw0[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw0[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw1[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw1[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw1[4] ^ (spin ^ sites[site.neighbs[4]].spin);
+		c = site.jzw1[4] ^ (spin ^ spins[site.neighbs[4]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw0[5] ^ (spin ^ sites[site.neighbs[5]].spin);
+		c = site.jzw0[5] ^ (spin ^ spins[site.neighbs[5]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -4872,7 +4952,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw1[5] ^ (spin ^ sites[site.neighbs[5]].spin);
+		c = site.jzw1[5] ^ (spin ^ spins[site.neighbs[5]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -4884,59 +4964,59 @@ private:
 
 		if (r >= sched.r2) {
 			word_type mask = ((b0 | b1) & b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r4) {
 			word_type mask = b2 | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r6) {
 			word_type mask = ((b0 & b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r8) {
 			word_type mask = (b1 | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r10) {
 			word_type mask = ((b0 | b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 	#endif
 
 	// machine-generated code; do not edit
 	#ifdef USE_6_NEIGHB
-	void update_site6_112223(site_type& site, const sched_type& sched)
+	void update_site6_112223(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
 		word_type c, s;
 
 		word_type b0 = 0, b1 = 0, b2 = 0, b3 = 0;
 
-		c = site.jzw0[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		c = site.jzw0[0] ^ (spin ^ spins[site.neighbs[0]]);
 		s = b0 ^ c;
 		b0 = s;
-		c = site.jzw0[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw0[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw1[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw1[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw1[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw1[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw1[4] ^ (spin ^ sites[site.neighbs[4]].spin);
+		c = site.jzw1[4] ^ (spin ^ spins[site.neighbs[4]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -4945,7 +5025,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw0[5] ^ (spin ^ sites[site.neighbs[5]].spin);
+		c = site.jzw0[5] ^ (spin ^ spins[site.neighbs[5]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -4957,7 +5037,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw1[5] ^ (spin ^ sites[site.neighbs[5]].spin);
+		c = site.jzw1[5] ^ (spin ^ spins[site.neighbs[5]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -4969,59 +5049,59 @@ private:
 
 		if (r >= sched.r1) {
 			word_type mask = (b1 & b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r3) {
 			word_type mask = ((b0 | b1) & b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r5) {
 			word_type mask = b2 | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r7) {
 			word_type mask = ((b0 & b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r9) {
 			word_type mask = (b1 | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r11) {
 			word_type mask = ((b0 | b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 	#endif
 
 	// machine-generated code; do not edit
 	#ifdef USE_6_NEIGHB
-	void update_site6_122223(site_type& site, const sched_type& sched)
+	void update_site6_122223(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
 		word_type c, s;
 
 		word_type b0 = 0, b1 = 0, b2 = 0, b3 = 0;
 
-		c = site.jzw0[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		c = site.jzw0[0] ^ (spin ^ spins[site.neighbs[0]]);
 		s = b0 ^ c;
 		b0 = s;
-		c = site.jzw1[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw1[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw1[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw1[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw1[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw1[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw1[4] ^ (spin ^ sites[site.neighbs[4]].spin);
+		c = site.jzw1[4] ^ (spin ^ spins[site.neighbs[4]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -5030,7 +5110,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw0[5] ^ (spin ^ sites[site.neighbs[5]].spin);
+		c = site.jzw0[5] ^ (spin ^ spins[site.neighbs[5]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -5042,7 +5122,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw1[5] ^ (spin ^ sites[site.neighbs[5]].spin);
+		c = site.jzw1[5] ^ (spin ^ spins[site.neighbs[5]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -5054,56 +5134,56 @@ private:
 
 		if (r >= sched.r2) {
 			word_type mask = (b1 & b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r4) {
 			word_type mask = ((b0 | b1) & b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r6) {
 			word_type mask = b2 | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r8) {
 			word_type mask = ((b0 & b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r10) {
 			word_type mask = (b1 | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r12) {
 			word_type mask = ((b0 | b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 	#endif
 
 	// machine-generated code; do not edit
 	#ifdef USE_6_NEIGHB
-	void update_site6_222223(site_type& site, const sched_type& sched)
+	void update_site6_222223(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
 		word_type c, s;
 
 		word_type b0 = 0, b1 = 0, b2 = 0, b3 = 0;
 
-		c = site.jzw1[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		c = site.jzw1[0] ^ (spin ^ spins[site.neighbs[0]]);
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw1[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw1[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw1[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw1[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw1[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw1[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -5112,7 +5192,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw1[4] ^ (spin ^ sites[site.neighbs[4]].spin);
+		c = site.jzw1[4] ^ (spin ^ spins[site.neighbs[4]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -5121,7 +5201,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw0[5] ^ (spin ^ sites[site.neighbs[5]].spin);
+		c = site.jzw0[5] ^ (spin ^ spins[site.neighbs[5]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -5133,7 +5213,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw1[5] ^ (spin ^ sites[site.neighbs[5]].spin);
+		c = site.jzw1[5] ^ (spin ^ spins[site.neighbs[5]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -5145,56 +5225,56 @@ private:
 
 		if (r >= sched.r1) {
 			word_type mask = ((b0 & b1) & b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r3) {
 			word_type mask = (b1 & b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r5) {
 			word_type mask = ((b0 | b1) & b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r7) {
 			word_type mask = b2 | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r9) {
 			word_type mask = ((b0 & b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r13) {
 			word_type mask = ((b0 | b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 	#endif
 
 	// machine-generated code; do not edit
 	#ifdef USE_6_NEIGHB
-	void update_site6_111133(site_type& site, const sched_type& sched)
+	void update_site6_111133(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
 		word_type c, s;
 
 		word_type b0 = 0, b1 = 0, b2 = 0, b3 = 0;
 
-		c = site.jzw0[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		c = site.jzw0[0] ^ (spin ^ spins[site.neighbs[0]]);
 		s = b0 ^ c;
 		b0 = s;
-		c = site.jzw0[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw0[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw0[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw0[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw0[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw0[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -5203,7 +5283,7 @@ private:
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw0[4] ^ (spin ^ sites[site.neighbs[4]].spin);
+		c = site.jzw0[4] ^ (spin ^ spins[site.neighbs[4]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -5212,13 +5292,13 @@ private:
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw1[4] ^ (spin ^ sites[site.neighbs[4]].spin);
+		c = site.jzw1[4] ^ (spin ^ spins[site.neighbs[4]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw0[5] ^ (spin ^ sites[site.neighbs[5]].spin);
+		c = site.jzw0[5] ^ (spin ^ spins[site.neighbs[5]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -5230,7 +5310,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw1[5] ^ (spin ^ sites[site.neighbs[5]].spin);
+		c = site.jzw1[5] ^ (spin ^ spins[site.neighbs[5]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -5242,59 +5322,59 @@ private:
 
 		if (r >= sched.r2) {
 			word_type mask = ((b0 | b1) & b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r4) {
 			word_type mask = b2 | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r6) {
 			word_type mask = ((b0 & b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r8) {
 			word_type mask = (b1 | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r10) {
 			word_type mask = ((b0 | b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 	#endif
 
 	// machine-generated code; do not edit
 	#ifdef USE_6_NEIGHB
-	void update_site6_111233(site_type& site, const sched_type& sched)
+	void update_site6_111233(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
 		word_type c, s;
 
 		word_type b0 = 0, b1 = 0, b2 = 0, b3 = 0;
 
-		c = site.jzw0[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		c = site.jzw0[0] ^ (spin ^ spins[site.neighbs[0]]);
 		s = b0 ^ c;
 		b0 = s;
-		c = site.jzw0[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw0[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw0[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw0[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw1[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw1[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw0[4] ^ (spin ^ sites[site.neighbs[4]].spin);
+		c = site.jzw0[4] ^ (spin ^ spins[site.neighbs[4]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -5306,7 +5386,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw1[4] ^ (spin ^ sites[site.neighbs[4]].spin);
+		c = site.jzw1[4] ^ (spin ^ spins[site.neighbs[4]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -5315,7 +5395,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw0[5] ^ (spin ^ sites[site.neighbs[5]].spin);
+		c = site.jzw0[5] ^ (spin ^ spins[site.neighbs[5]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -5327,7 +5407,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw1[5] ^ (spin ^ sites[site.neighbs[5]].spin);
+		c = site.jzw1[5] ^ (spin ^ spins[site.neighbs[5]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -5339,62 +5419,62 @@ private:
 
 		if (r >= sched.r1) {
 			word_type mask = (b1 & b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r3) {
 			word_type mask = ((b0 | b1) & b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r5) {
 			word_type mask = b2 | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r7) {
 			word_type mask = ((b0 & b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r9) {
 			word_type mask = (b1 | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r11) {
 			word_type mask = ((b0 | b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 	#endif
 
 	// machine-generated code; do not edit
 	#ifdef USE_6_NEIGHB
-	void update_site6_112233(site_type& site, const sched_type& sched)
+	void update_site6_112233(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
 		word_type c, s;
 
 		word_type b0 = 0, b1 = 0, b2 = 0, b3 = 0;
 
-		c = site.jzw0[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		c = site.jzw0[0] ^ (spin ^ spins[site.neighbs[0]]);
 		s = b0 ^ c;
 		b0 = s;
-		c = site.jzw0[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw0[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw1[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw1[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw1[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw1[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw0[4] ^ (spin ^ sites[site.neighbs[4]].spin);
+		c = site.jzw0[4] ^ (spin ^ spins[site.neighbs[4]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -5406,7 +5486,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw1[4] ^ (spin ^ sites[site.neighbs[4]].spin);
+		c = site.jzw1[4] ^ (spin ^ spins[site.neighbs[4]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -5415,7 +5495,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw0[5] ^ (spin ^ sites[site.neighbs[5]].spin);
+		c = site.jzw0[5] ^ (spin ^ spins[site.neighbs[5]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -5427,7 +5507,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw1[5] ^ (spin ^ sites[site.neighbs[5]].spin);
+		c = site.jzw1[5] ^ (spin ^ spins[site.neighbs[5]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -5439,59 +5519,59 @@ private:
 
 		if (r >= sched.r2) {
 			word_type mask = (b1 & b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r4) {
 			word_type mask = ((b0 | b1) & b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r6) {
 			word_type mask = b2 | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r8) {
 			word_type mask = ((b0 & b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r10) {
 			word_type mask = (b1 | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r12) {
 			word_type mask = ((b0 | b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 	#endif
 
 	// machine-generated code; do not edit
 	#ifdef USE_6_NEIGHB
-	void update_site6_122233(site_type& site, const sched_type& sched)
+	void update_site6_122233(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
 		word_type c, s;
 
 		word_type b0 = 0, b1 = 0, b2 = 0, b3 = 0;
 
-		c = site.jzw0[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		c = site.jzw0[0] ^ (spin ^ spins[site.neighbs[0]]);
 		s = b0 ^ c;
 		b0 = s;
-		c = site.jzw1[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw1[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw1[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw1[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw1[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw1[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw0[4] ^ (spin ^ sites[site.neighbs[4]].spin);
+		c = site.jzw0[4] ^ (spin ^ spins[site.neighbs[4]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -5503,7 +5583,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw1[4] ^ (spin ^ sites[site.neighbs[4]].spin);
+		c = site.jzw1[4] ^ (spin ^ spins[site.neighbs[4]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -5512,7 +5592,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw0[5] ^ (spin ^ sites[site.neighbs[5]].spin);
+		c = site.jzw0[5] ^ (spin ^ spins[site.neighbs[5]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -5524,7 +5604,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw1[5] ^ (spin ^ sites[site.neighbs[5]].spin);
+		c = site.jzw1[5] ^ (spin ^ spins[site.neighbs[5]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -5536,59 +5616,59 @@ private:
 
 		if (r >= sched.r1) {
 			word_type mask = ((b0 & b1) & b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r3) {
 			word_type mask = (b1 & b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r5) {
 			word_type mask = ((b0 | b1) & b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r7) {
 			word_type mask = b2 | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r9) {
 			word_type mask = ((b0 & b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r11) {
 			word_type mask = (b1 | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r13) {
 			word_type mask = ((b0 | b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 	#endif
 
 	// machine-generated code; do not edit
 	#ifdef USE_6_NEIGHB
-	void update_site6_222233(site_type& site, const sched_type& sched)
+	void update_site6_222233(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
 		word_type c, s;
 
 		word_type b0 = 0, b1 = 0, b2 = 0, b3 = 0;
 
-		c = site.jzw1[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		c = site.jzw1[0] ^ (spin ^ spins[site.neighbs[0]]);
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw1[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw1[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw1[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw1[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw1[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw1[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -5597,7 +5677,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw0[4] ^ (spin ^ sites[site.neighbs[4]].spin);
+		c = site.jzw0[4] ^ (spin ^ spins[site.neighbs[4]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -5609,7 +5689,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw1[4] ^ (spin ^ sites[site.neighbs[4]].spin);
+		c = site.jzw1[4] ^ (spin ^ spins[site.neighbs[4]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -5618,7 +5698,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw0[5] ^ (spin ^ sites[site.neighbs[5]].spin);
+		c = site.jzw0[5] ^ (spin ^ spins[site.neighbs[5]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -5630,7 +5710,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw1[5] ^ (spin ^ sites[site.neighbs[5]].spin);
+		c = site.jzw1[5] ^ (spin ^ spins[site.neighbs[5]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -5642,56 +5722,56 @@ private:
 
 		if (r >= sched.r2) {
 			word_type mask = ((b0 & b1) & b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r4) {
 			word_type mask = (b1 & b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r6) {
 			word_type mask = ((b0 | b1) & b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r8) {
 			word_type mask = b2 | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r10) {
 			word_type mask = ((b0 & b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r14) {
 			word_type mask = ((b0 | b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 	#endif
 
 	// machine-generated code; do not edit
 	#ifdef USE_6_NEIGHB
-	void update_site6_111333(site_type& site, const sched_type& sched)
+	void update_site6_111333(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
 		word_type c, s;
 
 		word_type b0 = 0, b1 = 0, b2 = 0, b3 = 0;
 
-		c = site.jzw0[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		c = site.jzw0[0] ^ (spin ^ spins[site.neighbs[0]]);
 		s = b0 ^ c;
 		b0 = s;
-		c = site.jzw0[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw0[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw0[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw0[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw0[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw0[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -5700,13 +5780,13 @@ private:
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw1[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw1[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw0[4] ^ (spin ^ sites[site.neighbs[4]].spin);
+		c = site.jzw0[4] ^ (spin ^ spins[site.neighbs[4]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -5718,7 +5798,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw1[4] ^ (spin ^ sites[site.neighbs[4]].spin);
+		c = site.jzw1[4] ^ (spin ^ spins[site.neighbs[4]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -5727,7 +5807,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw0[5] ^ (spin ^ sites[site.neighbs[5]].spin);
+		c = site.jzw0[5] ^ (spin ^ spins[site.neighbs[5]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -5739,7 +5819,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw1[5] ^ (spin ^ sites[site.neighbs[5]].spin);
+		c = site.jzw1[5] ^ (spin ^ spins[site.neighbs[5]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -5751,56 +5831,56 @@ private:
 
 		if (r >= sched.r2) {
 			word_type mask = (b1 & b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r4) {
 			word_type mask = ((b0 | b1) & b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r6) {
 			word_type mask = b2 | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r8) {
 			word_type mask = ((b0 & b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r10) {
 			word_type mask = (b1 | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r12) {
 			word_type mask = ((b0 | b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 	#endif
 
 	// machine-generated code; do not edit
 	#ifdef USE_6_NEIGHB
-	void update_site6_112333(site_type& site, const sched_type& sched)
+	void update_site6_112333(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
 		word_type c, s;
 
 		word_type b0 = 0, b1 = 0, b2 = 0, b3 = 0;
 
-		c = site.jzw0[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		c = site.jzw0[0] ^ (spin ^ spins[site.neighbs[0]]);
 		s = b0 ^ c;
 		b0 = s;
-		c = site.jzw0[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw0[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw1[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw1[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw0[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw0[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -5809,13 +5889,13 @@ private:
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw1[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw1[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw0[4] ^ (spin ^ sites[site.neighbs[4]].spin);
+		c = site.jzw0[4] ^ (spin ^ spins[site.neighbs[4]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -5827,7 +5907,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw1[4] ^ (spin ^ sites[site.neighbs[4]].spin);
+		c = site.jzw1[4] ^ (spin ^ spins[site.neighbs[4]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -5836,7 +5916,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw0[5] ^ (spin ^ sites[site.neighbs[5]].spin);
+		c = site.jzw0[5] ^ (spin ^ spins[site.neighbs[5]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -5848,7 +5928,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw1[5] ^ (spin ^ sites[site.neighbs[5]].spin);
+		c = site.jzw1[5] ^ (spin ^ spins[site.neighbs[5]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -5860,56 +5940,56 @@ private:
 
 		if (r >= sched.r1) {
 			word_type mask = ((b0 & b1) & b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r3) {
 			word_type mask = (b1 & b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r5) {
 			word_type mask = ((b0 | b1) & b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r7) {
 			word_type mask = b2 | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r9) {
 			word_type mask = ((b0 & b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r11) {
 			word_type mask = (b1 | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r13) {
 			word_type mask = ((b0 | b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 	#endif
 
 	// machine-generated code; do not edit
 	#ifdef USE_6_NEIGHB
-	void update_site6_122333(site_type& site, const sched_type& sched)
+	void update_site6_122333(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
 		word_type c, s;
 
 		word_type b0 = 0, b1 = 0, b2 = 0, b3 = 0;
 
-		c = site.jzw0[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		c = site.jzw0[0] ^ (spin ^ spins[site.neighbs[0]]);
 		s = b0 ^ c;
 		b0 = s;
-		c = site.jzw1[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw1[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw1[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw1[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw0[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw0[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -5921,7 +6001,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw1[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw1[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -5930,7 +6010,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw0[4] ^ (spin ^ sites[site.neighbs[4]].spin);
+		c = site.jzw0[4] ^ (spin ^ spins[site.neighbs[4]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -5942,7 +6022,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw1[4] ^ (spin ^ sites[site.neighbs[4]].spin);
+		c = site.jzw1[4] ^ (spin ^ spins[site.neighbs[4]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -5951,7 +6031,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw0[5] ^ (spin ^ sites[site.neighbs[5]].spin);
+		c = site.jzw0[5] ^ (spin ^ spins[site.neighbs[5]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -5963,7 +6043,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw1[5] ^ (spin ^ sites[site.neighbs[5]].spin);
+		c = site.jzw1[5] ^ (spin ^ spins[site.neighbs[5]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -5975,59 +6055,59 @@ private:
 
 		if (r >= sched.r2) {
 			word_type mask = ((b0 & b1) & b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r4) {
 			word_type mask = (b1 & b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r6) {
 			word_type mask = ((b0 | b1) & b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r8) {
 			word_type mask = b2 | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r10) {
 			word_type mask = ((b0 & b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r12) {
 			word_type mask = (b1 | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r14) {
 			word_type mask = ((b0 | b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 	#endif
 
 	// machine-generated code; do not edit
 	#ifdef USE_6_NEIGHB
-	void update_site6_222333(site_type& site, const sched_type& sched)
+	void update_site6_222333(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
 		word_type c, s;
 
 		word_type b0 = 0, b1 = 0, b2 = 0, b3 = 0;
 
-		c = site.jzw1[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		c = site.jzw1[0] ^ (spin ^ spins[site.neighbs[0]]);
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw1[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw1[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw1[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw1[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw0[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw0[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -6039,7 +6119,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw1[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw1[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -6048,7 +6128,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw0[4] ^ (spin ^ sites[site.neighbs[4]].spin);
+		c = site.jzw0[4] ^ (spin ^ spins[site.neighbs[4]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -6060,7 +6140,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw1[4] ^ (spin ^ sites[site.neighbs[4]].spin);
+		c = site.jzw1[4] ^ (spin ^ spins[site.neighbs[4]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -6069,7 +6149,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw0[5] ^ (spin ^ sites[site.neighbs[5]].spin);
+		c = site.jzw0[5] ^ (spin ^ spins[site.neighbs[5]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -6081,7 +6161,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw1[5] ^ (spin ^ sites[site.neighbs[5]].spin);
+		c = site.jzw1[5] ^ (spin ^ spins[site.neighbs[5]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -6093,53 +6173,53 @@ private:
 
 		if (r >= sched.r1) {
 			word_type mask = b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r3) {
 			word_type mask = ((b0 & b1) & b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r5) {
 			word_type mask = (b1 & b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r7) {
 			word_type mask = ((b0 | b1) & b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r9) {
 			word_type mask = b2 | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r11) {
 			word_type mask = ((b0 & b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r15) {
 			word_type mask = ((b0 | b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 	#endif
 
 	// machine-generated code; do not edit
 	#ifdef USE_6_NEIGHB
-	void update_site6_113333(site_type& site, const sched_type& sched)
+	void update_site6_113333(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
 		word_type c, s;
 
 		word_type b0 = 0, b1 = 0, b2 = 0, b3 = 0;
 
-		c = site.jzw0[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		c = site.jzw0[0] ^ (spin ^ spins[site.neighbs[0]]);
 		s = b0 ^ c;
 		b0 = s;
-		c = site.jzw0[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw0[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw0[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw0[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -6148,13 +6228,13 @@ private:
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw1[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw1[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw0[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw0[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -6166,7 +6246,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw1[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw1[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -6175,7 +6255,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw0[4] ^ (spin ^ sites[site.neighbs[4]].spin);
+		c = site.jzw0[4] ^ (spin ^ spins[site.neighbs[4]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -6187,7 +6267,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw1[4] ^ (spin ^ sites[site.neighbs[4]].spin);
+		c = site.jzw1[4] ^ (spin ^ spins[site.neighbs[4]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -6196,7 +6276,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw0[5] ^ (spin ^ sites[site.neighbs[5]].spin);
+		c = site.jzw0[5] ^ (spin ^ spins[site.neighbs[5]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -6208,7 +6288,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw1[5] ^ (spin ^ sites[site.neighbs[5]].spin);
+		c = site.jzw1[5] ^ (spin ^ spins[site.neighbs[5]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -6220,50 +6300,50 @@ private:
 
 		if (r >= sched.r2) {
 			word_type mask = ((b0 & b1) & b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r4) {
 			word_type mask = (b1 & b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r6) {
 			word_type mask = ((b0 | b1) & b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r8) {
 			word_type mask = b2 | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r10) {
 			word_type mask = ((b0 & b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r12) {
 			word_type mask = (b1 | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r14) {
 			word_type mask = ((b0 | b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 	#endif
 
 	// machine-generated code; do not edit
 	#ifdef USE_6_NEIGHB
-	void update_site6_123333(site_type& site, const sched_type& sched)
+	void update_site6_123333(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
 		word_type c, s;
 
 		word_type b0 = 0, b1 = 0, b2 = 0, b3 = 0;
 
-		c = site.jzw0[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		c = site.jzw0[0] ^ (spin ^ spins[site.neighbs[0]]);
 		s = b0 ^ c;
 		b0 = s;
-		c = site.jzw1[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw1[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw0[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw0[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -6272,13 +6352,13 @@ private:
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw1[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw1[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw0[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw0[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -6290,7 +6370,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw1[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw1[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -6299,7 +6379,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw0[4] ^ (spin ^ sites[site.neighbs[4]].spin);
+		c = site.jzw0[4] ^ (spin ^ spins[site.neighbs[4]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -6311,7 +6391,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw1[4] ^ (spin ^ sites[site.neighbs[4]].spin);
+		c = site.jzw1[4] ^ (spin ^ spins[site.neighbs[4]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -6320,7 +6400,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw0[5] ^ (spin ^ sites[site.neighbs[5]].spin);
+		c = site.jzw0[5] ^ (spin ^ spins[site.neighbs[5]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -6332,7 +6412,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw1[5] ^ (spin ^ sites[site.neighbs[5]].spin);
+		c = site.jzw1[5] ^ (spin ^ spins[site.neighbs[5]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -6344,56 +6424,56 @@ private:
 
 		if (r >= sched.r1) {
 			word_type mask = b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r3) {
 			word_type mask = ((b0 & b1) & b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r5) {
 			word_type mask = (b1 & b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r7) {
 			word_type mask = ((b0 | b1) & b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r9) {
 			word_type mask = b2 | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r11) {
 			word_type mask = ((b0 & b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r13) {
 			word_type mask = (b1 | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r15) {
 			word_type mask = ((b0 | b1) | b2) | b3;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 	#endif
 
 	// machine-generated code; do not edit
 	#ifdef USE_6_NEIGHB
-	void update_site6_223333(site_type& site, const sched_type& sched)
+	void update_site6_223333(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
 		word_type c, s;
 
 		word_type b0 = 0, b1 = 0, b2 = 0, b3 = 0, b4 = 0;
 
-		c = site.jzw1[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		c = site.jzw1[0] ^ (spin ^ spins[site.neighbs[0]]);
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw1[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw1[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw0[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw0[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -6402,13 +6482,13 @@ private:
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw1[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw1[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw0[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw0[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -6420,7 +6500,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw1[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw1[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -6429,7 +6509,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw0[4] ^ (spin ^ sites[site.neighbs[4]].spin);
+		c = site.jzw0[4] ^ (spin ^ spins[site.neighbs[4]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -6441,7 +6521,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw1[4] ^ (spin ^ sites[site.neighbs[4]].spin);
+		c = site.jzw1[4] ^ (spin ^ spins[site.neighbs[4]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -6450,7 +6530,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw0[5] ^ (spin ^ sites[site.neighbs[5]].spin);
+		c = site.jzw0[5] ^ (spin ^ spins[site.neighbs[5]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -6465,7 +6545,7 @@ private:
 		b3 = s;
 		s = b4 ^ c;
 		b4 = s;
-		c = site.jzw1[5] ^ (spin ^ sites[site.neighbs[5]].spin);
+		c = site.jzw1[5] ^ (spin ^ spins[site.neighbs[5]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -6480,47 +6560,47 @@ private:
 
 		if (r >= sched.r2) {
 			word_type mask = b3 | b4;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r4) {
 			word_type mask = (((b0 & b1) & b2) | b3) | b4;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r6) {
 			word_type mask = ((b1 & b2) | b3) | b4;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r8) {
 			word_type mask = (((b0 | b1) & b2) | b3) | b4;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r10) {
 			word_type mask = (b2 | b3) | b4;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r12) {
 			word_type mask = (((b0 & b1) | b2) | b3) | b4;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r16) {
 			word_type mask = (((b0 | b1) | b2) | b3) | b4;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 	#endif
 
 	// machine-generated code; do not edit
 	#ifdef USE_6_NEIGHB
-	void update_site6_133333(site_type& site, const sched_type& sched)
+	void update_site6_133333(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
 		word_type c, s;
 
 		word_type b0 = 0, b1 = 0, b2 = 0, b3 = 0, b4 = 0;
 
-		c = site.jzw0[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		c = site.jzw0[0] ^ (spin ^ spins[site.neighbs[0]]);
 		s = b0 ^ c;
 		b0 = s;
-		c = site.jzw0[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw0[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -6529,13 +6609,13 @@ private:
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw1[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw1[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw0[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw0[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -6544,13 +6624,13 @@ private:
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw1[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw1[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw0[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw0[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -6562,7 +6642,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw1[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw1[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -6571,7 +6651,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw0[4] ^ (spin ^ sites[site.neighbs[4]].spin);
+		c = site.jzw0[4] ^ (spin ^ spins[site.neighbs[4]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -6583,7 +6663,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw1[4] ^ (spin ^ sites[site.neighbs[4]].spin);
+		c = site.jzw1[4] ^ (spin ^ spins[site.neighbs[4]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -6592,7 +6672,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw0[5] ^ (spin ^ sites[site.neighbs[5]].spin);
+		c = site.jzw0[5] ^ (spin ^ spins[site.neighbs[5]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -6607,7 +6687,7 @@ private:
 		b3 = s;
 		s = b4 ^ c;
 		b4 = s;
-		c = site.jzw1[5] ^ (spin ^ sites[site.neighbs[5]].spin);
+		c = site.jzw1[5] ^ (spin ^ spins[site.neighbs[5]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -6622,44 +6702,44 @@ private:
 
 		if (r >= sched.r2) {
 			word_type mask = b3 | b4;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r4) {
 			word_type mask = (((b0 & b1) & b2) | b3) | b4;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r8) {
 			word_type mask = (((b0 | b1) & b2) | b3) | b4;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r10) {
 			word_type mask = (b2 | b3) | b4;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r14) {
 			word_type mask = ((b1 | b2) | b3) | b4;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r16) {
 			word_type mask = (((b0 | b1) | b2) | b3) | b4;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 	#endif
 
 	// machine-generated code; do not edit
 	#ifdef USE_6_NEIGHB
-	void update_site6_233333(site_type& site, const sched_type& sched)
+	void update_site6_233333(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
 		word_type c, s;
 
 		word_type b0 = 0, b1 = 0, b2 = 0, b3 = 0, b4 = 0;
 
-		c = site.jzw1[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		c = site.jzw1[0] ^ (spin ^ spins[site.neighbs[0]]);
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw0[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw0[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -6668,13 +6748,13 @@ private:
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw1[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw1[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw0[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw0[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -6686,7 +6766,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw1[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw1[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -6695,7 +6775,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw0[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw0[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -6707,7 +6787,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw1[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw1[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -6716,7 +6796,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw0[4] ^ (spin ^ sites[site.neighbs[4]].spin);
+		c = site.jzw0[4] ^ (spin ^ spins[site.neighbs[4]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -6728,7 +6808,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw1[4] ^ (spin ^ sites[site.neighbs[4]].spin);
+		c = site.jzw1[4] ^ (spin ^ spins[site.neighbs[4]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -6737,7 +6817,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw0[5] ^ (spin ^ sites[site.neighbs[5]].spin);
+		c = site.jzw0[5] ^ (spin ^ spins[site.neighbs[5]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -6752,7 +6832,7 @@ private:
 		b3 = s;
 		s = b4 ^ c;
 		b4 = s;
-		c = site.jzw1[5] ^ (spin ^ sites[site.neighbs[5]].spin);
+		c = site.jzw1[5] ^ (spin ^ spins[site.neighbs[5]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -6767,50 +6847,50 @@ private:
 
 		if (r >= sched.r1) {
 			word_type mask = (((b0 | b1) | b2) & b3) | b4;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r5) {
 			word_type mask = (((b0 & b1) & b2) | b3) | b4;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r7) {
 			word_type mask = ((b1 & b2) | b3) | b4;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r11) {
 			word_type mask = (b2 | b3) | b4;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r13) {
 			word_type mask = (((b0 & b1) | b2) | b3) | b4;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r17) {
 			word_type mask = (((b0 | b1) | b2) | b3) | b4;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 	#endif
 
 	// machine-generated code; do not edit
 	#ifdef USE_6_NEIGHB
-	void update_site6_333333(site_type& site, const sched_type& sched)
+	void update_site6_333333(std::size_t i, const site_type& site, const sched_type& sched)
 	{
-		unsigned r = bgen() >> (word_size - depth);
-		word_type spin = site.spin;
+		unsigned r = bgen() >> (rand_bits - depth);
+		word_type spin = spins[i];
 
 		word_type c, s;
 
 		word_type b0 = 0, b1 = 0, b2 = 0, b3 = 0, b4 = 0;
 
-		c = site.jzw0[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		c = site.jzw0[0] ^ (spin ^ spins[site.neighbs[0]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw1[0] ^ (spin ^ sites[site.neighbs[0]].spin);
+		c = site.jzw1[0] ^ (spin ^ spins[site.neighbs[0]]);
 		s = b1 ^ c;
 		b1 = s;
-		c = site.jzw0[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw0[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -6819,13 +6899,13 @@ private:
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw1[1] ^ (spin ^ sites[site.neighbs[1]].spin);
+		c = site.jzw1[1] ^ (spin ^ spins[site.neighbs[1]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
 		s = b2 ^ c;
 		b2 = s;
-		c = site.jzw0[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw0[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -6837,7 +6917,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw1[2] ^ (spin ^ sites[site.neighbs[2]].spin);
+		c = site.jzw1[2] ^ (spin ^ spins[site.neighbs[2]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -6846,7 +6926,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw0[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw0[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -6858,7 +6938,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw1[3] ^ (spin ^ sites[site.neighbs[3]].spin);
+		c = site.jzw1[3] ^ (spin ^ spins[site.neighbs[3]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -6867,7 +6947,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw0[4] ^ (spin ^ sites[site.neighbs[4]].spin);
+		c = site.jzw0[4] ^ (spin ^ spins[site.neighbs[4]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -6879,7 +6959,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw1[4] ^ (spin ^ sites[site.neighbs[4]].spin);
+		c = site.jzw1[4] ^ (spin ^ spins[site.neighbs[4]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -6888,7 +6968,7 @@ private:
 		b2 = s;
 		s = b3 ^ c;
 		b3 = s;
-		c = site.jzw0[5] ^ (spin ^ sites[site.neighbs[5]].spin);
+		c = site.jzw0[5] ^ (spin ^ spins[site.neighbs[5]]);
 		s = b0 ^ c;
 		c = b0 & c;
 		b0 = s;
@@ -6903,7 +6983,7 @@ private:
 		b3 = s;
 		s = b4 ^ c;
 		b4 = s;
-		c = site.jzw1[5] ^ (spin ^ sites[site.neighbs[5]].spin);
+		c = site.jzw1[5] ^ (spin ^ spins[site.neighbs[5]]);
 		s = b1 ^ c;
 		c = b1 & c;
 		b1 = s;
@@ -6918,34 +6998,36 @@ private:
 
 		if (r >= sched.r6) {
 			word_type mask = (((b0 & b1) & b2) | b3) | b4;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r12) {
 			word_type mask = (b2 | b3) | b4;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else if (r >= sched.r18) {
 			word_type mask = (((b0 | b1) | b2) | b3) | b4;
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		} else {
 			word_type mask = word_type(-1);
-			site.spin = spin ^ mask;
+			spins[i] = spin ^ mask;
 		}
 	}
 	#endif
 
 	void calc_energies(std::vector<value_type>& en, std::size_t offs) const
 	{
+		const aligned_vector<site_type>& sites = model->sites;
+
 		for (unsigned k = 0; k < word_size; ++k)
 			for (std::size_t i = 0; i < sites.size(); ++i) {
 				const site_type& site = sites[i];
 
-				int spin = 2 * int((site.spin >> k) & 1) - 1;
+				int spin = 2 * int(word_bit(spins[i], k)) - 1;
 
 				value_type h = 0;
 				for (std::size_t l = 0; l < site.nneighbs; ++l) {
 					std::size_t j = site.neighbs[l];
 					if (i > j) continue;
 
-					int nspin = 2 * int((sites[j].spin >> k) & 1) - 1;
+					int nspin = 2 * int(word_bit(spins[j], k)) - 1;
 					h += site.jzv[l] * nspin;
 				}
 				h += site.hzv;
@@ -39,10 +39,12 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <set>
 #include <cassert>
 #include <iterator>
+#include <memory>
+#include <limits>
 
 #include "lattice.h"
-
-#define OMP_VERSION_2
+#include "thresholds.h"
+#include "utils.h"
 
 template<typename T = uint64_t>
   class Algorithm {
@@ -54,15 +56,30 @@ template<typename T = uint64_t>
 
  static const std::size_t word_size = 1;
 
+ // the neighbors of a site are neighbs[offs], ..., neighbs[offs +
+ // nneighbs - 1] of the model, with couplings jzv[offs], ...
  struct site_type{
-   int spin;
+   index_type nneighbs;
+   index_type offs;
+ };
+
+ struct lattice_site_type{
    value_type hzv;
    std::vector<value_type> jzv;
-   value_type de;
    index_type nneighbs;
    std::vector<index_type> neighbs;
  };
 
+ // couplings are shared by all copies of an instance
+ struct model_type{
+   aligned_vector<site_type> sites;
+   aligned_vector<index_type> neighbs;
+   aligned_vector<value_type> jzv;
+   // site i of the lattice is sites[pos[i]] if pos[i] < sites.size(),
+   // otherwise the site of sums[pos[i] - sites.size()]
+   std::vector<index_type> pos;
+ };
+
  typedef Lattice<value_type, index_type> lattice_type;
 
  Algorithm() {}
@@ -71,7 +88,12 @@ template<typename T = uint64_t>
  Algorithm(const lattice_type& lattice, const std::vector<SE>& sched0)
  : generator(41)
  {
-   std::vector<site_type> sites0;
+   std::shared_ptr<model_type> m = std::make_shared<model_type>();
+   aligned_vector<site_type>& sites = m->sites;
+   aligned_vector<index_type>& neighbs = m->neighbs;
+   aligned_vector<value_type>& jzv = m->jzv;
+
+   std::vector<lattice_site_type> sites0;
    lattice.init_sites(sites0);
 
    std::set<index_type> bin0, bin1;
@@ -108,7 +130,7 @@ template<typename T = uint64_t>
    for(const auto& site : sites0)
      max_edge += std::fabs(site.hzv);
 
-   site_type sf0;
+   lattice_site_type sf0 = lattice_site_type();
    for(const auto s1 : bin1){
      sf0.jzv.push_back(sites0[s1].hzv);
      sf0.neighbs.push_back(s1);
@@ -119,7 +141,7 @@ template<typename T = uint64_t>
      ++sites0[s1].nneighbs;
    }
 
-   site_type sf1;
+   lattice_site_type sf1 = lattice_site_type();
    for(const auto s0 : bin0){
      sf1.jzv.push_back(sites0[s0].hzv);
      sf1.neighbs.push_back(s0);
@@ -144,6 +166,13 @@ template<typename T = uint64_t>
    bin0.insert(ind0);
    bin1.insert(ind1);
 
+   // the extra sites of the fields are not sites of the lattice
+   std::vector<index_type>& pos = m->pos;
+   pos.resize(ind0);
+   index_type ind = 0;
+   for(const auto s : bin0) if(s < pos.size()) pos[s] = ind++; else ++ind;
+   for(const auto s : bin1) if(s < pos.size()) pos[s] = ind++; else ++ind;
+
    for(auto& site : sites0)
      site.hzv = 0;
 
@@ -156,79 +185,103 @@ template<typename T = uint64_t>
        const index_type ind = std::distance(bin0.begin(),bin0.find(s0));
 
        sites[ind].nneighbs = sites0[s0].nneighbs;
+       sites[ind].offs = neighbs.size();
        for(index_type k = 0; k < sites0[s0].nneighbs; ++k){
-	 sites[ind].neighbs.push_back(std::distance(bin1.begin(),bin1.find(sites0[s0].neighbs[k])));
-	 sites[ind].jzv.push_back(sites0[s0].jzv[k]);
+	 neighbs.push_back(std::distance(bin1.begin(),bin1.find(sites0[s0].neighbs[k])));
+	 jzv.push_back(sites0[s0].jzv[k]);
        }
 
      }
 
    rng_ = std::bind(std::uniform_real_distribution<double>(0, 1), std::ref(generator));
 
-   bound_array.resize(sched0.size());
-
-   auto ba = bound_array.begin();
-   for(const auto& s : sched0){
+   thresholds = threshold_table(sched0, sites.size(), 1, false, rng_);
 
-     ba->resize(sites.size());
-     for(auto& a : *ba)
-       a = -std::log(rng_()) / s.beta;
-
-     ba++;
-   }
+   model = m;
+   spins.resize(sites.size());
 
  }
 
  void reset_sites(const std::size_t rep)
  {
    generator.seed(rep+1);
+   thresholds.start(rep);
+   nsweeps_done = 0;
 
-   for(auto& site : sites)
-     site.spin = 2 * ((generator() >> 29) & 1) - 1;
+   const auto& sites = model->sites;
+   const auto& neighbs = model->neighbs;
+   const auto& jzv = model->jzv;
+
+   for(auto& spin : spins)
+     spin = 2 * ((generator() >> 29) & 1) - 1;
 
    std::fill(sums.begin(),sums.end(),0.0);
-   for(const auto& site : sites)
-     for(index_type k = 0; k < site.nneighbs; ++k)
-       sums[site.neighbs[k]] += site.jzv[k] * site.spin;
+   for(std::size_t i = 0; i < sites.size(); ++i)
+     for(index_type k = 0; k < sites[i].nneighbs; ++k)
+       sums[neighbs[sites[i].offs + k]] += jzv[sites[i].offs + k] * spins[i];
+
+   energy = max_edge;
+   for(const auto& sum : sums)
+     energy -= std::fabs(sum);
+
+   best_energy = std::numeric_limits<value_type>::max();
  }
 
- value_type get_de(const site_type& site) const
+ value_type get_de(const site_type& site, const int spin) const
  {
+   const index_type* neighbs = &model->neighbs[site.offs];
+   const value_type* jzv = &model->jzv[site.offs];
+
    value_type de = 0;
    for(index_type k = 0; k < site.nneighbs; ++k)
-     de += std::fabs(sums[site.neighbs[k]]) - std::fabs(sums[site.neighbs[k]] - 2 * site.jzv[k] * site.spin);
+     de += std::fabs(sums[neighbs[k]]) - std::fabs(sums[neighbs[k]] - 2 * jzv[k] * spin);
 
    return de;
  }
 
- void flip_spin(site_type& site)
+ void flip_spin(const site_type& site, int& spin)
  {
-   site.spin = -site.spin;
+   const index_type* neighbs = &model->neighbs[site.offs];
+   const value_type* jzv = &model->jzv[site.offs];
+
+   spin = -spin;
    for(index_type k = 0; k < site.nneighbs; ++k)
-     sums[site.neighbs[k]] += 2 * site.jzv[k] * site.spin;
+     sums[neighbs[k]] += 2 * jzv[k] * spin;
  }
 
  void do_sweep(const std::size_t sweep)
  {
+   const auto& sites = model->sites;
    const std::size_t l = generator() % sites.size();
-   const auto& ba = bound_array[sweep];
+   const double* ba = thresholds.get(sweep, nsweeps_done++);
 
-   for(std::size_t i = 0; i<l; ++i)
-     if(get_de(sites[i]) < ba[i + sites.size() - l])
-       flip_spin(sites[i]);
+   for(std::size_t i = 0; i<l; ++i){
+     const value_type de = get_de(sites[i], spins[i]);
+     if(de < ba[i + sites.size() - l]){
+       flip_spin(sites[i], spins[i]);
+       energy += de;
+     }
+   }
 
-   for(std::size_t i = l; i<sites.size(); ++i)
-     if(get_de(sites[i]) < ba[i - l])
-       flip_spin(sites[i]);
+   for(std::size_t i = l; i<sites.size(); ++i){
+     const value_type de = get_de(sites[i], spins[i]);
+     if(de < ba[i - l]){
+       flip_spin(sites[i], spins[i]);
+       energy += de;
+     }
+   }
  }
 
  std::size_t get_energies(std::vector<value_type>& en, const std::size_t offs) const
  {
    std::vector<value_type> sums0(sums.size(),0.0);
 
-   for(const auto& site : sites)
-     for(index_type k = 0; k < site.nneighbs; ++k)
-       sums0[site.neighbs[k]] += site.jzv[k] * site.spin;
+   const auto& sites = model->sites;
+   const auto& neighbs = model->neighbs;
+   const auto& jzv = model->jzv;
+   for(std::size_t i = 0; i < sites.size(); ++i)
+     for(index_type k = 0; k < sites[i].nneighbs; ++k)
+       sums0[neighbs[sites[i].offs + k]] += jzv[sites[i].offs + k] * spins[i];
 
    value_type energy = 0.0;
    for(const auto& sum : sums0)
@@ -242,11 +295,84 @@ template<typename T = uint64_t>
 
  std::string get_info() const {return "algorithm: single-spin bipartite, variable degree";}
 
+ // copies the spin configuration from another instance; there is
+ // only one replica per instance, so lanes is not used
+ void copy_lanes(const Algorithm& src, const std::vector<char>&)
+ {
+   spins = src.spins;
+   sums = src.sums;
+   energy = src.energy;
+ }
+
+ // spins in the order of the sites of the lattice, 1 for up; the spins
+ // of the sites of sums are those of lowest energy. The fields are
+ // couplings to the extra sites, so the spins are relative to theirs.
+ void get_spins(std::size_t, std::vector<char>& s) const
+ {
+   std::vector<value_type> sums0(sums.size(),0.0);
+
+   const auto& sites = model->sites;
+   const auto& neighbs = model->neighbs;
+   const auto& jzv = model->jzv;
+   for(std::size_t i = 0; i < sites.size(); ++i)
+     for(index_type k = 0; k < sites[i].nneighbs; ++k)
+       sums0[neighbs[sites[i].offs + k]] += jzv[sites[i].offs + k] * spins[i];
+
+   const auto& pos = model->pos;
+   const bool flip = spins.back() < 0;
+   s.resize(pos.size());
+   for(std::size_t i = 0; i < pos.size(); ++i){
+     if(pos[i] < sites.size())
+       s[i] = spins[pos[i]] > 0;
+     else
+       s[i] = sums0[pos[i] - sites.size()] <= 0;
+     s[i] ^= flip;
+   }
+ }
+
+ // tells whether the energy of the replica is at most e; the energy is
+ // updated as spins are flipped
+ bool reached_energy(double e)
+ {
+   return energy <= e;
+ }
+
+ // keeps the state of the replica if its energy is lower than at any
+ // call before
+ void update_best()
+ {
+   if(energy < best_energy){
+     best_energy = energy;
+     best_spins = spins;
+     best_sums = sums;
+   }
+ }
+
+ // puts back the lowest energy state kept by update_best
+ void restore_best()
+ {
+   spins = best_spins;
+   sums = best_sums;
+   energy = best_energy;
+ }
+
  private:
 
- std::vector<site_type> sites;
+ std::shared_ptr<const model_type> model;
+
+ aligned_vector<int> spins;
  std::vector<value_type> sums;
- std::vector<std::vector<double> > bound_array;
+ value_type energy;
+
+ // lowest energy state seen by update_best
+ aligned_vector<int> best_spins;
+ std::vector<value_type> best_sums;
+ value_type best_energy;
+
+ threshold_table thresholds;
+ // sweeps since reset_sites, which key the thresholds with tempering
+ // and population annealing
+ std::size_t nsweeps_done;
 
  std::mt19937 generator;
  std::function<double()> rng_; 
@@ -0,0 +1,332 @@
+/******************************************************************************
+
+Simulated annealing codes
+v1.0
+
+---------------------------------------------------------------------
+
+Implementation of single-spin simulated annealing algorithm for
+Ising spin glasses with general interactions with magnetic field
+and any number of neighbors. The sites are colored such that no two
+neighbors have the same color, and all sites of one color are updated
+in parallel with OPENMP threads.
+
+---------------------------------------------------------------------
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*******************************************************************************/
+
+#ifndef __ALGORITHM_H__
+#define __ALGORITHM_H__
+
+#include <cmath>
+#include <random>
+#include <vector>
+#include <string>
+#include <numeric>
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <limits>
+
+#include "lattice.h"
+#include "thresholds.h"
+#include "utils.h"
+
+#ifdef _OPENMP
+#	include "omp.h"
+#endif
+
+template<typename T = uint64_t>
+  class Algorithm
+  {
+  public:
+
+  typedef double value_type;
+  typedef unsigned index_type;
+
+  static const std::size_t word_size = 1;
+
+  // smaller lattices are swept by one thread
+  static const std::size_t min_parallel_sites = 4096;
+
+  struct site_type{
+    value_type hzv;
+    index_type nneighbs;
+    index_type offs;
+  };
+
+  struct lattice_site_type{
+    value_type hzv;
+    std::vector<value_type> jzv;
+    index_type nneighbs;
+    std::vector<index_type> neighbs;
+  };
+
+  // couplings and colors are shared by all copies of an instance
+  struct model_type{
+    aligned_vector<site_type> sites;
+    aligned_vector<index_type> neighbs;
+    aligned_vector<value_type> jzv;
+    std::vector<index_type> color_begin;
+    // position in sites of every site of the lattice
+    std::vector<index_type> perm;
+  };
+
+  typedef Lattice<value_type, index_type> lattice_type;
+
+  Algorithm() {}
+
+  template <typename SE>
+  Algorithm(const lattice_type& lattice, const std::vector<SE>& sched0)
+  : generator(41)
+  {
+    std::vector<lattice_site_type> sites0;
+    lattice.init_sites(sites0);
+
+    std::shared_ptr<model_type> m = std::make_shared<model_type>();
+    aligned_vector<site_type>& sites = m->sites;
+    aligned_vector<index_type>& neighbs = m->neighbs;
+    aligned_vector<value_type>& jzv = m->jzv;
+    std::vector<index_type>& color_begin = m->color_begin;
+
+    // greedy coloring, sites of high degree first
+
+    std::vector<index_type> order(sites0.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](index_type a, index_type b)
+      {return sites0[a].nneighbs > sites0[b].nneighbs;});
+
+    std::vector<index_type> colors(sites0.size(), index_type(-1));
+    std::vector<char> used;
+    index_type ncolors = 0;
+    for(const auto i : order){
+      used.assign(ncolors + 1, 0);
+      for(const auto j : sites0[i].neighbs)
+        if(colors[j] != index_type(-1))
+          used[colors[j]] = 1;
+
+      colors[i] = std::find(used.begin(), used.end(), 0) - used.begin();
+      ncolors = std::max(ncolors, colors[i] + 1);
+    }
+
+    // sites of the same color are stored next to each other
+
+    color_begin.assign(ncolors + 1, 0);
+    for(const auto c : colors)
+      ++color_begin[c + 1];
+    std::partial_sum(color_begin.begin(), color_begin.end(), color_begin.begin());
+
+    std::vector<index_type> pos(color_begin.begin(), color_begin.end() - 1);
+    std::vector<index_type>& perm = m->perm;
+    perm.resize(sites0.size());
+    for(std::size_t i = 0; i < sites0.size(); ++i)
+      perm[i] = pos[colors[i]]++;
+
+    sites.resize(sites0.size());
+    std::vector<index_type> inv(sites0.size());
+    for(std::size_t i = 0; i < sites0.size(); ++i)
+      inv[perm[i]] = i;
+
+    for(std::size_t i = 0; i < sites.size(); ++i){
+      const lattice_site_type& site0 = sites0[inv[i]];
+      sites[i].hzv = site0.hzv;
+      sites[i].nneighbs = site0.nneighbs;
+      sites[i].offs = neighbs.size();
+      for(index_type k = 0; k < site0.nneighbs; ++k){
+        neighbs.push_back(perm[site0.neighbs[k]]);
+        jzv.push_back(site0.jzv[k]);
+      }
+    }
+
+    spins.resize(sites.size());
+
+    rng_ = std::bind(std::uniform_real_distribution<double>(0, 1), std::ref(generator));
+
+    thresholds = threshold_table(sched0, sites.size(), 2, true, rng_);
+
+    model = m;
+
+  }
+
+  void reset_sites(const std::size_t rep)
+  {
+    generator.seed(rep+1);
+    thresholds.start(rep);
+    nsweeps_done = 0;
+
+    for(auto& spin : spins)
+      spin = 2 * int((generator() >> 29) & 1) - 1;
+
+    std::vector<value_type> en(1);
+    get_energies(en, 0);
+    energy = en[0];
+
+    best_energy = std::numeric_limits<value_type>::max();
+  }
+
+  // the local field is computed from the neighbors, which have other
+  // colors and are not flipped at the same time
+  value_type get_de(const std::size_t i) const
+  {
+    const auto& neighbs = model->neighbs;
+    const auto& jzv = model->jzv;
+
+    const site_type& site = model->sites[i];
+    value_type tmp = site.hzv;
+    for(index_type k = 0; k < site.nneighbs; ++k)
+      tmp += jzv[site.offs + k] * spins[neighbs[site.offs + k]];
+
+    return -tmp * spins[i];
+  }
+
+  // a sweep is split among threads if the lattice is large enough and
+  // more than one thread is available to it
+  static bool split_sweep(const std::size_t n)
+  {
+#ifdef _OPENMP
+    return n >= min_parallel_sites && omp_get_max_threads() > 1 && !omp_in_parallel();
+#else
+    return false;
+#endif
+  }
+
+  void do_sweep(const std::size_t sweep)
+  {
+    const auto& color_begin = model->color_begin;
+    const std::size_t n = spins.size();
+    const double* ba = thresholds.get(sweep, nsweeps_done++) + n - generator() % n;
+
+    // the energy changes by twice the sum of the accepted de
+    value_type de = 0;
+
+    // one thread needs neither the parallel region nor a barrier per
+    // color; the colors are consecutive, so one pass over all sites
+    // updates them in order
+    if(!split_sweep(n)){
+      value_type* s = spins.data();
+      for(std::size_t i = 0; i < n; ++i){
+        const value_type d = get_de(i);
+        if(d < ba[i]){
+          s[i] = -s[i];
+          de += d;
+        }
+      }
+
+      energy += 2 * de;
+      return;
+    }
+
+    #pragma omp parallel
+    for(std::size_t c = 0; c + 1 < color_begin.size(); ++c){
+      #pragma omp for schedule(static) reduction(+:de)
+      for(std::size_t i = color_begin[c]; i < color_begin[c + 1]; ++i){
+        const value_type d = get_de(i);
+        if(d < ba[i]){
+          spins[i] = -spins[i];
+          de += d;
+        }
+      }
+    }
+
+    energy += 2 * de;
+
+  }
+
+  std::size_t get_energies(std::vector<value_type>& en, const std::size_t offs) const
+  {
+    const auto& sites = model->sites;
+    const auto& neighbs = model->neighbs;
+    const auto& jzv = model->jzv;
+
+    value_type energy = 0;
+    for(std::size_t i = 0; i < sites.size(); ++i){
+      value_type tmp = sites[i].hzv;
+      for(index_type k = 0; k < sites[i].nneighbs; ++k)
+        tmp += spins[neighbs[sites[i].offs + k]] * jzv[sites[i].offs + k] / 2;
+
+      energy += tmp * spins[i];
+    }
+
+    en[offs] = energy;
+    return offs+1;
+  }
+
+  std::string get_info() const {return "algorithm: single-spin generic, variable degree, " + to_s(model->color_begin.size() - 1) + " colors";}
+
+  // copies the spin configuration from another instance; there is
+  // only one replica per instance, so lanes is not used
+  void copy_lanes(const Algorithm& src, const std::vector<char>&)
+  {
+    spins = src.spins;
+    energy = src.energy;
+  }
+
+  // spins in the order of the sites of the lattice, 1 for up
+  void get_spins(std::size_t, std::vector<char>& s) const
+  {
+    const auto& perm = model->perm;
+
+    s.resize(perm.size());
+    for(std::size_t i = 0; i < perm.size(); ++i)
+      s[i] = spins[perm[i]] > 0;
+  }
+
+  // tells whether the energy of the replica is at most e; the energy is
+  // updated after every sweep
+  bool reached_energy(double e)
+  {
+    return energy <= e;
+  }
+
+  // keeps the state of the replica if its energy is lower than at any
+  // call before
+  void update_best()
+  {
+    if(energy < best_energy){
+      best_energy = energy;
+      best_spins = spins;
+    }
+  }
+
+  // puts back the lowest energy state kept by update_best
+  void restore_best()
+  {
+    spins = best_spins;
+    energy = best_energy;
+  }
+
+  private:
+
+  std::shared_ptr<const model_type> model;
+
+  aligned_vector<value_type> spins;
+  value_type energy;
+
+  // lowest energy state seen by update_best
+  aligned_vector<value_type> best_spins;
+  value_type best_energy;
+
+  threshold_table thresholds;
+  // sweeps since reset_sites, which key the thresholds with tempering
+  // and population annealing
+  std::size_t nsweeps_done;
+
+  std::mt19937 generator;
+  std::function<double()> rng_;
+
+  };
+
+#endif
@@ -0,0 +1,358 @@
+/******************************************************************************
+
+Simulated annealing codes
+v1.0
+
+---------------------------------------------------------------------
+
+Implementation of single-spin simulated annealing algorithm for
+Ising spin glasses with general interactions with magnetic field
+and any number of neighbors. Several replicas are stored next to
+each other for every site and updated at once with AVX2 or AVX-512
+instructions.
+
+---------------------------------------------------------------------
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*******************************************************************************/
+
+#ifndef __ALGORITHM_H__
+#define __ALGORITHM_H__
+
+#include <cmath>
+#include <random>
+#include <vector>
+#include <string>
+#include <functional>
+#include <memory>
+#include <limits>
+
+#if defined(__AVX2__) || defined(__AVX512F__)
+#	include <immintrin.h>
+#endif
+
+#include "lattice.h"
+#include "thresholds.h"
+#include "utils.h"
+
+#define LANE_EXCHANGE
+
+template<typename T = uint64_t>
+  class Algorithm
+  {
+  public:
+
+  typedef double value_type;
+  typedef unsigned index_type;
+
+  // replicas per site: one per double in a vector register
+
+#if defined(__AVX512F__)
+  static const std::size_t word_size = 8;
+  typedef __m512d vec_type;
+  typedef __mmask8 mask_type;
+#elif defined(__AVX2__)
+  static const std::size_t word_size = 4;
+  typedef __m256d vec_type;
+  typedef __m256d mask_type;
+#else
+  static const std::size_t word_size = 1;
+  typedef double vec_type;
+  typedef bool mask_type;
+#endif
+
+  struct alignas(8 * word_size) lanes_type{
+    value_type v[word_size];
+  };
+
+  struct alignas(4 * word_size) offsets_type{
+    int v[word_size];
+  };
+
+  struct site_type{
+    value_type hzv;
+    index_type nneighbs;
+    index_type offs;
+  };
+
+  struct lattice_site_type{
+    value_type hzv;
+    std::vector<value_type> jzv;
+    index_type nneighbs;
+    std::vector<index_type> neighbs;
+  };
+
+  // couplings are shared by all copies of an instance
+  struct model_type{
+    aligned_vector<site_type> sites;
+    aligned_vector<index_type> neighbs;
+    aligned_vector<value_type> jzv;
+  };
+
+  typedef Lattice<value_type, index_type> lattice_type;
+
+  Algorithm() {}
+
+  template <typename SE>
+  Algorithm(const lattice_type& lattice, const std::vector<SE>& sched0)
+  : generator(41)
+  {
+    std::vector<lattice_site_type> sites0;
+    lattice.init_sites(sites0);
+
+    std::shared_ptr<model_type> m = std::make_shared<model_type>();
+    aligned_vector<site_type>& sites = m->sites;
+    aligned_vector<index_type>& neighbs = m->neighbs;
+    aligned_vector<value_type>& jzv = m->jzv;
+
+    sites.resize(sites0.size());
+    for(std::size_t i = 0; i < sites0.size(); ++i){
+      sites[i].hzv = sites0[i].hzv;
+      sites[i].nneighbs = sites0[i].nneighbs;
+      sites[i].offs = neighbs.size();
+      neighbs.insert(neighbs.end(), sites0[i].neighbs.begin(), sites0[i].neighbs.end());
+      jzv.insert(jzv.end(), sites0[i].jzv.begin(), sites0[i].jzv.end());
+    }
+
+    spins.resize(sites.size());
+    des.resize(sites.size());
+
+    rng_ = std::bind(std::uniform_real_distribution<double>(0, 1), std::ref(generator));
+
+    thresholds = threshold_table(sched0, sites.size(), 2, true, rng_);
+
+    model = m;
+
+  }
+
+  void reset_sites(const std::size_t rep)
+  {
+    const auto& sites = model->sites;
+    const auto& neighbs = model->neighbs;
+    const auto& jzv = model->jzv;
+
+    generator.seed(rep+1);
+    thresholds.start(rep);
+    nsweeps_done = 0;
+
+    for(auto& spin : spins)
+      for(auto& s : spin.v)
+        s = 2 * int((generator() >> 29) & 1) - 1;
+
+    for(auto& e : energies.v)
+      e = 0;
+
+    for(std::size_t i = 0; i < sites.size(); ++i)
+      for(std::size_t r = 0; r < word_size; ++r){
+        value_type tmp = sites[i].hzv;
+        for(index_type k = 0; k < sites[i].nneighbs; ++k)
+          tmp += jzv[sites[i].offs + k] * spins[neighbs[sites[i].offs + k]].v[r];
+        des[i].v[r] = -tmp * spins[i].v[r];
+        energies.v[r] += (tmp + sites[i].hzv) * spins[i].v[r] / 2;
+      }
+
+    for(auto& e : best_energies.v)
+      e = std::numeric_limits<value_type>::max();
+  }
+
+  // the energies of the flipped replicas change by twice their de
+  void flip_spins(const std::size_t i, const mask_type m)
+  {
+    store(energies, sub(load(energies), m, mul(set(-2), load(des[i]))));
+
+    const vec_type spin = negate(load(spins[i]), m);
+    store(spins[i], spin);
+    store(des[i], negate(load(des[i]), m));
+
+    const auto& neighbs = model->neighbs;
+    const auto& jzv = model->jzv;
+
+    const site_type& site = model->sites[i];
+    for(index_type k = 0; k < site.nneighbs; ++k){
+      const index_type j = neighbs[site.offs + k];
+      const vec_type t = mul(set(2 * jzv[site.offs + k]), mul(load(spins[j]), spin));
+      store(des[j], sub(load(des[j]), m, t));
+    }
+  }
+
+  void do_sweep(const std::size_t sweep)
+  {
+    const std::size_t n = spins.size();
+    const double* ba = thresholds.get(sweep, nsweeps_done++);
+
+    // every replica starts at its own offset in the thresholds
+    for(std::size_t r = 0; r < word_size; ++r)
+      pos.v[r] = n - generator() % n;
+
+    for(std::size_t i = 0; i < n; ++i){
+      const mask_type m = less(load(des[i]), gather(&ba[i], pos));
+      if(any(m))
+        flip_spins(i, m);
+    }
+
+  }
+
+  std::size_t get_energies(std::vector<value_type>& en, const std::size_t offs) const
+  {
+    const auto& sites = model->sites;
+    const auto& neighbs = model->neighbs;
+    const auto& jzv = model->jzv;
+
+    for(std::size_t r = 0; r < word_size; ++r){
+      value_type energy = 0;
+      for(std::size_t i = 0; i < sites.size(); ++i){
+        value_type tmp = sites[i].hzv;
+        for(index_type k = 0; k < sites[i].nneighbs; ++k)
+          tmp += spins[neighbs[sites[i].offs + k]].v[r] * jzv[sites[i].offs + k] / 2;
+
+        energy += tmp * spins[i].v[r];
+      }
+
+      en[offs + r] = energy;
+    }
+
+    return offs + word_size;
+  }
+
+  // swaps the replicas in the given lanes with those of another instance
+  void exchange_lanes(Algorithm& other, const std::vector<char>& lanes)
+  {
+    for(std::size_t r = 0; r < word_size; ++r)
+      if(lanes[r]){
+        for(std::size_t i = 0; i < spins.size(); ++i){
+          std::swap(spins[i].v[r], other.spins[i].v[r]);
+          std::swap(des[i].v[r], other.des[i].v[r]);
+        }
+        std::swap(energies.v[r], other.energies.v[r]);
+      }
+  }
+
+  // copies the replicas in the given lanes from another instance
+  void copy_lanes(const Algorithm& src, const std::vector<char>& lanes)
+  {
+    for(std::size_t r = 0; r < word_size; ++r)
+      if(lanes[r]){
+        for(std::size_t i = 0; i < spins.size(); ++i){
+          spins[i].v[r] = src.spins[i].v[r];
+          des[i].v[r] = src.des[i].v[r];
+        }
+        energies.v[r] = src.energies.v[r];
+      }
+  }
+
+  // spins of the replica in lane r in the order of the sites, 1 for up
+  void get_spins(std::size_t r, std::vector<char>& s) const
+  {
+    s.resize(spins.size());
+    for(std::size_t i = 0; i < spins.size(); ++i)
+      s[i] = spins[i].v[r] > 0;
+  }
+
+  // tells whether the energy of one of the replicas is at most e; the
+  // energies are updated as spins are flipped
+  bool reached_energy(double e)
+  {
+    for(auto en : energies.v)
+      if(en <= e)
+        return true;
+    return false;
+  }
+
+  // keeps the state of every replica whose energy is lower than at any
+  // call before
+  void update_best()
+  {
+    best_spins.resize(spins.size());
+    best_des.resize(des.size());
+
+    for(std::size_t r = 0; r < word_size; ++r)
+      if(energies.v[r] < best_energies.v[r]){
+        for(std::size_t i = 0; i < spins.size(); ++i){
+          best_spins[i].v[r] = spins[i].v[r];
+          best_des[i].v[r] = des[i].v[r];
+        }
+        best_energies.v[r] = energies.v[r];
+      }
+  }
+
+  // puts back the lowest energy states kept by update_best
+  void restore_best()
+  {
+    spins = best_spins;
+    des = best_des;
+    energies = best_energies;
+  }
+
+  std::string get_info() const {return "algorithm: single-spin generic, variable degree, " + to_s(word_size) + " replicas per vector";}
+
+  private:
+
+  std::shared_ptr<const model_type> model;
+
+  aligned_vector<lanes_type> spins;
+  aligned_vector<lanes_type> des;
+  lanes_type energies;
+
+  // lowest energy states seen by update_best
+  aligned_vector<lanes_type> best_spins;
+  aligned_vector<lanes_type> best_des;
+  lanes_type best_energies;
+  offsets_type pos;
+
+  threshold_table thresholds;
+  // sweeps since reset_sites, which key the thresholds with tempering
+  // and population annealing
+  std::size_t nsweeps_done;
+
+  std::mt19937 generator;
+  std::function<double()> rng_;
+
+  // compare-and-blend primitives
+
+#if defined(__AVX512F__)
+  static vec_type load(const lanes_type& a) {return _mm512_load_pd(a.v);}
+  static void store(lanes_type& a, const vec_type v) {_mm512_store_pd(a.v, v);}
+  static vec_type set(const value_type x) {return _mm512_set1_pd(x);}
+  static vec_type gather(const value_type* p, const offsets_type& o) {return _mm512_mask_i32gather_pd(_mm512_setzero_pd(), 0xff, _mm256_load_si256((const __m256i*) o.v), p, 8);}
+  static vec_type mul(const vec_type a, const vec_type b) {return _mm512_mul_pd(a, b);}
+  static mask_type less(const vec_type a, const vec_type b) {return _mm512_cmp_pd_mask(a, b, _CMP_LT_OQ);}
+  static bool any(const mask_type m) {return m != 0;}
+  static vec_type negate(const vec_type a, const mask_type m) {return _mm512_mask_sub_pd(a, m, _mm512_setzero_pd(), a);}
+  static vec_type sub(const vec_type a, const mask_type m, const vec_type b) {return _mm512_mask_sub_pd(a, m, a, b);}
+#elif defined(__AVX2__)
+  static vec_type load(const lanes_type& a) {return _mm256_load_pd(a.v);}
+  static void store(lanes_type& a, const vec_type v) {_mm256_store_pd(a.v, v);}
+  static vec_type set(const value_type x) {return _mm256_set1_pd(x);}
+  static vec_type gather(const value_type* p, const offsets_type& o) {return _mm256_mask_i32gather_pd(_mm256_setzero_pd(), p, _mm_load_si128((const __m128i*) o.v), _mm256_castsi256_pd(_mm256_set1_epi64x(-1)), 8);}
+  static vec_type mul(const vec_type a, const vec_type b) {return _mm256_mul_pd(a, b);}
+  static mask_type less(const vec_type a, const vec_type b) {return _mm256_cmp_pd(a, b, _CMP_LT_OQ);}
+  static bool any(const mask_type m) {return _mm256_movemask_pd(m) != 0;}
+  static vec_type negate(const vec_type a, const mask_type m) {return _mm256_xor_pd(a, _mm256_and_pd(m, _mm256_set1_pd(-0.0)));}
+  static vec_type sub(const vec_type a, const mask_type m, const vec_type b) {return _mm256_sub_pd(a, _mm256_and_pd(m, b));}
+#else
+  static vec_type load(const lanes_type& a) {return a.v[0];}
+  static void store(lanes_type& a, const vec_type v) {a.v[0] = v;}
+  static vec_type set(const value_type x) {return x;}
+  static vec_type gather(const value_type* p, const offsets_type& o) {return p[o.v[0]];}
+  static vec_type mul(const vec_type a, const vec_type b) {return a * b;}
+  static mask_type less(const vec_type a, const vec_type b) {return a < b;}
+  static bool any(const mask_type m) {return m;}
+  static vec_type negate(const vec_type a, const mask_type m) {return m ? -a : a;}
+  static vec_type sub(const vec_type a, const mask_type m, const vec_type b) {return m ? a - b : a;}
+#endif
+
+  };
+
+#endif
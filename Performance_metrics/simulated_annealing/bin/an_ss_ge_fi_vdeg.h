@@ -36,10 +36,12 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <vector>
 #include <string>
 #include <functional>
+#include <memory>
+#include <limits>
 
 #include "lattice.h"
-
-#define OMP_VERSION_2
+#include "thresholds.h"
+#include "utils.h"
 
 template<typename T = uint64_t>
   class Algorithm
@@ -51,15 +53,34 @@ template<typename T = uint64_t>
 
   static const std::size_t word_size = 1;
 
+  // the neighbors of a site are neighbs[offs], ..., neighbs[offs +
+  // nneighbs - 1] of the model, with couplings jzv[offs], ...
   struct site_type{
-    int spin;
+    value_type hzv;
+    index_type nneighbs;
+    index_type offs;
+  };
+
+  struct lattice_site_type{
     value_type hzv;
     std::vector<value_type> jzv;
-    value_type de;
     index_type nneighbs;
     std::vector<index_type> neighbs;
   };
 
+  // spin and energy change of a site in the replica of an instance
+  struct state_type{
+    int spin;
+    value_type de;
+  };
+
+  // couplings are shared by all copies of an instance
+  struct model_type{
+    aligned_vector<site_type> sites;
+    aligned_vector<index_type> neighbs;
+    aligned_vector<value_type> jzv;
+  };
+
   typedef Lattice<value_type, index_type> lattice_type;
 
   Algorithm() {}
@@ -68,74 +89,104 @@ template<typename T = uint64_t>
   Algorithm(const lattice_type& lattice, const std::vector<SE>& sched0)
   : generator(41)
   {
-    lattice.init_sites(sites);
+    std::vector<lattice_site_type> sites0;
+    lattice.init_sites(sites0);
+
+    std::shared_ptr<model_type> m = std::make_shared<model_type>();
+    aligned_vector<site_type>& sites = m->sites;
+    aligned_vector<index_type>& neighbs = m->neighbs;
+    aligned_vector<value_type>& jzv = m->jzv;
+
+    sites.resize(sites0.size());
+    for(std::size_t i = 0; i < sites0.size(); ++i){
+      sites[i].hzv = sites0[i].hzv;
+      sites[i].nneighbs = sites0[i].nneighbs;
+      sites[i].offs = neighbs.size();
+      neighbs.insert(neighbs.end(), sites0[i].neighbs.begin(), sites0[i].neighbs.end());
+      jzv.insert(jzv.end(), sites0[i].jzv.begin(), sites0[i].jzv.end());
+    }
 
     rng_ = std::bind(std::uniform_real_distribution<double>(0, 1), std::ref(generator));
 
-    bound_array.resize(sched0.size());
-
-    auto ba = bound_array.begin();
-    for(const auto& s : sched0){
+    thresholds = threshold_table(sched0, sites.size(), 2, false, rng_);
 
-      ba->resize(sites.size());
-      for(auto& a : *ba)
-        a = -std::log(rng_()) / (s.beta * 2);
-
-      ++ba;
-    }
+    model = m;
+    states.resize(sites.size());
 
   }
 
   void reset_sites(const std::size_t rep)
   {
+    const auto& sites = model->sites;
+    const auto& neighbs = model->neighbs;
+    const auto& jzv = model->jzv;
+
     generator.seed(rep+1);
+    thresholds.start(rep);
+    nsweeps_done = 0;
 
-    for(auto& site : sites)
-      site.spin = 2 * ((generator() >> 29) & 1) - 1;
+    for(auto& st : states)
+      st.spin = 2 * ((generator() >> 29) & 1) - 1;
 
-    for(auto& site : sites){
+    energy = 0;
+    for(std::size_t i = 0; i < sites.size(); ++i){
+      const site_type& site = sites[i];
       value_type tmp = site.hzv;
       for(index_type k = 0; k < site.nneighbs; ++k)
-	tmp += site.jzv[k] * sites[site.neighbs[k]].spin;
-      site.de = -tmp * site.spin;
+	tmp += jzv[site.offs + k] * states[neighbs[site.offs + k]].spin;
+      states[i].de = -tmp * states[i].spin;
+      energy += (tmp + site.hzv) * states[i].spin / 2;
     }
+
+    best_energy = std::numeric_limits<value_type>::max();
   }  
 
-  void flip_spin(site_type& site)
+  // the energy changes by twice de
+  void flip_spin(const site_type& site, state_type& st)
   {
-    site.spin = -site.spin;
-    site.de = -site.de;
+    const index_type* neighbs = &model->neighbs[site.offs];
+    const value_type* jzv = &model->jzv[site.offs];
+
+    energy += 2 * st.de;
+    st.spin = -st.spin;
+    st.de = -st.de;
 
     for (index_type k = 0; k<site.nneighbs; ++k) {
-      site_type& neighbor = sites[site.neighbs[k]];
-      neighbor.de -= 2 * neighbor.spin * site.jzv[k] * site.spin;
+      state_type& neighbor = states[neighbs[k]];
+      neighbor.de -= 2 * neighbor.spin * jzv[k] * st.spin;
     }    
   }
 
   void do_sweep(const std::size_t sweep)
   {
+    const auto& sites = model->sites;
     const std::size_t l = generator() % sites.size();
-    const auto& ba = bound_array[sweep];
+    const double* ba = thresholds.get(sweep, nsweeps_done++);
 
     for(std::size_t i = 0; i<l; ++i)
-      if(sites[i].de<  ba[i + sites.size() - l])
-        flip_spin(sites[i]);
+      if(states[i].de<  ba[i + sites.size() - l])
+        flip_spin(sites[i], states[i]);
 
     for(std::size_t i = l; i<sites.size(); ++i)
-      if(sites[i].de < ba[i - l])
-        flip_spin(sites[i]);
+      if(states[i].de < ba[i - l])
+        flip_spin(sites[i], states[i]);
 
   } 
 
   std::size_t get_energies(std::vector<value_type>& en, const std::size_t offs) const
   {
+    const auto& sites = model->sites;
+    const auto& neighbs = model->neighbs;
+    const auto& jzv = model->jzv;
+
     value_type energy = 0;
-    for(const auto& site : sites){
+    for(std::size_t i = 0; i < sites.size(); ++i){
+      const site_type& site = sites[i];
       value_type tmp = site.hzv;
       for(index_type k = 0; k < site.nneighbs; ++k)
-	tmp += sites[site.neighbs[k]].spin * site.jzv[k] / 2;
+	tmp += states[neighbs[site.offs + k]].spin * jzv[site.offs + k] / 2;
 
-      energy += tmp * site.spin;
+      energy += tmp * states[i].spin;
     }
 
     en[offs] = energy;
@@ -144,10 +195,60 @@ template<typename T = uint64_t>
  
   std::string get_info() const {return "algorithm: single-spin generic, variable degree";}
 
+  // copies the spin configuration from another instance; there is
+  // only one replica per instance, so lanes is not used
+  void copy_lanes(const Algorithm& src, const std::vector<char>&)
+  {
+    states = src.states;
+    energy = src.energy;
+  }
+
+  // spins in the order of the sites, 1 for up
+  void get_spins(std::size_t, std::vector<char>& s) const
+  {
+    s.resize(states.size());
+    for(std::size_t i = 0; i < states.size(); ++i)
+      s[i] = states[i].spin > 0;
+  }
+
+  // tells whether the energy of the replica is at most e; the energy is
+  // updated as spins are flipped
+  bool reached_energy(double e)
+  {
+    return energy <= e;
+  }
+
+  // keeps the state of the replica if its energy is lower than at any
+  // call before
+  void update_best()
+  {
+    if(energy < best_energy){
+      best_energy = energy;
+      best_states = states;
+    }
+  }
+
+  // puts back the lowest energy state kept by update_best
+  void restore_best()
+  {
+    states = best_states;
+    energy = best_energy;
+  }
+
   private:
 
-  std::vector<site_type> sites;
-  std::vector<std::vector<double> > bound_array;
+  std::shared_ptr<const model_type> model;
+  threshold_table thresholds;
+  // sweeps since reset_sites, which key the thresholds with tempering
+  // and population annealing
+  std::size_t nsweeps_done;
+
+  aligned_vector<state_type> states;
+  value_type energy;
+
+  // lowest energy state seen by update_best
+  aligned_vector<state_type> best_states;
+  value_type best_energy;
 
   std::mt19937 generator;
   std::function<double()> rng_; 
@@ -35,12 +35,16 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <random>
 #include <vector>
 #include <string>
+#include <memory>
+#include <limits>
 
 #include "bits.h"
 #include "lattice.h"
 #include "ss_config.h"
 #include "utils.h"
 
+#define NFOLD_WAY
+
 template <typename T = uint64_t, std::size_t depth = 18>
 class Algorithm {
 public:
@@ -53,16 +57,28 @@ public:
 	typedef Lattice<value_type, index_type> lattice_type;
 
 	struct site_type {
-		value_type spin;
 		value_type hzv;
 		value_type jzv[MAXNB];
-		value_type de;
 		index_type nneighbs;
 		index_type neighbs[MAXNB];
 	};
 
+	// spin and energy change of a site in the replica of an instance
+	struct state_type {
+		value_type spin;
+		value_type de;
+	};
+
 	struct sched_type {
 		std::vector<unsigned> r;
+		// flip probabilities of the n-fold way, indexed by max(de, 0)
+		std::vector<double> w;
+	};
+
+	// couplings and thresholds are shared by all copies of an instance
+	struct model_type {
+		aligned_vector<site_type> sites;
+		std::vector<sched_type> sched;
 	};
 
 	static const std::size_t word_size = 1;
@@ -77,6 +93,10 @@ public:
 	template <typename SE>
 	Algorithm(const lattice_type& lattice, const std::vector<SE>& sched0)
 	{
+		std::shared_ptr<model_type> m = std::make_shared<model_type>();
+		aligned_vector<site_type>& sites = m->sites;
+		std::vector<sched_type>& sched = m->sched;
+
 		lattice.init_sites(sites, MAXNB);
 
 		unsigned maxh = 0;
@@ -101,11 +121,20 @@ public:
 			double p = 1.0;
 
 			sched[sweep].r.resize(maxh + 1);
+			sched[sweep].w.assign(maxh + 1, 1.0);
 			for (unsigned k = 1; k <= maxh; ++k) {
 				p *= p0;
 				sched[sweep].r[k] = rand_size * p;
+				sched[sweep].w[k] = p;
 			}
 		}
+
+		model = m;
+		states.resize(sites.size());
+
+		bsize.resize(maxh + 1);
+		buckets.resize((maxh + 1) * sites.size());
+		pos.resize(sites.size());
 	}
 
 	void reset_sites(std::size_t rep)
@@ -113,23 +142,84 @@ public:
 		rgen.seed(rep + 1);
 		bgen.seed(rep + 1);
 
+		const aligned_vector<site_type>& sites = model->sites;
+
 		// startconf
-		for (std::size_t i = 0; i < sites.size(); ++i)
-			sites[i].spin = 2 * int((rgen() >> 29) & 1) - 1;
+		for (std::size_t i = 0; i < states.size(); ++i)
+			states[i].spin = 2 * int((rgen() >> 29) & 1) - 1;
 
 		for (std::size_t i = 0; i < sites.size(); ++i) {
-			site_type& site = sites[i];
+			const site_type& site = sites[i];
 			value_type h = site.hzv;
 			for (std::size_t k = 0; k < MAXNB; ++k)
-				h += site.jzv[k] * sites[site.neighbs[k]].spin;
-			site.de = -h * site.spin;
+				h += site.jzv[k] * states[site.neighbs[k]].spin;
+			states[i].de = -h * states[i].spin;
 		}
+
+		energy = calc_energy();
+
+		nflips = sites.size();
+		buckets_valid = false;
+
+		best_energy = std::numeric_limits<value_type>::max();
 	}
 
 	void do_sweep(size_t sweep)
 	{
-		for (auto& site : sites)
-			update_site(site, sched[sweep]);
+		const aligned_vector<site_type>& sites = model->sites;
+		const sched_type& sched = model->sched[sweep];
+
+		nflips = 0;
+		buckets_valid = false;
+
+		for (std::size_t i = 0; i < sites.size(); ++i)
+			update_site(sites[i], states[i], sched);
+	}
+
+	// rejection-free (n-fold way) dynamics for the time of one sweep,
+	// i.e. as many attempts as there are sites; flips are drawn with
+	// their Metropolis probabilities and the number of rejected attempts
+	// between flips is drawn from the geometric distribution
+	void do_nfold_sweep(std::size_t sweep)
+	{
+		const std::vector<double>& w = model->sched[sweep].w;
+		const double n = states.size();
+
+		if (!buckets_valid) fill_buckets();
+
+		// the total flip rate is updated as sites change classes
+		rate = 0;
+		for (std::size_t c = 0; c < bsize.size(); ++c)
+			rate += bsize[c] * w[c];
+
+		nflips = 0;
+		double t = 0;
+		while (rate > 0) {
+			double p = rate / n;
+			if (p < 1) t += std::floor(std::log(1 - uniform()) / std::log1p(-p));
+			if (++t > n) break;
+
+			// classes of larger de are less likely, so the scan starts at 0
+			double x = uniform() * rate;
+			std::size_t c = 0;
+			for (; c + 1 < bsize.size(); ++c) {
+				double y = bsize[c] * w[c];
+				if (x < y) break;
+				x -= y;
+			}
+			while (c > 0 && bsize[c] == 0) --c;
+			if (bsize[c] == 0) break;
+
+			index_type k = std::min<index_type>(x / w[c], bsize[c] - 1);
+			flip_site(buckets[c * states.size() + k], w);
+			++nflips;
+		}
+	}
+
+	// fraction of the sites flipped during the last sweep
+	double get_acceptance() const
+	{
+		return double(nflips) / states.size();
 	}
 
 	std::size_t get_energies(std::vector<value_type>& en, std::size_t offs) const
@@ -142,28 +232,149 @@ public:
 	{
 		return "algorithm: single-spin, range-n couplings, with fields";
 	}
+
+	// copies the spin configuration from another instance; there is
+	// only one replica per instance, so lanes is not used
+	void copy_lanes(const Algorithm& src, const std::vector<char>&)
+	{
+		states = src.states;
+		energy = src.energy;
+		buckets_valid = false;
+	}
+
+	// spins in the order of the sites, 1 for up
+	void get_spins(std::size_t, std::vector<char>& s) const
+	{
+		s.resize(states.size());
+		for (std::size_t i = 0; i < states.size(); ++i)
+			s[i] = states[i].spin > 0;
+	}
+
+	// tells whether the energy of the replica is at most e; the energy
+	// is updated as spins are flipped
+	bool reached_energy(double e)
+	{
+		return energy <= e;
+	}
+
+	// keeps the state of the replica if its energy is lower than at any
+	// call before
+	void update_best()
+	{
+		if (energy < best_energy) {
+			best_energy = energy;
+			best_states = states;
+		}
+	}
+
+	// puts back the lowest energy state kept by update_best
+	void restore_best()
+	{
+		states = best_states;
+		energy = best_energy;
+		buckets_valid = false;
+	}
 private:
-	std::vector<site_type> sites;
-	std::vector<sched_type> sched;
+	std::shared_ptr<const model_type> model;
+
+	aligned_vector<state_type> states;
+	// energy of the replica, changed by twice de with every flip
+	value_type energy;
+
+	// lowest energy state seen by update_best
+	aligned_vector<state_type> best_states;
+	value_type best_energy;
 
 	std::mt19937 rgen;
 	bgen_type bgen;
 
-	void update_site(site_type& site, const sched_type& sched)
+	std::size_t nflips;
+
+	// sites by max(de, 0), their positions in the buckets and the total
+	// flip rate; only valid during n-fold way sweeps. Bucket c holds
+	// bsize[c] sites starting at buckets[c * nsites].
+	bool buckets_valid;
+	std::vector<index_type> bsize;
+	std::vector<index_type> buckets;
+	std::vector<index_type> pos;
+	double rate;
+
+	// uniform random number in [0, 1) from the fast generator
+	double uniform()
+	{
+		return (bgen() >> (8 * sizeof(word_type) - 53)) * (1.0 / (uint64_t(1) << 53));
+	}
+
+	void fill_buckets()
 	{
-		if (site.de <= 0 || sched.r[site.de] > (bgen() >> offs)) {
-			site.spin = -site.spin;
-			site.de = -site.de;
+		const std::size_t n = states.size();
+
+		std::fill(bsize.begin(), bsize.end(), 0);
+		for (std::size_t i = 0; i < n; ++i) {
+			std::size_t c = std::max(states[i].de, 0);
+			pos[i] = bsize[c]++;
+			buckets[c * n + pos[i]] = i;
+		}
+
+		buckets_valid = true;
+	}
+
+	void move_site(index_type i, value_type de0, const std::vector<double>& w)
+	{
+		value_type c0 = std::max(de0, 0);
+		value_type c1 = std::max(states[i].de, 0);
+		if (c0 == c1) return;
+
+		index_type* b0 = &buckets[c0 * states.size()];
+		index_type last = b0[--bsize[c0]];
+		b0[pos[i]] = last;
+		pos[last] = pos[i];
+
+		index_type* b1 = &buckets[c1 * states.size()];
+		pos[i] = bsize[c1]++;
+		b1[pos[i]] = i;
+
+		rate += w[c1] - w[c0];
+	}
+
+	void flip_site(index_type i, const std::vector<double>& w)
+	{
+		const site_type& site = model->sites[i];
+		state_type& st = states[i];
+		value_type de0 = st.de;
+
+		energy += 2 * de0;
+		st.spin = -st.spin;
+		st.de = -st.de;
+		move_site(i, de0, w);
+
+		for (std::size_t k = 0; k < site.nneighbs; ++k) {
+			state_type& neighbor = states[site.neighbs[k]];
+			value_type nde0 = neighbor.de;
+			neighbor.de -= 2 * site.jzv[k] * st.spin * neighbor.spin;
+			move_site(site.neighbs[k], nde0, w);
+		}
+	}
+
+	void update_site(const site_type& site, state_type& st, const sched_type& sched)
+	{
+		if (st.de <= 0 || sched.r[st.de] > (bgen() >> offs)) {
+			++nflips;
+			energy += 2 * st.de;
+			st.spin = -st.spin;
+			st.de = -st.de;
 
 			for (std::size_t k = 0; k < MAXNB; ++k) {
-				site_type& neighbor = sites[site.neighbs[k]];
-				neighbor.de -= 2 * site.jzv[k] * site.spin * neighbor.spin;
+				state_type& neighbor = states[site.neighbs[k]];
+				neighbor.de -= 2 * site.jzv[k] * st.spin * neighbor.spin;
 			}
 		}
 	}
 
 	value_type calc_energy() const
 	{
+		const aligned_vector<site_type>& sites = model->sites;
+
 		value_type en = 0;
 
 		for (std::size_t i = 0; i < sites.size(); ++i) {
@@ -171,10 +382,10 @@ private:
 			value_type h = site.hzv;
 			for (std::size_t k = 0; k < site.nneighbs; ++k) {
 				std::size_t l = site.neighbs[k];
-				if (i < l) h += sites[l].spin * site.jzv[k];
+				if (i < l) h += states[l].spin * site.jzv[k];
 			}
 
-			en += h * site.spin;
+			en += h * states[i].spin;
 		}
 
 		return en;
@@ -35,6 +35,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <random>
 #include <vector>
 #include <string>
+#include <memory>
+#include <limits>
 
 #include "bits.h"
 #include "lattice.h"
@@ -49,19 +51,39 @@ public:
 
 	typedef Lattice<value_type, index_type> lattice_type;
 
+	// the neighbors of a site are neighbs[offs], ..., neighbs[offs +
+	// nneighbs - 1] of the model, with couplings jzv[offs], ...
 	struct site_type {
-		value_type spin;
+		value_type hzv;
+		index_type nneighbs;
+		index_type offs;
+	};
+
+	struct lattice_site_type {
 		value_type hzv;
 		std::vector<value_type> jzv;
-		value_type de;
 		index_type nneighbs;
 		std::vector<index_type> neighbs;
 	};
 
+	// spin and energy change of a site in the replica of an instance
+	struct state_type {
+		value_type spin;
+		value_type de;
+	};
+
 	struct sched_type {
 		std::vector<unsigned> r;
 	};
 
+	// couplings and thresholds are shared by all copies of an instance
+	struct model_type {
+		aligned_vector<site_type> sites;
+		aligned_vector<index_type> neighbs;
+		aligned_vector<value_type> jzv;
+		std::vector<sched_type> sched;
+	};
+
 	static const std::size_t word_size = 1;
 	static const std::size_t offs = 8 * sizeof(word_type) - depth;
 	static const std::size_t rand_size = std::size_t(1) << depth;
@@ -74,15 +96,31 @@ public:
 	template <typename SE>
 	Algorithm(const lattice_type& lattice, const std::vector<SE>& sched0)
 	{
-		lattice.init_sites(sites);
+		std::vector<lattice_site_type> sites0;
+		lattice.init_sites(sites0);
+
+		std::shared_ptr<model_type> m = std::make_shared<model_type>();
+		aligned_vector<site_type>& sites = m->sites;
+		aligned_vector<index_type>& neighbs = m->neighbs;
+		aligned_vector<value_type>& jzv = m->jzv;
+		std::vector<sched_type>& sched = m->sched;
+
+		sites.resize(sites0.size());
+		for (std::size_t i = 0; i < sites0.size(); ++i) {
+			sites[i].hzv = sites0[i].hzv;
+			sites[i].nneighbs = sites0[i].nneighbs;
+			sites[i].offs = neighbs.size();
+			neighbs.insert(neighbs.end(), sites0[i].neighbs.begin(), sites0[i].neighbs.end());
+			jzv.insert(jzv.end(), sites0[i].jzv.begin(), sites0[i].jzv.end());
+		}
 
 		unsigned maxh = 0;
 		for (std::size_t i = 0; i < sites.size(); ++i) {
-			site_type& site = sites[i];
+			const site_type& site = sites[i];
 
 			unsigned mh = 0;
 			for (std::size_t k = 0; k < site.nneighbs; ++k)
-				mh += std::abs(site.jzv[k]);
+				mh += std::abs(jzv[site.offs + k]);
 			mh += std::abs(site.hzv);
 			if (mh > maxh) maxh = mh;
 		}
@@ -98,6 +136,9 @@ public:
 				sched[sweep].r[k] = rand_size * p;
 			}
 		}
+
+		model = m;
+		states.resize(sites.size());
 	}
 
 	void reset_sites(std::size_t rep)
@@ -105,23 +146,34 @@ public:
 		rgen.seed(rep + 1);
 		bgen.seed(rep + 1);
 
+		const aligned_vector<site_type>& sites = model->sites;
+		const aligned_vector<index_type>& neighbs = model->neighbs;
+		const aligned_vector<value_type>& jzv = model->jzv;
+
 		// startconf
-		for (std::size_t i = 0; i < sites.size(); ++i)
-			sites[i].spin = 2 * int((rgen() >> 29) & 1) - 1;
+		for (std::size_t i = 0; i < states.size(); ++i)
+			states[i].spin = 2 * int((rgen() >> 29) & 1) - 1;
 
 		for (std::size_t i = 0; i < sites.size(); ++i) {
-			site_type& site = sites[i];
+			const site_type& site = sites[i];
 			value_type h = site.hzv;
 			for (std::size_t k = 0; k < site.nneighbs; ++k)
-				h += site.jzv[k] * sites[site.neighbs[k]].spin;
-			site.de = -h * site.spin;
+				h += jzv[site.offs + k] * states[neighbs[site.offs + k]].spin;
+			states[i].de = -h * states[i].spin;
 		}
+
+		energy = calc_energy();
+
+		best_energy = std::numeric_limits<value_type>::max();
 	}
 
 	void do_sweep(size_t sweep)
 	{
-		for (auto& site : sites)
-			update_site(site, sched[sweep]);
+		const aligned_vector<site_type>& sites = model->sites;
+		const sched_type& sched = model->sched[sweep];
+
+		for (std::size_t i = 0; i < sites.size(); ++i)
+			update_site(sites[i], states[i], sched);
 	}
 
 	std::size_t get_energies(std::vector<value_type>& en, std::size_t offs) const
@@ -134,39 +186,94 @@ public:
 	{
 		return "algorithm: single-spin, range-n couplings, with fields";
 	}
+
+	// copies the spin configuration from another instance; there is
+	// only one replica per instance, so lanes is not used
+	void copy_lanes(const Algorithm& src, const std::vector<char>&)
+	{
+		states = src.states;
+		energy = src.energy;
+	}
+
+	// spins in the order of the sites, 1 for up
+	void get_spins(std::size_t, std::vector<char>& s) const
+	{
+		s.resize(states.size());
+		for (std::size_t i = 0; i < states.size(); ++i)
+			s[i] = states[i].spin > 0;
+	}
+
+	// tells whether the energy of the replica is at most e; the energy
+	// is updated as spins are flipped
+	bool reached_energy(double e)
+	{
+		return energy <= e;
+	}
+
+	// keeps the state of the replica if its energy is lower than at any
+	// call before
+	void update_best()
+	{
+		if (energy < best_energy) {
+			best_energy = energy;
+			best_states = states;
+		}
+	}
+
+	// puts back the lowest energy state kept by update_best
+	void restore_best()
+	{
+		states = best_states;
+		energy = best_energy;
+	}
 private:
-	std::vector<site_type> sites;
-	std::vector<sched_type> sched;
+	std::shared_ptr<const model_type> model;
+
+	aligned_vector<state_type> states;
+	// energy of the replica, changed by twice de with every flip
+	value_type energy;
+
+	// lowest energy state seen by update_best
+	aligned_vector<state_type> best_states;
+	value_type best_energy;
 
 	std::mt19937 rgen;
 	bgen_type bgen;
 
-	void update_site(site_type& site, const sched_type& sched)
+	void update_site(const site_type& site, state_type& st, const sched_type& sched)
 	{
-		if (site.de <= 0 || sched.r[site.de] > (bgen() >> offs)) {
-			site.spin = -site.spin;
-			site.de = -site.de;
+		if (st.de <= 0 || sched.r[st.de] > (bgen() >> offs)) {
+			const index_type* neighbs = &model->neighbs[site.offs];
+			const value_type* jzv = &model->jzv[site.offs];
+
+			energy += 2 * st.de;
+			st.spin = -st.spin;
+			st.de = -st.de;
 
 			for (std::size_t k = 0; k < site.nneighbs; ++k) {
-				site_type& neighbor = sites[site.neighbs[k]];
-				neighbor.de -= 2 * site.jzv[k] * site.spin * neighbor.spin;
+				state_type& neighbor = states[neighbs[k]];
+				neighbor.de -= 2 * jzv[k] * st.spin * neighbor.spin;
 			}
 		}
 	}
 
 	value_type calc_energy() const
 	{
+		const aligned_vector<site_type>& sites = model->sites;
+		const aligned_vector<index_type>& neighbs = model->neighbs;
+		const aligned_vector<value_type>& jzv = model->jzv;
+
 		value_type en = 0;
 
 		for (std::size_t i = 0; i < sites.size(); ++i) {
 			const site_type& site = sites[i];
 			value_type h = site.hzv;
 			for (std::size_t k = 0; k < site.nneighbs; ++k) {
-				std::size_t l = site.neighbs[k];
-				if (i < l) h += sites[l].spin * site.jzv[k];
+				std::size_t l = neighbs[site.offs + k];
+				if (i < l) h += states[l].spin * jzv[site.offs + k];
 			}
 
-			en += h * site.spin;
+			en += h * states[i].spin;
 		}
 
 		return en;
@@ -0,0 +1,511 @@
+/******************************************************************************
+
+Simulated annealing codes
+v1.0
+
+---------------------------------------------------------------------
+
+Generator of multi-spin simulated annealing codes for Ising spin
+glasses with range-k couplings (k = 1, ..., 7) with or without fields
+on graphs of degree up to 16.
+
+usage: gen_ms range nf|fi [maxnb] > header
+
+where maxnb is the maximum number of neighbors (default 6).
+
+Every bit of the absolute value of a coupling is a separate weight
+plane. The unsatisfied couplings of a site are summed bit-parallel by
+a tree of full and half adders that is generated for every number of
+neighbors; the planes select which couplings enter every column of the
+tree, so one update function serves all couplings of a given degree.
+
+---------------------------------------------------------------------
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*******************************************************************************/
+
+#include <cstdlib>
+#include <deque>
+#include <string>
+#include <vector>
+#include <sstream>
+#include <iostream>
+
+static const unsigned MAXRANGE = 7;
+static const unsigned MAXDEGREE = 16;
+
+template <typename T>
+std::string str(const T& t)
+{
+	std::ostringstream out;
+	out << t;
+	return out.str();
+}
+
+static unsigned nplanes(unsigned range)
+{
+	unsigned p = 0;
+	while ((1u << p) <= range) ++p;
+	return p;
+}
+
+static void print_header(std::ostream& out, unsigned range, bool fields, unsigned maxnb)
+{
+	std::string fi = fields ? "with" : "without";
+
+	out << "/******************************************************************************\n"
+		"\n"
+		"Simulated annealing codes\n"
+		"v1.0\n"
+		"\n"
+		"---------------------------------------------------------------------\n"
+		"\n"
+		"Implementation of multi-spin simulated annealing algorithm for Ising\n"
+		"spin glasses with range-" << range << " couplings " << fi << " fields\n"
+		"on graphs of degree up to " << maxnb << ".\n"
+		"\n"
+		"Machine-generated by gen_ms " << range << " " << (fields ? "fi" : "nf")
+		<< " " << maxnb << "; do not edit.\n"
+		"\n"
+		"---------------------------------------------------------------------\n"
+		"\n"
+		"This program is free software: you can redistribute it and/or modify\n"
+		"it under the terms of the GNU General Public License as published by\n"
+		"the Free Software Foundation, either version 3 of the License, or\n"
+		"(at your option) any later version.\n"
+		"\n"
+		"This program is distributed in the hope that it will be useful,\n"
+		"but WITHOUT ANY WARRANTY; without even the implied warranty of\n"
+		"MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the\n"
+		"GNU General Public License for more details.\n"
+		"\n"
+		"You should have received a copy of the GNU General Public License\n"
+		"along with this program.  If not, see <http://www.gnu.org/licenses/>.\n"
+		"\n"
+		"*******************************************************************************/\n"
+		"\n";
+}
+
+// prints the update function of a site with nb neighbors; the field, if
+// any, is an extra coupling to a spin that is always up
+
+static void print_update(std::ostream& out, unsigned range, unsigned nb, bool field)
+{
+	const unsigned np = nplanes(range);
+	const unsigned nt = nb + field;
+	const std::string name = "update_site" + str(nb) + (field ? "field" : "nofield");
+
+	out << "\t// machine-generated code; do not edit\n";
+	out << "\t#ifdef USE_" << nb << "_NEIGHB\n";
+	out << "\tvoid " << name << "(std::size_t i, const site_type& site, const sched_type& sched)\n";
+	out << "\t{\n";
+	out << "\t\tunsigned r = bgen() >> (rand_bits - depth);\n";
+	out << "\t\tword_type spin = spins[i];\n\n";
+
+	for (unsigned l = 0; l < nb; ++l)
+		out << "\t\tword_type l" << l << " = site.jzw[" << l
+			<< "] ^ (spin ^ spins[site.neighbs[" << l << "]]);\n";
+	if (field)
+		out << "\t\tword_type l" << nb << " = site.hzw ^ spin;\n";
+	out << "\n";
+
+	// columns of the adder tree; column b holds the unsatisfied
+	// couplings with bit b set in their absolute value
+
+	// the sum of all weights fits into nbits bits, so the carries out
+	// of the last column are always zero and are not computed
+
+	const unsigned nbits = nplanes(nt * range);
+
+	std::vector<std::deque<std::string> > cols(nbits);
+	for (unsigned b = 0; b < np; ++b)
+		for (unsigned l = 0; l < nt; ++l) {
+			std::string term = "l" + str(l);
+			if (np > 1) {
+				std::string w = l < nb ? "site.jw[" + str(b) + "][" + str(l) + "]"
+					: "site.hw[" + str(b) + "]";
+				term = "p" + str(b) + "_" + str(l);
+				out << "\t\tword_type " << term << " = l" << l << " & " << w << ";\n";
+			}
+			cols[b].push_back(term);
+		}
+	if (np > 1) out << "\n";
+
+	unsigned nadd = 0;
+	std::vector<std::string> sum;
+	for (unsigned b = 0; b < nbits; ++b) {
+		std::deque<std::string>& col = cols[b];
+		const bool carry = b + 1 < nbits;
+
+		while (col.size() > 1) {
+			std::string a = col.front(); col.pop_front();
+			std::string c = col.front(); col.pop_front();
+			std::string s = "s" + str(nadd);
+			std::string k = "c" + str(nadd);
+			++nadd;
+
+			if (!col.empty()) {
+				std::string d = col.front(); col.pop_front();
+				std::string u = "u" + str(nadd - 1);
+				out << "\t\tword_type " << u << " = " << a << " ^ " << c << ";\n";
+				out << "\t\tword_type " << s << " = " << u << " ^ " << d << ";\n";
+				if (carry)
+					out << "\t\tword_type " << k << " = (" << a << " & " << c << ") | ("
+						<< u << " & " << d << ");\n";
+			} else {
+				out << "\t\tword_type " << s << " = " << a << " ^ " << c << ";\n";
+				if (carry)
+					out << "\t\tword_type " << k << " = " << a << " & " << c << ";\n";
+			}
+
+			col.push_back(s);
+			if (carry) cols[b + 1].push_back(k);
+		}
+
+		sum.push_back(col.front());
+	}
+	out << "\n";
+
+	// the energy change is 2 (site.s - 2 w), where w is the weight of
+	// the unsatisfied couplings; flips with an energy change of at
+	// most 2 k are accepted
+
+	out << "\t\tunsigned k = 0;\n";
+	out << "\t\twhile (k < site.s && r < sched.r[k + 1])\n";
+	out << "\t\t\t++k;\n\n";
+
+	out << "\t\t// bits of the replicas with w >= (site.s - k + 1) / 2\n";
+	out << "\t\tunsigned w = (site.s - k + 1) / 2;\n";
+	out << "\t\tword_type mask = word_type(-1);\n";
+	for (unsigned b = 0; b < sum.size(); ++b)
+		out << "\t\tmask = w & " << (1u << b) << " ? " << sum[b] << " & mask : "
+			<< sum[b] << " | mask;\n";
+	out << "\n";
+
+	out << "\t\tspins[i] = spin ^ mask;\n";
+	out << "\t}\n";
+	out << "\t#endif\n\n";
+}
+
+static void print_dispatch(std::ostream& out, const char* indent, bool field, unsigned maxnb)
+{
+	out << indent << "switch (site.nneighbs) {\n";
+	for (unsigned nb = 1; nb <= maxnb; ++nb) {
+		out << "#\tifdef USE_" << nb << "_NEIGHB\n";
+		out << indent << "case " << nb << ":\n";
+		out << indent << "\tupdate_site" << nb << (field ? "field" : "nofield")
+			<< "(i, site, sched[sweep]);\n";
+		out << indent << "\tbreak;\n";
+		out << "#\tendif\n";
+	}
+	out << indent << "}\n";
+}
+
+static void print_algorithm(std::ostream& out, unsigned range, bool fields, unsigned maxnb)
+{
+	const unsigned np = nplanes(range);
+	const unsigned kmax = range * (maxnb + fields);
+
+	print_header(out, range, fields, maxnb);
+
+	out << "#ifndef __ALGORITHM_H__\n"
+		"#define __ALGORITHM_H__\n"
+		"\n"
+		"#include <cmath>\n"
+		"#include <random>\n"
+		"#include <vector>\n"
+		"#include <memory>\n"
+		"#include <string>\n"
+		"#include <cstdlib>\n"
+		"#include <stdexcept>\n"
+		"\n"
+		"#include \"bits.h\"\n"
+		"#include \"lattice.h\"\n"
+		"#include \"ms_config.h\"\n"
+		"#include \"utils.h\"\n"
+		"#include \"words.h\"\n"
+		"\n"
+		"#define MULTI_SPIN\n"
+		"#define LANE_EXCHANGE\n"
+		"\n"
+		"template <typename T = uint64_t, std::size_t depth = 18>\n"
+		"class Algorithm {\n"
+		"public:\n"
+		"\ttypedef T word_type;\n"
+		"\ttypedef int value_type;\n"
+		"\ttypedef unsigned index_type;\n"
+		"\n"
+		"\tstatic const unsigned MAXNB = " << maxnb << ";\n"
+		"\tstatic const int RANGE = " << range << ";\n"
+		"\n"
+		"\ttypedef Lattice<value_type, index_type> lattice_type;\n"
+		"\n"
+		"\tstruct site_type {\n"
+				"\t\tword_type hzw;\n"
+		"\t\tword_type jzw[MAXNB];\n";
+	if (np > 1) {
+		if (fields)
+			out << "\t\tword_type hw[" << np << "];\n";
+		out << "\t\tword_type jw[" << np << "][MAXNB];\n";
+	}
+	out << "\t\tvalue_type hzv;\n"
+		"\t\tvalue_type jzv[MAXNB];\n"
+		"\t\tindex_type nneighbs;\n"
+		"\t\tindex_type neighbs[MAXNB];\n"
+		"\t\tunsigned s;\n"
+		"\t};\n"
+		"\n"
+		"\t// r[k] is the threshold of an energy change of 2 k\n"
+		"\tstruct sched_type {\n"
+		"\t\tunsigned r[" << kmax + 1 << "];\n"
+		"\t};\n"
+		"\n"
+		"\t// couplings and thresholds are shared by all copies of an instance\n"
+		"\tstruct model_type {\n"
+		"\t\taligned_vector<site_type> sites;\n"
+		"\t\tstd::vector<sched_type> sched;\n"
+		"\t\tlane_energies<word_type> terms;\n"
+		"\t};\n"
+		"\n"
+		"\ttypedef typename word_traits<word_type>::rand_type rand_type;\n"
+		"\n"
+		"\tstatic const std::size_t word_size = 8 * sizeof(word_type);\n"
+		"\tstatic const std::size_t rand_bits = 8 * sizeof(rand_type);\n"
+		"\tstatic const std::size_t rand_size = std::size_t(1) << depth;\n"
+		"\n"
+		"\ttypedef bitgen_lincon<rand_type> bgen_type;\n"
+		"\n"
+		"\tAlgorithm() {}\n"
+		"\n"
+		"\ttemplate <typename SE>\n"
+		"\tAlgorithm(const lattice_type& lattice, const std::vector<SE>& sched0)\n"
+		"\t{\n"
+		"\t\tstd::shared_ptr<model_type> m = std::make_shared<model_type>();\n"
+		"\t\taligned_vector<site_type>& sites = m->sites;\n"
+		"\t\tstd::vector<sched_type>& sched = m->sched;\n"
+		"\n"
+		"\t\tlattice.init_sites(sites, MAXNB);\n"
+		"\n"
+		"\t\tfor (std::size_t i = 0; i < sites.size(); ++i) {\n"
+		"\t\t\tsite_type& site = sites[i];\n"
+		"\n"
+		"\t\t\tif (!check_number_of_neighbors(site.nneighbs))\n"
+		"\t\t\t\tthrow std::runtime_error(to_s(site.nneighbs) +\n"
+		"\t\t\t\t\t\" neighbors is not defined in ms_config.h\");\n"
+		"\n"
+		"\t\t\tsite.s = 0;\n"
+		"\t\t\tfor (std::size_t l = 0; l < site.nneighbs; ++l) {\n"
+		"\t\t\t\tint a = std::abs(site.jzv[l]);\n"
+		"\t\t\t\tif (a == 0 || a > RANGE)\n"
+		"\t\t\t\t\tthrow std::runtime_error(\"coupling \" + to_s(site.jzv[l]) +\n"
+		"\t\t\t\t\t\t\" is out of range \" + to_s(int(RANGE)));\n"
+		"\n"
+		"\t\t\t\tsite.jzw[l] = site.jzv[l] > 0 ? word_type(-1) : 0;\n";
+	if (np > 1)
+		out << "\t\t\t\tfor (unsigned b = 0; b < " << np << "; ++b)\n"
+			"\t\t\t\t\tsite.jw[b][l] = (a >> b) & 1 ? word_type(-1) : 0;\n";
+	out << "\t\t\t\tsite.s += a;\n"
+		"\t\t\t}\n";
+	if (fields) {
+		out << "\n"
+			"\t\t\tint a = std::abs(site.hzv);\n"
+			"\t\t\tif (a > RANGE)\n"
+			"\t\t\t\tthrow std::runtime_error(\"field \" + to_s(site.hzv) +\n"
+			"\t\t\t\t\t\" is out of range \" + to_s(int(RANGE)));\n"
+			"\n"
+			"\t\t\tsite.hzw = site.hzv < 0 ? word_type(-1) : 0;\n";
+		if (np > 1)
+			out << "\t\t\tfor (unsigned b = 0; b < " << np << "; ++b)\n"
+				"\t\t\t\tsite.hw[b] = (a >> b) & 1 ? word_type(-1) : 0;\n";
+		out << "\t\t\tsite.s += a;\n";
+	}
+	out << "\t\t}\n"
+		"\n"
+		"\t\tsched.resize(sched0.size());\n"
+		"\t\tfor (std::size_t sweep = 0; sweep < sched0.size(); ++sweep) {\n"
+		"\t\t\tdouble p = std::exp(-2 * sched0[sweep].beta);\n"
+		"\t\t\tdouble pk = 1;\n"
+		"\t\t\tfor (unsigned k = 0; k <= " << kmax << "; ++k) {\n"
+		"\t\t\t\tsched[sweep].r[k] = rand_size * pk;\n"
+		"\t\t\t\tpk *= p;\n"
+		"\t\t\t}\n"
+		"\t\t}\n"
+		"\n"
+		"\t\tm->terms.add_sites(sites);\n"
+		"\n"
+		"\t\tmodel = m;\n"
+		"\t\tspins.resize(sites.size());\n"
+		"\t}\n"
+		"\n"
+		"\tvoid reset_sites(std::size_t rep)\n"
+		"\t{\n"
+		"\t\trgen.seed(rep + 1);\n"
+		"\t\tbgen.seed(rep + 1);\n"
+		"\n"
+		"\t\t// startconf\n"
+		"\t\tfor (std::size_t i = 0; i < spins.size(); ++i)\n"
+		"\t\t\tspins[i] = random_word(rgen, spins[i]);\n"
+		"\n"
+		"\t\tbest.reset();\n"
+		"\t}\n"
+		"\n"
+		"\tvoid do_sweep(std::size_t sweep)\n"
+		"\t{\n"
+		"\t\tconst aligned_vector<site_type>& sites = model->sites;\n"
+		"\t\tconst std::vector<sched_type>& sched = model->sched;\n"
+		"\n"
+		"\t\t// machine-generated code; do not edit\n"
+		"\t\tfor (std::size_t i = 0; i < sites.size(); ++i) {\n"
+		"\t\t\tconst site_type& site = sites[i];\n";
+	if (fields) {
+		out << "\t\t\tif (site.hzv != 0) {\n";
+		print_dispatch(out, "\t\t\t\t", true, maxnb);
+		out << "\t\t\t} else {\n";
+		print_dispatch(out, "\t\t\t\t", false, maxnb);
+		out << "\t\t\t}\n";
+	} else
+		print_dispatch(out, "\t\t\t", false, maxnb);
+	out << "\t\t}\n"
+		"\t}\n"
+		"\n"
+		"\tstd::size_t get_energies(std::vector<value_type>& en, std::size_t offs) const\n"
+		"\t{\n"
+		"\t\tcalc_energies(en, offs);\n"
+		"\t\treturn offs + word_size;\n"
+		"\t}\n"
+		"\n"
+		"\tstd::string get_info() const\n"
+		"\t{\n"
+		"\t\treturn \"algorithm: multi-spin, range-" << range << " couplings, "
+		<< (fields ? "with" : "without") << " fields\";\n"
+		"\t}\n"
+		"\n"
+		"\t// swaps the replicas in the given lanes with those of another instance\n"
+		"\tvoid exchange_lanes(Algorithm& other, const std::vector<char>& lanes)\n"
+		"\t{\n"
+		"\t\tword_type mask = lanes_to_word<word_type>(lanes);\n"
+		"\t\tfor (std::size_t i = 0; i < spins.size(); ++i) {\n"
+		"\t\t\tword_type t = (spins[i] ^ other.spins[i]) & mask;\n"
+		"\t\t\tspins[i] ^= t;\n"
+		"\t\t\tother.spins[i] ^= t;\n"
+		"\t\t}\n"
+		"\t}\n"
+		"\n"
+		"\t// copies the replicas in the given lanes from another instance\n"
+		"\tvoid copy_lanes(const Algorithm& src, const std::vector<char>& lanes)\n"
+		"\t{\n"
+		"\t\tword_type mask = lanes_to_word<word_type>(lanes);\n"
+		"\t\tfor (std::size_t i = 0; i < spins.size(); ++i)\n"
+		"\t\t\tspins[i] ^= (spins[i] ^ src.spins[i]) & mask;\n"
+		"\t}\n"
+		"\n"
+		"\t// spins of the replica in lane k in the order of the sites, 1 for up\n"
+		"\tvoid get_spins(std::size_t k, std::vector<char>& s) const\n"
+		"\t{\n"
+		"\t\ts.resize(spins.size());\n"
+		"\t\tfor (std::size_t i = 0; i < spins.size(); ++i)\n"
+		"\t\t\ts[i] = word_bit(spins[i], k);\n"
+		"\t}\n"
+		"\n"
+		"\t// tells whether the energy of one of the lanes is at most e; the\n"
+		"\t// unsatisfied couplings of all lanes are counted at once\n"
+		"\tbool reached_energy(double e)\n"
+		"\t{\n"
+		"\t\tmodel->terms.count(&spins[0], counts);\n"
+		"\t\treturn word_any(model->terms.at_most(counts, e));\n"
+		"\t}\n"
+		"\n"
+		"\t// keeps the spins of every lane whose energy is lower than any it\n"
+		"\t// had at a call before\n"
+		"\tvoid update_best()\n"
+		"\t{\n"
+		"\t\tmodel->terms.count(&spins[0], counts);\n"
+		"\t\tbest.update(counts, &spins[0], spins.size());\n"
+		"\t}\n"
+		"\n"
+		"\t// puts back the lowest energy state of every lane kept by update_best\n"
+		"\tvoid restore_best()\n"
+		"\t{\n"
+		"\t\tspins = best.get_spins();\n"
+		"\t}\n"
+		"private:\n"
+		"\tstd::shared_ptr<const model_type> model;\n"
+		"\n"
+		"\taligned_vector<word_type> spins;\n"
+		"\taligned_vector<word_type> counts;\n"
+		"\tlane_best<word_type> best;\n"
+		"\n"
+		"\tstd::mt19937 rgen;\n"
+		"\tbgen_type bgen;\n"
+		"\n";
+
+	for (unsigned nb = 1; nb <= maxnb; ++nb) {
+		print_update(out, range, nb, false);
+		if (fields) print_update(out, range, nb, true);
+	}
+
+	out << "\tvoid calc_energies(std::vector<value_type>& en, std::size_t offs) const\n"
+		"\t{\n"
+		"\t\tconst aligned_vector<site_type>& sites = model->sites;\n"
+		"\n"
+		"\t\tfor (unsigned k = 0; k < word_size; ++k) {\n"
+		"\t\t\tfor (std::size_t i = 0; i < sites.size(); ++i) {\n"
+		"\t\t\t\tconst site_type& site = sites[i];\n"
+		"\n"
+		"\t\t\t\tint spin = 2 * int(word_bit(spins[i], k)) - 1;\n"
+		"\n"
+		"\t\t\t\tvalue_type h = 0;\n"
+		"\t\t\t\tfor (std::size_t l = 0; l < site.nneighbs; ++l) {\n"
+		"\t\t\t\t\tstd::size_t j = site.neighbs[l];\n"
+		"\t\t\t\t\tif (i > j) continue;\n"
+		"\n"
+		"\t\t\t\t\tint nspin = 2 * int(word_bit(spins[j], k)) - 1;\n"
+		"\t\t\t\t\th += site.jzv[l] * nspin;\n"
+		"\t\t\t\t}\n"
+		"\n";
+	if (fields)
+		out << "\t\t\t\th += site.hzv;\n"
+			"\n";
+	out << "\t\t\t\ten[offs + k] += h * spin;\n"
+		"\t\t\t}\n"
+		"\t\t}\n"
+		"\t}\n"
+		"};\n"
+		"\n"
+		"#endif\n";
+}
+
+int main(int argc, char *argv[])
+{
+	if (argc != 3 && argc != 4) {
+		std::cerr << "usage: gen_ms range nf|fi [maxnb]\n";
+		return 1;
+	}
+
+	unsigned range = std::atoi(argv[1]);
+	std::string fields = argv[2];
+	unsigned maxnb = argc == 4 ? std::atoi(argv[3]) : 6;
+
+	if (range < 1 || range > MAXRANGE || (fields != "nf" && fields != "fi")
+		|| maxnb < 1 || maxnb > MAXDEGREE) {
+		std::cerr << "usage: gen_ms range nf|fi [maxnb]; range is 1 to " << MAXRANGE
+			<< ", maxnb is 1 to " << MAXDEGREE << "\n";
+		return 1;
+	}
+
+	print_algorithm(std::cout, range, fields == "fi", maxnb);
+
+	return 0;
+}
@@ -0,0 +1,55 @@
+/******************************************************************************
+
+Simulated annealing codes
+v1.0
+
+---------------------------------------------------------------------
+
+Converter of text lattice files to binary lattice files, which all
+codes accept with -l and load without parsing (see lattice.h).
+
+usage: lat2bin lattice.txt lattice.bin
+
+---------------------------------------------------------------------
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*******************************************************************************/
+
+#include <string>
+#include <iostream>
+#include <stdexcept>
+
+#include "lattice.h"
+
+int main(int argc, char *argv[])
+{
+	if (argc != 3) {
+		std::cerr << "usage: lat2bin lattice.txt lattice.bin\n";
+		return 1;
+	}
+
+	try {
+		std::string infile = argv[1];
+		std::string outfile = argv[2];
+
+		Lattice<double, unsigned> lattice(infile);
+		lattice.write_binary(outfile);
+	} catch (std::exception& e) {
+		std::cerr << "error: " << e.what() << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
@@ -7,6 +7,15 @@ v1.0
 
 Contains lattice-related functions (reading from file, etc).
 
+Lattice files are either text files (see README.txt) or binary files
+written by lat2bin, which are recognized by their magic number. A
+binary file holds the lattice as it is after reading a text file: a
+header, the labels of the sites and the links with their sites already
+renumbered and sorted, and the couplings as doubles or, if they are all
+small integers, as bytes. All numbers are in the byte order of the
+machine that wrote the file. Binary files are mapped into memory and
+not parsed, so they load much faster than text files.
+
 ---------------------------------------------------------------------
 
 Copyright (C) 2012-2013 by Sergei Isakov <isakov@itp.phys.ethz.ch>
@@ -29,10 +38,24 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef __LATTICE_H__
 #define __LATTICE_H__
 
+#include <cmath>
 #include <vector>
 #include <string>
 #include <fstream>
+#include <iterator>
+#include <numeric>
 #include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#	include <fcntl.h>
+#	include <unistd.h>
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	define LATTICE_MMAP
+#endif
 
 #include "utils.h"
 
@@ -52,65 +75,89 @@ private:
 			return std::fabs(cval) < std::fabs(rhs.cval);
 		}
 	};
+
+	// header of binary lattice files; the header is followed by
+	// nsites labels, nlinks pairs of sites and nlinks couplings, all
+	// aligned to their size
+	struct binary_header {
+		char magic[8];
+		uint64_t nsites;
+		uint64_t nlinks;
+		uint32_t coupling_type;
+		uint32_t reserved;
+	};
+
+	enum { double_couplings = 0, int8_couplings = 1 };
+
+	static const char* binary_magic()
+	{
+		return "SALATB01";
+	}
 public:
 	Lattice(const std::string& lattice_file) : lattice_file(lattice_file)
 	{
 		std::ifstream fin;
-		fin.open(lattice_file.c_str(), std::ios_base::in);
+		fin.open(lattice_file.c_str(), std::ios_base::in | std::ios_base::binary);
 		if (!fin)
 			throw std::runtime_error("cannot open file " + lattice_file + " to read lattice");
 
-		maxs = 0;
-		links.reserve(32768);
-
-		bool first_line = true;
-		while (1) {
-			if (first_line) {
-				std::string line;
-				getline(fin, line, '\n');
-				first_line = false;
-				continue;
-			}
-
-			index_type s0, s1;
-			value_type cval;
-			fin >> s0 >> s1 >> cval;
-			if (!fin) break;
-			
-			if (s0 < 0 || s1 < 0)
-				throw std::runtime_error("negative spin index in file " + lattice_file);
-
-			links.push_back({ index_type(s0), index_type(s1), cval });
-
-			maxs = s0 > maxs ? s0 : maxs;
-			maxs = s1 > maxs ? s1 : maxs;
-		}
-
+		char magic[8] = {};
+		fin.read(magic, sizeof(magic));
 		fin.close();
 
-		nsites = 0;
-		std::vector<index_type> phys_sites(maxs + 1, index_type(-1));
+		if (std::memcmp(magic, binary_magic(), sizeof(magic)) == 0)
+			read_binary();
+		else
+			read_text();
+	}
 
+	// writes the lattice to a binary lattice file
+	void write_binary(const std::string& file) const
+	{
+		binary_header h = binary_header();
+		std::memcpy(h.magic, binary_magic(), sizeof(h.magic));
+		h.nsites = nsites;
+		h.nlinks = links.size();
+		h.coupling_type = int8_couplings;
+		for (std::size_t i = 0; i < links.size(); ++i)
+			if (links[i].cval != value_type(int8_t(links[i].cval)))
+				h.coupling_type = double_couplings;
+
+		std::vector<uint32_t> ls(labels.begin(), labels.end());
+		std::vector<uint32_t> ss(2 * links.size());
 		for (std::size_t i = 0; i < links.size(); ++i) {
-			Link& link = links[i];
-
-			if (phys_sites[link.s0] == index_type(-1))
-				link.s0 = phys_sites[link.s0] = nsites++;
-			else
-				link.s0 = phys_sites[link.s0];
+			ss[2 * i] = links[i].s0;
+			ss[2 * i + 1] = links[i].s1;
+		}
 
-			if (phys_sites[link.s1] == index_type(-1))
-				link.s1 = phys_sites[link.s1] = nsites++;
- 			else
-				link.s1 = phys_sites[link.s1];
+		std::ofstream fout(file.c_str(), std::ios_base::out | std::ios_base::binary);
+		if (!fout)
+			throw std::runtime_error("cannot open file " + file + " to write lattice");
+
+		fout.write(reinterpret_cast<const char*>(&h), sizeof(h));
+		fout.write(reinterpret_cast<const char*>(ls.data()), ls.size() * sizeof(uint32_t));
+		fout.write(reinterpret_cast<const char*>(ss.data()), ss.size() * sizeof(uint32_t));
+
+		if (h.coupling_type == int8_couplings) {
+			std::vector<int8_t> cs(links.size());
+			for (std::size_t i = 0; i < links.size(); ++i)
+				cs[i] = int8_t(links[i].cval);
+			fout.write(reinterpret_cast<const char*>(cs.data()), cs.size());
+		} else {
+			if (ls.size() % 2) fout.write("\0\0\0\0", 4);
+			std::vector<double> cs(links.size());
+			for (std::size_t i = 0; i < links.size(); ++i)
+				cs[i] = links[i].cval;
+			fout.write(reinterpret_cast<const char*>(cs.data()), cs.size() * sizeof(double));
 		}
 
-		// need this for higher ranges
-		std::sort(links.begin(), links.end());
+		if (!fout)
+			throw std::runtime_error("cannot write lattice to file " + file);
 	}
+
 	
-	template <typename ST>
-	void init_sites(std::vector<ST>& sites) const
+	template <typename ST, typename A>
+	void init_sites(std::vector<ST, A>& sites) const
 	{
 		sites.reserve(nsites);
 		sites.resize(nsites);
@@ -132,8 +179,8 @@ public:
 		}
 	}
 
-	template <typename ST>
-	void init_sites(std::vector<ST>& sites, unsigned maxnb) const
+	template <typename ST, typename A>
+	void init_sites(std::vector<ST, A>& sites, unsigned maxnb) const
 	{
 		sites.reserve(nsites);
 		sites.resize(nsites);
@@ -162,11 +209,277 @@ public:
 			}
 		}
 	}
+
+	// renumbers the sites to improve the locality of the neighbors of a
+	// site: kind is none, bfs (breadth-first search from a site of lowest
+	// degree), rcm (reverse Cuthill-McKee) or label (order of the labels
+	// in the lattice file, e.g. unit cells of Chimera graphs); the labels
+	// of the sites move with them
+	void reorder(const std::string& kind)
+	{
+		if (kind == "none")
+			return;
+
+		std::vector<index_type> order(nsites);
+
+		if (kind == "bfs" || kind == "rcm")
+			order = cuthill_mckee();
+		else if (kind == "label") {
+			std::iota(order.begin(), order.end(), 0);
+			std::sort(order.begin(), order.end(), [&](index_type a, index_type b)
+				{ return labels[a] < labels[b]; });
+		} else
+			throw std::runtime_error("unknown site order " + kind);
+
+		if (kind == "rcm")
+			std::reverse(order.begin(), order.end());
+
+		std::vector<index_type> index(nsites);
+		for (std::size_t k = 0; k < nsites; ++k)
+			index[order[k]] = k;
+
+		for (std::size_t i = 0; i < links.size(); ++i) {
+			links[i].s0 = index[links[i].s0];
+			links[i].s1 = index[links[i].s1];
+		}
+
+		std::vector<index_type> labels0(labels);
+		for (std::size_t i = 0; i < nsites; ++i)
+			labels[index[i]] = labels0[i];
+	}
+
+	std::size_t size() const
+	{
+		return nsites;
+	}
+
+	// size of the lattice file in bytes
+	std::size_t file_size() const
+	{
+		return nbytes;
+	}
+
+	// labels of the sites in the lattice file
+	const std::vector<index_type>& get_labels() const
+	{
+		return labels;
+	}
 private:
+	void read_text()
+	{
+		text_reader in(lattice_file, "lattice");
+
+		maxs = 0;
+		links.reserve(32768);
+
+		// the first line is the name of the lattice; empty lines and
+		// comments are skipped
+		in.next_line();
+
+		while (in.next_line()) {
+			if (in.end_of_line()) continue;
+
+			unsigned long s0, s1;
+			double c;
+			if (!in.read(s0) || !in.read(s1) || !in.read(c) || !in.end_of_line())
+				in.error("expected two site indices and a coupling");
+
+			if (s0 >= index_type(-1) || s1 >= index_type(-1))
+				in.error("site index out of range");
+
+			value_type cval = value_type(c);
+			if (cval != c)
+				in.error("coupling " + to_s(c) + " is not an integer, which this code requires");
+
+			links.push_back({ index_type(s0), index_type(s1), cval });
+
+			maxs = s0 > maxs ? s0 : maxs;
+			maxs = s1 > maxs ? s1 : maxs;
+		}
+
+		nbytes = in.size();
+
+		nsites = 0;
+		std::vector<index_type> phys_sites(maxs + 1, index_type(-1));
+
+		for (std::size_t i = 0; i < links.size(); ++i) {
+			Link& link = links[i];
+
+			if (phys_sites[link.s0] == index_type(-1))
+				link.s0 = phys_sites[link.s0] = nsites++;
+			else
+				link.s0 = phys_sites[link.s0];
+
+			if (phys_sites[link.s1] == index_type(-1))
+				link.s1 = phys_sites[link.s1] = nsites++;
+ 			else
+				link.s1 = phys_sites[link.s1];
+		}
+
+		labels.resize(nsites);
+		for (index_type s = 0; s <= maxs; ++s)
+			if (phys_sites[s] != index_type(-1))
+				labels[phys_sites[s]] = s;
+
+		// need this for higher ranges
+		std::sort(links.begin(), links.end());
+	}
+
+	void read_binary()
+	{
+#ifdef LATTICE_MMAP
+		int fd = open(lattice_file.c_str(), O_RDONLY);
+		if (fd < 0)
+			throw std::runtime_error("cannot open file " + lattice_file + " to read lattice");
+
+		struct stat st;
+		if (fstat(fd, &st) != 0) {
+			close(fd);
+			throw std::runtime_error("cannot stat file " + lattice_file);
+		}
+
+		std::size_t size = st.st_size;
+		nbytes = size;
+		void* data = mmap(0, size, PROT_READ, MAP_PRIVATE, fd, 0);
+		close(fd);
+		if (data == MAP_FAILED)
+			throw std::runtime_error("cannot map file " + lattice_file);
+
+		try {
+			read_binary(static_cast<const char*>(data), size);
+		} catch (...) {
+			munmap(data, size);
+			throw;
+		}
+
+		munmap(data, size);
+#else
+		std::ifstream fin(lattice_file.c_str(), std::ios_base::in | std::ios_base::binary);
+		if (!fin)
+			throw std::runtime_error("cannot open file " + lattice_file + " to read lattice");
+		std::vector<char> data((std::istreambuf_iterator<char>(fin)), std::istreambuf_iterator<char>());
+		nbytes = data.size();
+		read_binary(data.data(), data.size());
+#endif
+	}
+
+	void read_binary(const char* data, std::size_t size)
+	{
+		binary_header h;
+		if (size < sizeof(h))
+			throw std::runtime_error("truncated binary lattice file " + lattice_file);
+		std::memcpy(&h, data, sizeof(h));
+
+		const std::size_t nlabels = h.nsites;
+		const std::size_t nlinks = h.nlinks;
+		const std::size_t offs_labels = sizeof(h);
+		const std::size_t offs_sites = offs_labels + nlabels * sizeof(uint32_t);
+		std::size_t offs_couplings = offs_sites + 2 * nlinks * sizeof(uint32_t);
+		std::size_t csize = 1;
+		if (h.coupling_type == double_couplings) {
+			offs_couplings = (offs_couplings + sizeof(double) - 1) / sizeof(double) * sizeof(double);
+			csize = sizeof(double);
+		} else if (h.coupling_type != int8_couplings)
+			throw std::runtime_error("unknown coupling type in binary lattice file " + lattice_file);
+
+		if (size != offs_couplings + nlinks * csize)
+			throw std::runtime_error("size of binary lattice file " + lattice_file
+				+ " does not match its header");
+
+		nsites = nlabels;
+		labels.resize(nsites);
+		for (std::size_t i = 0; i < nsites; ++i) {
+			uint32_t l;
+			std::memcpy(&l, data + offs_labels + i * sizeof(l), sizeof(l));
+			labels[i] = l;
+		}
+
+		links.resize(nlinks);
+		for (std::size_t i = 0; i < nlinks; ++i) {
+			uint32_t ss[2];
+			std::memcpy(ss, data + offs_sites + 2 * i * sizeof(uint32_t), sizeof(ss));
+			if (ss[0] >= nsites || ss[1] >= nsites)
+				throw std::runtime_error("site index out of range in binary lattice file "
+					+ lattice_file);
+
+			double c;
+			if (h.coupling_type == int8_couplings)
+				c = int8_t(data[offs_couplings + i]);
+			else
+				std::memcpy(&c, data + offs_couplings + i * sizeof(c), sizeof(c));
+
+			value_type cval = value_type(c);
+			if (cval != c)
+				throw std::runtime_error("coupling " + to_s(c) + " in binary lattice file "
+					+ lattice_file + " is not an integer, which this code requires");
+
+			links[i] = { index_type(ss[0]), index_type(ss[1]), cval };
+		}
+	}
+
+	// breadth-first order of the sites; every component starts at a site
+	// of lowest degree, and the neighbors of a site are visited in order
+	// of increasing degree
+	std::vector<index_type> cuthill_mckee() const
+	{
+		std::vector<index_type> degree(nsites, 0);
+		for (std::size_t i = 0; i < links.size(); ++i)
+			if (links[i].s0 != links[i].s1) {
+				++degree[links[i].s0];
+				++degree[links[i].s1];
+			}
+
+		std::vector<index_type> offs(nsites + 1, 0);
+		std::partial_sum(degree.begin(), degree.end(), offs.begin() + 1);
+
+		std::vector<index_type> neighbs(offs[nsites]);
+		std::vector<index_type> pos(offs.begin(), offs.end() - 1);
+		for (std::size_t i = 0; i < links.size(); ++i)
+			if (links[i].s0 != links[i].s1) {
+				neighbs[pos[links[i].s0]++] = links[i].s1;
+				neighbs[pos[links[i].s1]++] = links[i].s0;
+			}
+
+		auto by_degree = [&](index_type a, index_type b)
+			{ return degree[a] < degree[b]; };
+
+		std::vector<index_type> starts(nsites);
+		std::iota(starts.begin(), starts.end(), 0);
+		std::stable_sort(starts.begin(), starts.end(), by_degree);
+
+		std::vector<index_type> order;
+		order.reserve(nsites);
+		std::vector<char> visited(nsites, 0);
+
+		for (std::size_t k = 0; k < nsites; ++k) {
+			if (visited[starts[k]]) continue;
+
+			visited[starts[k]] = 1;
+			order.push_back(starts[k]);
+
+			for (std::size_t q = order.size() - 1; q < order.size(); ++q) {
+				const index_type i = order[q];
+				const std::size_t first = order.size();
+
+				for (index_type l = offs[i]; l < offs[i + 1]; ++l)
+					if (!visited[neighbs[l]]) {
+						visited[neighbs[l]] = 1;
+						order.push_back(neighbs[l]);
+					}
+
+				std::stable_sort(order.begin() + first, order.end(), by_degree);
+			}
+		}
+
+		return order;
+	}
+
 	const std::string& lattice_file;
 
 	std::size_t nsites;
+	std::size_t nbytes;
 	std::vector<Link> links;
+	std::vector<index_type> labels;
 	index_type maxs;
 };
 
@@ -27,11 +27,19 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 *******************************************************************************/
 
 #include <string>
+#include <deque>
 #include <vector>
+#include <algorithm>
+#include <limits>
+#include <memory>
 #include <iostream>
 #include <iomanip>
 #include <stdexcept>
 
+#ifdef _OPENMP
+#	include "omp.h"
+#endif
+
 #include "sched.h"
 #include "usage.h"
 #include "utils.h"
@@ -43,87 +51,281 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include ALGORITHM
 #endif
 
-int main(int argc, char *argv[])
+// the single-spin codes keep their energy up to date, so that checking
+// it after every sweep is free
+#ifndef DEFAULT_CHECK
+#define DEFAULT_CHECK 1
+#endif
+
+template <typename alg_type>
+void anneal(const amap_type& args, double t0)
 {
-	try {
-		double t0 = get_time();
+	// command line arguments
+
+	opt<std::string> latfile = get_sarg(args, "l");
+#ifdef LANE_INSTANCES
+	// with -lanes, lane k of every word anneals instance k % n of the n
+	// instances listed in a file, which share the sites and links of the
+	// first one; -l is then not needed
+	opt<std::string> lanefile = get_sarg(args, "lanes");
+	std::vector<std::string> lanefiles;
+	if (lanefile) {
+		lanefiles = read_file_list(*lanefile);
+		if (lanefiles.size() > alg_type::word_size)
+			usage("more instances in " + *lanefile + " than lanes", false);
+		latfile = opt<std::string>(lanefiles[0]);
+	}
+#endif
+	if (!latfile) usage("lattice is not provided", false);
+	opt<unsigned> nsweeps = get_uarg(args, "s");
+	opt<unsigned> nreps = get_uarg(args, "r");
+	opt<double> beta0 = get_darg(args, "b0", 0.1);
+	opt<double> beta1 = get_darg(args, "b1", 3.0);
+	opt<double> gamma0 = get_darg(args, "G0", 3.0);
+	opt<double> gamma1 = get_darg(args, "G1", 0.0);
+	opt<unsigned> rep0 = get_uarg(args, "r0", 0);
+	opt<unsigned> verbose = get_uarg(args, "v", 0);
+	opt<unsigned> lowest = get_uarg(args, "g", 0);
+	opt<std::string> spinfile = get_sarg(args, "spins");
+	// with -target a repetition stops as soon as one of its replicas
+	// reaches the energy, and with -stop the first one ends the run
+	opt<double> target = get_darg(args, "target");
+	opt<unsigned> stop = get_uarg(args, "stop", 0);
+	if (*stop && !target) usage("stop requires a target", false);
+	// with -best the lowest energy state of every replica, looked at
+	// every [check] sweeps and at the end, is reported instead of the
+	// final one
+	opt<unsigned> best = get_uarg(args, "best", 0);
+	// sweeps between two checks of the target and the lowest energies
+	opt<unsigned> check = get_uarg(args, "check", DEFAULT_CHECK);
+	if (*check == 0) usage("check must be positive", false);
+	// with -time repetitions are run until the time budget, counted from
+	// the start of the program, is used up, or until -r of them are done
+	opt<double> budget = get_darg(args, "time");
+	if (!nreps && !budget) usage("nreps is not provided", false);
+	if (budget && !(*budget > 0)) usage("time budget must be positive", false);
+	opt<std::string> sched_kind = get_sarg(args, "sched", "lin");
+	opt<std::string> site_order = get_sarg(args, "order", "none");
+#ifdef NFOLD_WAY
+	// acceptance rate below which the n-fold way is used
+	opt<double> nfw = get_darg(args, "nfw", 0.0);
+#endif
+	bool def_sched = *sched_kind == "lin" || *sched_kind == "exp";
+	if (!nsweeps && def_sched)
+		usage("nsweeps is not provided", false);
+
+#ifdef _OPENMP
+	// threads of algorithms that parallelize a sweep
+	opt<unsigned> nthreads = get_uarg(args, "t", omp_get_max_threads());
+	omp_set_num_threads(*nthreads);
+#endif
 
-		// command line arguments
+	typedef typename alg_type::lattice_type lattice_type;
 
-		amap_type args = parse_args(argc, argv);
+	// read lattice
+
+	double tl = get_time();
+	lattice_type lattice(*latfile);
+	tl = get_time() - tl;
+	lattice.reorder(*site_order);
+#ifdef LANE_INSTANCES
+	std::deque<lattice_type> lane_lattices;
+	std::vector<const lattice_type*> lanes;
+	for (std::size_t n = 0; lanefile && n < lanefiles.size(); ++n) {
+		lane_lattices.emplace_back(lanefiles[n]);
+		lanes.push_back(&lane_lattices.back());
+	}
+#endif
+
+	// schedule
+
+	std::vector<sched_entry> sched = get_sched(*sched_kind, *nsweeps, *beta0, *beta1, *gamma0, *gamma1);
+	*nsweeps = sched.size();
 
-		opt<std::string> latfile = get_sarg(args, "l");
-		if (!latfile) usage("lattice is not provided", false);
-		opt<unsigned> nsweeps = get_uarg(args, "s");
-		opt<unsigned> nreps = get_uarg(args, "r");
-		if (!nreps) usage("nreps is not provided", false);
-		opt<double> beta0 = get_darg(args, "b0", 0.1);
-		opt<double> beta1 = get_darg(args, "b1", 3.0);
-		opt<unsigned> rep0 = get_uarg(args, "r0", 0);
-		opt<unsigned> verbose = get_uarg(args, "v", 0);
-		opt<unsigned> lowest = get_uarg(args, "g", 0);
-		opt<std::string> sched_kind = get_sarg(args, "sched", "lin");
-		bool def_sched = *sched_kind == "lin" || *sched_kind == "exp";
-		if (!nsweeps && def_sched)
-			usage("nsweeps is not provided", false);
+	// init annealing
+
+#ifdef LANE_INSTANCES
+	alg_type alg(lattice, sched, lanes);
+#else
+	alg_type alg(lattice, sched);
+#endif
 
-		typedef Algorithm<> alg_type;
-		typedef alg_type::lattice_type lattice_type;
+	typedef typename alg_type::value_type value_type;
+	std::vector<value_type> en(alg_type::word_size);
+
+	// histograms of the energies; with -lanes lane k adds to the
+	// histogram of instance k % n
+	std::vector<std::string> names(1, *latfile);
+#ifdef LANE_INSTANCES
+	if (lanefile) names = lanefiles;
+#endif
+
+	// with -spins the final configurations are written by a background
+	// thread; with -g only those of the lowest energy of every instance
+	std::unique_ptr<spin_writer> writer;
+	if (spinfile)
+		writer.reset(new spin_writer(*spinfile, lattice.get_labels(), *lowest, names.size()));
+	std::vector<energy_histogram<value_type> > hists(names.size());
+
+	if (*verbose) {
+		if (def_sched)
+			std::cout << "#" << *sched_kind << " schedule: nsweeps="
+				<< *nsweeps << " b0=" << *beta0 << " b1=" << *beta1;
+		else
+			std::cout << "#schedule from file " << *sched_kind
+				<< ": nsweeps=" << *nsweeps;
+#ifdef TRANSVERSE_FIELD
+		if (def_sched)
+			std::cout << " G0=" << *gamma0 << " G1=" << *gamma1;
+#endif
+		std::cout << "; rep0=" << *rep0;
+		if (nreps) std::cout << " nreps=" << *nreps;
+		if (budget) std::cout << " time=" << *budget << " s";
+		std::cout << "\n";
+		std::cout << "#lattice read in " << tl << " s ("
+			<< 1e-6 * lattice.file_size() / tl << " MB/s)\n";
+		std::cout << "#" << alg.get_info() << "; word size: " << alg_type::word_size << "\n";
+		if (target)
+			std::cout << "#target checked every " << *check << " sweeps\n";
+		if (*best)
+			std::cout << "#lowest energies every " << *check << " sweeps\n";
+#ifdef _OPENMP
+		std::cout << "#running " << *nthreads << " omp threads per sweep" << "\n";
+#endif
+	}
 
-		// read lattice
+	double t1 = get_time();
+	if (*verbose) std::cout << "#init done in " << t1 - t0 << " s\n";
 
-		lattice_type lattice(*latfile);
+	double t2 = get_time();
 
-		// schedule
+	// main loop
 
-		std::vector<sched_entry> sched = get_sched(*sched_kind, *nsweeps, *beta0, *beta1);
-		*nsweeps = sched.size();
+	std::vector<char> spins;
+	std::deque<target_run> runs;
+	improvement_log<value_type> improvements(names.size());
 
-		// init annealing
+	// the deadline of -time is checked between sweeps
+	double deadline = budget ? t0 + *budget : 0.0;
+	bool timed_out = false;
 
-		alg_type alg(lattice, sched);
+	std::size_t rep1 = nreps ? *rep0 + *nreps : std::numeric_limits<std::size_t>::max();
 
-		std::size_t offs = 0;
-		typedef Algorithm<>::value_type value_type;
-		std::vector<value_type> en(*nreps * alg_type::word_size, 0);
+	for (std::size_t rep = *rep0; rep < rep1; ++rep) {
+		runs.push_back(target_run{false, false, 0, 0.0});
+		target_run& run = runs.back();
+		double tr = get_time();
 
-		if (*verbose) {
-			if (def_sched)
-				std::cout << "#" << *sched_kind << " schedule: nsweeps="
-					<< *nsweeps << " b0=" << *beta0 << " b1=" << *beta1;
+		alg.reset_sites(rep);
+		for (std::size_t sweep = 0; sweep < *nsweeps; ++sweep) {
+			if (budget && get_time() >= deadline) {
+				timed_out = true;
+				break;
+			}
+#ifdef NFOLD_WAY
+			if (alg.get_acceptance() < *nfw)
+				alg.do_nfold_sweep(sweep);
 			else
-				std::cout << "#schedule from file " << *sched_kind
-					<< ": nsweeps=" << *nsweeps;
-			std::cout << "; rep0=" << *rep0 << " nreps=" << *nreps << "\n";
-			std::cout << "#" << alg.get_info() << "\n";
+#endif
+			alg.do_sweep(sweep);
+			++run.sweeps;
+
+			// the lowest energies are looked at after the loop anyway
+			if (*best && run.sweeps % *check == 0 && sweep + 1 < *nsweeps)
+				alg.update_best();
+
+			// the target is also checked after the last sweep
+			if (target && (run.sweeps % *check == 0 || sweep + 1 == *nsweeps)
+				&& alg.reached_energy(*target)) {
+				run.reached = true;
+				break;
+			}
+		}
+
+		if (*best) {
+			alg.update_best();
+			alg.restore_best();
 		}
 
-		double t1 = get_time();
-		if (*verbose) std::cout << "#init done in " << t1 - t0 << " s\n";
+		run.time = get_time() - tr;
 
-		double t2 = get_time();
+		// a repetition cut short by the deadline is left out
+		if (timed_out) break;
+		run.done = true;
 
-		// main loop
+		std::fill(en.begin(), en.end(), value_type(0));
+		alg.get_energies(en, 0);
+		for (std::size_t k = 0; k < en.size(); ++k)
+			hists[k % hists.size()].add(en[k]);
 
-		for (std::size_t rep = *rep0; rep < *nreps + *rep0; ++rep) {
-			alg.reset_sites(rep);
-			for (std::size_t sweep = 0; sweep < *nsweeps; ++sweep)
-				alg.do_sweep(sweep);
+		if (budget) improvements.add(en, rep, get_time() - t0);
 
-			offs = alg.get_energies(en, offs);
-		}
+		for (std::size_t k = 0; writer && k < en.size(); ++k)
+			if (writer->wanted(k, en[k])) {
+				alg.get_spins(k, spins);
+				writer->write(rep, k, en[k], spins);
+			}
+
+		if (*stop && run.reached) break;
+	}
+
+	double t3 = get_time();
+	if (*verbose) {
+		double nsweeps_done = 0;
+		for (const auto& run : runs)
+			nsweeps_done += run.sweeps;
+		std::cout << "#work done in " << t3 - t2 << " s\n";
+		std::cout << "#" << 1e-9 * nsweeps_done * alg_type::word_size * lattice.size() / (t3 - t2)
+			<< " spin updates per ns\n";
+	}
+
+	double t4 = get_time();
+
+	// print results
+
+	for (std::size_t i = 0; i < names.size(); ++i)
+		hists[i].print(names[i], *lowest);
+
+	if (target) print_target(runs, *target, *rep0, *verbose);
+
+	if (budget) {
+		std::size_t ndone = std::count_if(runs.begin(), runs.end(),
+			[](const target_run& run) { return run.done; });
+		improvements.print(names, ndone, *budget);
+	}
 
-		double t3 = get_time();
-		if (*verbose) std::cout << "#work done in " << t3 - t2 << " s\n";
+	if (writer) writer->close();
 
-		double t4 = get_time();
+	double t5 = get_time();
+	if (*verbose) std::cout << "#outp done in " << t5 - t4 << " s\n";
+}
 
-		// print results
+#ifdef MULTI_SPIN
+struct runner {
+	const amap_type& args;
+	double t0;
 
-		print_results(en, *latfile, *rep0, *nreps, *lowest);
+	template <typename W>
+	void run() const
+	{
+		anneal<Algorithm<W> >(args, t0);
+	}
+};
+#endif
 
-		double t5 = get_time();
-		if (*verbose) std::cout << "#outp done in " << t5 - t4 << " s\n";
+int main(int argc, char *argv[])
+{
+	try {
+		double t0 = get_time();
+
+		amap_type args = parse_args(argc, argv);
+
+#ifdef MULTI_SPIN
+		opt<unsigned> width = get_uarg(args, "w", 64);
+		with_word_type(*width, runner{args, t0});
+#else
+		anneal<Algorithm<> >(args, t0);
+#endif
 	} catch (std::exception& e) {
 		std::cerr << "error: " << e.what() << std::endl;
 	} catch (...) {
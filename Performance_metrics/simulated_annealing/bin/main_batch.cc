@@ -0,0 +1,386 @@
+/******************************************************************************
+
+Simulated annealing codes
+v1.0
+
+---------------------------------------------------------------------
+
+Main function for running many instances in one process using OPENMP.
+The instances are listed in a manifest file, one per line, each with
+its own sweeps, repetitions and schedule. The repetitions of all
+instances are handed out to one pool of threads, and the results of an
+instance are printed as soon as all its repetitions are done.
+
+---------------------------------------------------------------------
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*******************************************************************************/
+
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <stdexcept>
+#include <sys/stat.h>
+
+#ifdef _OPENMP
+#	include "omp.h"
+#else
+#	error "openmp is required"
+#endif
+
+#include "sched.h"
+#include "usage.h"
+#include "utils.h"
+#include "output.h"
+
+#ifndef ALGORITHM
+#error "Please specify the algorithm"
+#else
+#include ALGORITHM
+#endif
+
+// the single-spin codes keep their energy up to date, so that checking
+// it after every sweep is free
+#ifndef DEFAULT_CHECK
+#define DEFAULT_CHECK 1
+#endif
+
+// an instance of the manifest; the first thread that needs it builds
+// the algorithm, which the other threads copy, and the last thread to
+// finish a repetition of it prints its histogram and frees it
+
+template <typename alg_type>
+struct instance {
+	typedef typename alg_type::value_type value_type;
+
+	std::string latfile;
+	amap_type args;
+	unsigned nreps;
+	unsigned rep0;
+	std::shared_ptr<const std::vector<sched_entry> > sched;
+	double cost;
+
+	std::once_flag once;
+	std::unique_ptr<alg_type> alg;
+	std::unique_ptr<spin_writer> writer;
+	std::string error;
+	std::size_t nsites;
+
+	// histogram of the energies, filled by the threads under the lock
+	energy_histogram<value_type> hist;
+	std::mutex lock;
+	std::atomic<unsigned> ndone;
+	double work;
+};
+
+// a chunk of repetitions of an instance
+struct work_unit {
+	std::size_t inst;
+	unsigned r0;
+	unsigned r1;
+};
+
+// reads the manifest; every line is a lattice file followed by options
+// that override those of the command line; empty lines and lines that
+// start with '#' are skipped
+inline std::vector<amap_type> read_manifest(const std::string& file, const amap_type& args)
+{
+	std::ifstream fin(file.c_str());
+	if (!fin)
+		throw std::runtime_error("cannot open file " + file + " to read manifest");
+
+	std::vector<amap_type> insts;
+
+	std::string line;
+	for (std::size_t nline = 1; std::getline(fin, line); ++nline) {
+		std::istringstream sin(line);
+		std::vector<std::string> words;
+		for (std::string w; sin >> w; ) words.push_back(w);
+		if (words.empty() || words[0][0] == '#') continue;
+
+		// parse_args skips the first word, the lattice file
+		std::vector<char*> argv;
+		for (auto& w : words) argv.push_back(&w[0]);
+
+		amap_type a = args;
+		for (auto& kv : parse_args(argv.size(), argv.data()))
+			a[kv.first] = kv.second;
+		a["l"] = words[0];
+		if (!get_uarg(a, "r"))
+			throw std::runtime_error(file + ", line " + to_s(nline) + ": nreps is not provided");
+
+		insts.push_back(a);
+	}
+
+	return insts;
+}
+
+template <typename alg_type>
+void anneal(const amap_type& args, double t0)
+{
+	typedef instance<alg_type> instance_type;
+	typedef typename alg_type::lattice_type lattice_type;
+
+	// command line arguments; all but -m, -t, -chunk, -order, -v and -g
+	// can be given for every instance in the manifest, and -spins only
+	// there
+
+	opt<std::string> manifest = get_sarg(args, "m");
+	if (!manifest) usage_batch("manifest is not provided");
+	opt<unsigned> verbose = get_uarg(args, "v", 0);
+	opt<unsigned> lowest = get_uarg(args, "g", 0);
+	opt<unsigned> nthreads = get_uarg(args, "t", omp_get_max_threads());
+	opt<unsigned> nchunk = get_uarg(args, "chunk", 1);
+	if (*nchunk == 0) usage_batch("nchunk must be positive");
+	opt<std::string> site_order = get_sarg(args, "order", "none");
+	if (get_sarg(args, "spins"))
+		usage_batch("spins files are given for every instance in the manifest");
+
+	// instances and their schedules; instances with the same schedule
+	// share it
+
+	std::vector<amap_type> iargs = read_manifest(*manifest, args);
+
+	std::vector<std::unique_ptr<instance_type> > insts;
+	std::map<std::string, std::shared_ptr<const std::vector<sched_entry> > > scheds;
+
+	for (auto& a : iargs) {
+		std::unique_ptr<instance_type> inst(new instance_type);
+		inst->latfile = *get_sarg(a, "l");
+		inst->args = a;
+		inst->nreps = *get_uarg(a, "r");
+		inst->rep0 = *get_uarg(a, "r0", 0);
+
+		opt<unsigned> nsweeps = get_uarg(a, "s");
+		opt<std::string> sched_kind = get_sarg(a, "sched", "lin");
+		bool def_sched = *sched_kind == "lin" || *sched_kind == "exp";
+		if (!nsweeps && def_sched)
+			throw std::runtime_error("nsweeps is not provided for " + inst->latfile);
+
+		std::string key = *sched_kind;
+		for (auto o : { "s", "b0", "b1", "G0", "G1" })
+			key += " " + *get_sarg(a, o, "-");
+
+		auto& sched = scheds[key];
+		if (!sched)
+			sched = std::make_shared<std::vector<sched_entry> >(get_sched(*sched_kind, *nsweeps,
+				*get_darg(a, "b0", 0.1), *get_darg(a, "b1", 3.0),
+				*get_darg(a, "G0", 3.0), *get_darg(a, "G1", 0.0)));
+		inst->sched = sched;
+
+		// the size of the lattice file stands in for the number of sites
+		// until the lattice is read
+		struct stat st;
+		double size = stat(inst->latfile.c_str(), &st) == 0 ? st.st_size : 0;
+		inst->cost = size * inst->nreps * sched->size();
+
+		inst->nsites = 0;
+		inst->ndone = 0;
+		inst->work = 0;
+
+		insts.push_back(std::move(inst));
+	}
+
+	// the repetitions of the most expensive instances are handed out
+	// first, so that the small ones fill up the threads at the end
+
+	std::vector<std::size_t> order(insts.size());
+	for (std::size_t i = 0; i < order.size(); ++i) order[i] = i;
+	std::stable_sort(order.begin(), order.end(),
+		[&](std::size_t a, std::size_t b) { return insts[a]->cost > insts[b]->cost; });
+
+	std::vector<work_unit> units;
+	for (std::size_t i : order)
+		for (unsigned r = 0; r < insts[i]->nreps; r += *nchunk)
+			units.push_back({ i, r, std::min(r + *nchunk, insts[i]->nreps) });
+
+	unsigned n = std::max(1u, std::min<unsigned>(*nthreads, units.size()));
+
+	if (*verbose) {
+		std::cout << "#" << insts.size() << " instances from manifest " << *manifest
+			<< ", " << units.size() << " work units\n";
+		std::cout << "#word size: " << alg_type::word_size << "\n";
+		std::cout << "#running " << n << " omp threads, "
+			<< *nchunk << " repetitions at a time" << "\n";
+	}
+
+	double t1 = get_time();
+	if (*verbose) std::cout << "#init done in " << t1 - t0 << " s\n";
+
+	std::atomic<std::size_t> next(0);
+
+	#pragma omp parallel num_threads(n)
+	{
+		alg_type alg;
+		std::size_t cur = insts.size();
+
+		typedef typename alg_type::value_type value_type;
+		std::vector<value_type> en(alg_type::word_size);
+
+		for (std::size_t u = next++; u < units.size(); u = next++) {
+			instance_type& inst = *insts[units[u].inst];
+
+			std::call_once(inst.once, [&]() {
+				try {
+					lattice_type lattice(inst.latfile);
+					lattice.reorder(*site_order);
+					inst.alg.reset(new alg_type(lattice, *inst.sched));
+					inst.nsites = lattice.size();
+					opt<std::string> spinfile = get_sarg(inst.args, "spins");
+					if (spinfile)
+						inst.writer.reset(new spin_writer(*spinfile, lattice.get_labels(), *lowest));
+				} catch (std::exception& e) {
+					inst.error = e.what();
+				}
+			});
+
+			double tu = get_time();
+
+			if (inst.error.empty()) {
+				if (cur != units[u].inst) {
+					alg = *inst.alg;
+					cur = units[u].inst;
+				}
+
+				std::size_t nsweeps = inst.sched->size();
+#ifdef NFOLD_WAY
+				double nfw = *get_darg(inst.args, "nfw", 0.0);
+#endif
+				unsigned best = *get_uarg(inst.args, "best", 0);
+				unsigned check = std::max(1u, *get_uarg(inst.args, "check", DEFAULT_CHECK));
+
+				energy_histogram<value_type> hist;
+				std::vector<char> spins;
+
+				for (unsigned r = units[u].r0; r < units[u].r1; ++r) {
+					alg.reset_sites(inst.rep0 + r);
+					for (std::size_t sweep = 0; sweep < nsweeps; ++sweep) {
+#ifdef NFOLD_WAY
+						if (alg.get_acceptance() < nfw)
+							alg.do_nfold_sweep(sweep);
+						else
+#endif
+						alg.do_sweep(sweep);
+
+						if (best && (sweep + 1) % check == 0 && sweep + 1 < nsweeps)
+							alg.update_best();
+					}
+
+					if (best) {
+						alg.update_best();
+						alg.restore_best();
+					}
+
+					std::fill(en.begin(), en.end(), value_type(0));
+					alg.get_energies(en, 0);
+					for (std::size_t k = 0; k < en.size(); ++k)
+						hist.add(en[k]);
+
+					for (std::size_t k = 0; inst.writer && k < en.size(); ++k)
+						if (inst.writer->wanted(k, en[k])) {
+							alg.get_spins(k, spins);
+							inst.writer->write(inst.rep0 + r, k, en[k], spins);
+						}
+				}
+
+				std::lock_guard<std::mutex> guard(inst.lock);
+				inst.hist.merge(hist);
+			}
+
+			tu = get_time() - tu;
+			#pragma omp atomic
+			inst.work += tu;
+
+			// the thread that completes an instance prints it
+			if ((inst.ndone += units[u].r1 - units[u].r0) < inst.nreps) continue;
+
+			// the records of the instance are written before it is printed
+			if (inst.writer) {
+				try {
+					inst.writer->close();
+				} catch (std::exception& e) {
+					inst.error = e.what();
+				}
+			}
+
+			#pragma omp critical(output)
+			{
+				if (!inst.error.empty())
+					std::cerr << "error: " << inst.error << std::endl;
+				else {
+					if (*verbose) {
+						#pragma omp atomic read
+						tu = inst.work;
+						std::cout << "#instance " << inst.latfile << ": nsites=" << inst.nsites
+							<< " nsweeps=" << inst.sched->size() << " rep0=" << inst.rep0
+							<< " nreps=" << inst.nreps << "; work done in " << tu << " thread s\n";
+					}
+					inst.hist.print(inst.latfile, *lowest);
+					std::cout << std::flush;
+				}
+			}
+
+			inst.alg.reset();
+			inst.writer.reset();
+			inst.hist = energy_histogram<typename instance_type::value_type>();
+		}
+	}
+
+	double t2 = get_time();
+	if (*verbose) std::cout << "#work done in " << t2 - t1 << " s\n";
+}
+
+#ifdef MULTI_SPIN
+struct runner {
+	const amap_type& args;
+	double t0;
+
+	template <typename W>
+	void run() const
+	{
+		anneal<Algorithm<W> >(args, t0);
+	}
+};
+#endif
+
+int main(int argc, char *argv[])
+{
+	try {
+		double t0 = get_time();
+
+		amap_type args = parse_args(argc, argv);
+
+#ifdef MULTI_SPIN
+		opt<unsigned> width = get_uarg(args, "w", 64);
+		with_word_type(*width, runner{args, t0});
+#else
+		anneal<Algorithm<> >(args, t0);
+#endif
+	} catch (std::exception& e) {
+		std::cerr << "error: " << e.what() << std::endl;
+	} catch (...) {
+		std::cerr << "unknown error" << std::endl;
+	}
+
+	return 0;
+}
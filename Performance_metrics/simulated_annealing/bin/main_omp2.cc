@@ -27,7 +27,11 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 *******************************************************************************/
 
 #include <string>
+#include <deque>
 #include <vector>
+#include <atomic>
+#include <algorithm>
+#include <limits>
 #include <memory>
 #include <iostream>
 #include <iomanip>
@@ -50,113 +54,349 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include ALGORITHM
 #endif
 
-int main(int argc, char *argv[])
-{
-	try {
-		double t0 = get_time();
+// the single-spin codes keep their energy up to date, so that checking
+// it after every sweep is free
+#ifndef DEFAULT_CHECK
+#define DEFAULT_CHECK 1
+#endif
 
-		// command line arguments
+template <typename alg_type>
+void anneal(const amap_type& args, double t0)
+{
+	// command line arguments
+
+	opt<std::string> latfile = get_sarg(args, "l");
+#ifdef LANE_INSTANCES
+	// with -lanes, lane k of every word anneals instance k % n of the n
+	// instances listed in a file, which share the sites and links of the
+	// first one; -l is then not needed
+	opt<std::string> lanefile = get_sarg(args, "lanes");
+	std::vector<std::string> lanefiles;
+	if (lanefile) {
+		lanefiles = read_file_list(*lanefile);
+		if (lanefiles.size() > alg_type::word_size)
+			usage("more instances in " + *lanefile + " than lanes", false);
+		latfile = opt<std::string>(lanefiles[0]);
+	}
+#endif
+	if (!latfile) usage("lattice is not provided", false);
+	opt<unsigned> nsweeps = get_uarg(args, "s");
+	opt<unsigned> nreps = get_uarg(args, "r");
+	opt<double> beta0 = get_darg(args, "b0", 0.1);
+	opt<double> beta1 = get_darg(args, "b1", 3.0);
+	opt<double> gamma0 = get_darg(args, "G0", 3.0);
+	opt<double> gamma1 = get_darg(args, "G1", 0.0);
+	opt<unsigned> rep0 = get_uarg(args, "r0", 0);
+	opt<unsigned> verbose = get_uarg(args, "v", 0);
+	opt<unsigned> lowest = get_uarg(args, "g", 0);
+	opt<std::string> spinfile = get_sarg(args, "spins");
+	// with -target a repetition stops as soon as one of its replicas
+	// reaches the energy, and with -stop the first one ends the run
+	opt<double> target = get_darg(args, "target");
+	opt<unsigned> stop = get_uarg(args, "stop", 0);
+	if (*stop && !target) usage("stop requires a target", false);
+	// with -best the lowest energy state of every replica, looked at
+	// every [check] sweeps and at the end, is reported instead of the
+	// final one
+	opt<unsigned> best = get_uarg(args, "best", 0);
+	// sweeps between two checks of the target and the lowest energies
+	opt<unsigned> check = get_uarg(args, "check", DEFAULT_CHECK);
+	if (*check == 0) usage("check must be positive", false);
+	// with -time repetitions are run until the time budget, counted from
+	// the start of the program, is used up, or until -r of them are done
+	opt<double> budget = get_darg(args, "time");
+	if (!nreps && !budget) usage("nreps is not provided", false);
+	if (budget && !(*budget > 0)) usage("time budget must be positive", false);
+	opt<unsigned> nthreads = get_uarg(args, "t", omp_get_max_threads());
+	opt<std::string> sched_kind = get_sarg(args, "sched", "lin");
+	opt<std::string> site_order = get_sarg(args, "order", "none");
+	opt<unsigned> nchunk = get_uarg(args, "chunk", 1);
+	if (*nchunk == 0) usage("nchunk must be positive", false);
+	// -numa implies -pin
+	opt<unsigned> numa = get_uarg(args, "numa", 0);
+	opt<unsigned> pin = get_uarg(args, "pin", *numa);
+#ifdef NFOLD_WAY
+	// acceptance rate below which the n-fold way is used
+	opt<double> nfw = get_darg(args, "nfw", 0.0);
+#endif
+	bool def_sched = *sched_kind == "lin" || *sched_kind == "exp";
+	if (!nsweeps && def_sched)
+		usage("nsweeps is not provided", false);
+
+	typedef typename alg_type::lattice_type lattice_type;
+
+	// read lattice
+
+	double tl = get_time();
+	lattice_type lattice(*latfile);
+	tl = get_time() - tl;
+	lattice.reorder(*site_order);
+#ifdef LANE_INSTANCES
+	std::deque<lattice_type> lane_lattices;
+	std::vector<const lattice_type*> lanes;
+	for (std::size_t n = 0; lanefile && n < lanefiles.size(); ++n) {
+		lane_lattices.emplace_back(lanefiles[n]);
+		lanes.push_back(&lane_lattices.back());
+	}
+#endif
 
-		amap_type args = parse_args(argc, argv);
+	// schedule
 
-		opt<std::string> latfile = get_sarg(args, "l");
-		if (!latfile) usage("lattice is not provided", false);
-		opt<unsigned> nsweeps = get_uarg(args, "s");
-		opt<unsigned> nreps = get_uarg(args, "r");
-		if (!nreps) usage("nreps is not provided", false);
-		opt<double> beta0 = get_darg(args, "b0", 0.1);
-		opt<double> beta1 = get_darg(args, "b1", 3.0);
-		opt<unsigned> rep0 = get_uarg(args, "r0", 0);
-		opt<unsigned> verbose = get_uarg(args, "v", 0);
-		opt<unsigned> lowest = get_uarg(args, "g", 0);
-		opt<unsigned> nthreads = get_uarg(args, "t", omp_get_max_threads());
-		opt<std::string> sched_kind = get_sarg(args, "sched", "lin");
-		bool def_sched = *sched_kind == "lin" || *sched_kind == "exp";
-		if (!nsweeps && def_sched)
-			usage("nsweeps is not provided", false);
+	std::vector<sched_entry> sched = get_sched(*sched_kind, *nsweeps, *beta0, *beta1, *gamma0, *gamma1);
+	*nsweeps = sched.size();
 
-		typedef Algorithm<> alg_type;
-		typedef alg_type::lattice_type lattice_type;
+	// init annealing
 
-		// read lattice
+	unsigned n = std::max(1u, nreps ? std::min(*nthreads, *nreps) : *nthreads);
+	std::vector<alg_type> algs(n);
 
-		lattice_type lattice(*latfile);
+	// with -pin every thread is bound to a cpu and copies its instance
+	// there, so that its replica is allocated in the memory of its NUMA
+	// node; with -numa the first thread on every node builds its own
+	// copy of the lattice and thresholds, which the other threads on
+	// that node share
 
-		// schedule
+	std::vector<thread_place> place;
+	std::vector<unsigned> source(n, 0);
+	if (*pin) {
+		place = place_threads(n);
+		if (!pin_thread(place[0].cpu))
+			std::cerr << "warning: cannot pin threads on this system\n";
+		// threads are placed round robin, so thread k is the first on node k
+		if (*numa)
+			for (unsigned m = 0; m < n; ++m)
+				source[m] = place[m].node;
+	}
 
-		std::vector<sched_entry> sched = get_sched(*sched_kind, *nsweeps, *beta0, *beta1);
-		*nsweeps = sched.size();
+#ifdef LANE_INSTANCES
+	auto make_alg = [&]() { return alg_type(lattice, sched, lanes); };
+#else
+	auto make_alg = [&]() { return alg_type(lattice, sched); };
+#endif
 
-		// init annealing
+	// copies share the lattice and thresholds of algs[0]
+	algs[0] = make_alg();
 
-		unsigned n = std::min(*nthreads, *nreps - *rep0);
-		std::vector<alg_type> algs(n);
+	typedef typename alg_type::value_type value_type;
 
-#ifdef OMP_VERSION_2
-		#pragma omp parallel num_threads(n)
-		{
-			unsigned m = omp_get_thread_num();
-			algs[m] = alg_type(lattice, sched);
-		}
-#else
-		algs[0] = alg_type(lattice, sched);
+	// histograms of the energies; with -lanes lane k adds to the
+	// histogram of instance k % n
+	std::vector<std::string> names(1, *latfile);
+#ifdef LANE_INSTANCES
+	if (lanefile) names = lanefiles;
 #endif
 
-		typedef alg_type::value_type value_type;
-		std::vector<value_type> en(*nreps * alg_type::word_size, 0);
-
-		if (*verbose) {
-			if (def_sched)
-				std::cout << "#" << *sched_kind << " schedule: nsweeps="
-					<< *nsweeps << " b0=" << *beta0 << " b1=" << *beta1;
-			else
-				std::cout << "#schedule from file " << *sched_kind
-					<< ": nsweeps=" << *nsweeps;
-			std::cout << "; rep0=" << *rep0 << " nreps=" << *nreps << "\n";
-			std::cout << "#" << algs[0].get_info() << "\n";
-			std::cout << "#running " << algs.size() << " omp threads" << "\n";
+	// with -spins the final configurations are written by a background
+	// thread; with -g only those of the lowest energy of every instance
+	std::unique_ptr<spin_writer> writer;
+	if (spinfile)
+		writer.reset(new spin_writer(*spinfile, lattice.get_labels(), *lowest, names.size()));
+	std::vector<std::vector<energy_histogram<value_type> > > hists(n,
+		std::vector<energy_histogram<value_type> >(names.size()));
+
+	if (*verbose) {
+		if (def_sched)
+			std::cout << "#" << *sched_kind << " schedule: nsweeps="
+				<< *nsweeps << " b0=" << *beta0 << " b1=" << *beta1;
+		else
+			std::cout << "#schedule from file " << *sched_kind
+				<< ": nsweeps=" << *nsweeps;
+#ifdef TRANSVERSE_FIELD
+		if (def_sched)
+			std::cout << " G0=" << *gamma0 << " G1=" << *gamma1;
+#endif
+		std::cout << "; rep0=" << *rep0;
+		if (nreps) std::cout << " nreps=" << *nreps;
+		if (budget) std::cout << " time=" << *budget << " s";
+		std::cout << "\n";
+		std::cout << "#lattice read in " << tl << " s ("
+			<< 1e-6 * lattice.file_size() / tl << " MB/s)\n";
+		std::cout << "#" << algs[0].get_info() << "; word size: " << alg_type::word_size << "\n";
+		if (target)
+			std::cout << "#target checked every " << *check << " sweeps\n";
+		if (*best)
+			std::cout << "#lowest energies every " << *check << " sweeps\n";
+		std::cout << "#running " << algs.size() << " omp threads, "
+			<< *nchunk << " repetitions at a time" << "\n";
+		if (*pin) {
+			unsigned nnodes = 1 + std::max_element(place.begin(), place.end(),
+				[](const thread_place& a, const thread_place& b) { return a.node < b.node; })->node;
+			std::cout << "#threads pinned to cpus on " << nnodes << " NUMA node(s)";
+			if (*numa) std::cout << ", one instance per node";
+			std::cout << "\n";
 		}
+	}
 
-		double t1 = get_time();
-		if (*verbose) std::cout << "#init done in " << t1 - t0 << " s\n";
+	double t1 = get_time();
+	if (*verbose) std::cout << "#init done in " << t1 - t0 << " s\n";
 
-		double t2 = get_time();
+	double t2 = get_time();
 
-		#pragma omp parallel num_threads(n)
-		{
-			unsigned n = omp_get_num_threads();
-			unsigned m = omp_get_thread_num();
+	// outcome of every repetition, which grows as the threads take them
+	// with -time; stopped is set by the first one that reaches the target
+	// with -stop, which ends the others
+	std::deque<target_run> runs(nreps ? *nreps : 0, target_run{false, false, 0, 0.0});
+	std::atomic<bool> stopped(false);
+	improvement_log<value_type> improvements(names.size());
 
-#ifndef OMP_VERSION_2
-			if (m > 0) algs[m] = algs[0];
-#endif
+	// the deadline of -time is checked between sweeps
+	double deadline = budget ? t0 + *budget : 0.0;
+
+	std::size_t nr = nreps ? *nreps : std::numeric_limits<std::size_t>::max();
+	std::atomic<std::size_t> next(0);
+
+	#pragma omp parallel num_threads(n)
+	{
+		unsigned m = omp_get_thread_num();
+
+		if (*pin && m > 0) pin_thread(place[m].cpu);
+		if (source[m] == m && m > 0) algs[m] = make_alg();
+
+		#pragma omp barrier
+
+		if (source[m] != m) algs[m] = algs[source[m]];
+
+		// main loop; threads take chunks of repetitions as they become
+		// free and add the energies to their own histograms, which are
+		// merged in the end, so the results do not depend on the timing
+		// of the threads
 
-			std::size_t r0 = *rep0 + *nreps * m / n;
-			std::size_t r1 = *rep0 + *nreps * (m + 1) / n;
-			std::size_t offs = *nreps * m / n * alg_type::word_size;
+		std::vector<value_type> en(alg_type::word_size);
+		std::vector<char> spins;
+		bool timed_out = false;
 
-			// main loop
+		for (std::size_t r = next.fetch_add(*nchunk); r < nr && !stopped && !timed_out;
+			r = next.fetch_add(*nchunk))
+			for (std::size_t rep = *rep0 + r; rep < *rep0 + std::min(r + *nchunk, nr); ++rep) {
+				target_run* prun;
+				#pragma omp critical(runs)
+				{
+					if (runs.size() <= rep - *rep0)
+						runs.resize(rep - *rep0 + 1, target_run{false, false, 0, 0.0});
+					prun = &runs[rep - *rep0];
+				}
+
+				target_run& run = *prun;
+				double tr = get_time();
 
-			for (std::size_t rep = r0; rep < r1; ++rep) {
 				algs[m].reset_sites(rep);
-				for (std::size_t sweep = 0; sweep < *nsweeps; ++sweep)
+				for (std::size_t sweep = 0; sweep < *nsweeps; ++sweep) {
+					if (*stop && stopped) break;
+					if (budget && get_time() >= deadline) {
+						timed_out = true;
+						break;
+					}
+#ifdef NFOLD_WAY
+					if (algs[m].get_acceptance() < *nfw)
+						algs[m].do_nfold_sweep(sweep);
+					else
+#endif
 					algs[m].do_sweep(sweep);
-
-				offs = algs[m].get_energies(en, offs);
+					++run.sweeps;
+
+					// the lowest energies are looked at after the loop anyway
+					if (*best && run.sweeps % *check == 0 && sweep + 1 < *nsweeps)
+						algs[m].update_best();
+
+					// the target is also checked after the last sweep
+					if (target && (run.sweeps % *check == 0 || sweep + 1 == *nsweeps)
+						&& algs[m].reached_energy(*target)) {
+						run.reached = true;
+						if (*stop) stopped = true;
+						break;
+					}
+				}
+
+				if (*best) {
+					algs[m].update_best();
+					algs[m].restore_best();
+				}
+
+				run.time = get_time() - tr;
+
+				// repetitions cut short by -stop or the deadline are left out
+				if (timed_out) break;
+				if (stopped && !run.reached) break;
+				run.done = true;
+
+				std::fill(en.begin(), en.end(), value_type(0));
+				algs[m].get_energies(en, 0);
+				for (std::size_t k = 0; k < en.size(); ++k)
+					hists[m][k % names.size()].add(en[k]);
+
+				if (budget) {
+					#pragma omp critical(improvements)
+					improvements.add(en, rep, get_time() - t0);
+				}
+
+				for (std::size_t k = 0; writer && k < en.size(); ++k)
+					if (writer->wanted(k, en[k])) {
+						algs[m].get_spins(k, spins);
+						writer->write(rep, k, en[k], spins);
+					}
 			}
-		}
+	}
+
+	double t3 = get_time();
+	if (*verbose) {
+		double nsweeps_done = 0;
+		for (const auto& run : runs)
+			nsweeps_done += run.sweeps;
+		std::cout << "#work done in " << t3 - t2 << " s\n";
+		std::cout << "#" << 1e-9 * nsweeps_done * alg_type::word_size * lattice.size() / (t3 - t2)
+			<< " spin updates per ns\n";
+	}
 
-		double t3 = get_time();
-		if (*verbose) std::cout << "#work done in " << t3 - t2 << " s\n";
+	double t4 = get_time();
+
+	// print results
+
+	for (std::size_t i = 0; i < names.size(); ++i) {
+		for (unsigned m = 1; m < n; ++m)
+			hists[0][i].merge(hists[m][i]);
+		hists[0][i].print(names[i], *lowest);
+	}
+
+	if (target) print_target(runs, *target, *rep0, *verbose);
+
+	if (budget) {
+		std::size_t ndone = std::count_if(runs.begin(), runs.end(),
+			[](const target_run& run) { return run.done; });
+		improvements.print(names, ndone, *budget);
+	}
 
-		double t4 = get_time();
+	if (writer) writer->close();
 
-		// print results
+	double t5 = get_time();
+	if (*verbose) std::cout << "#outp done in " << t5 - t4 << " s\n";
+}
 
-		print_results(en, *latfile, *rep0, *nreps, *lowest);
+#ifdef MULTI_SPIN
+struct runner {
+	const amap_type& args;
+	double t0;
 
-		double t5 = get_time();
-		if (*verbose) std::cout << "#outp done in " << t5 - t4 << " s\n";
+	template <typename W>
+	void run() const
+	{
+		anneal<Algorithm<W> >(args, t0);
+	}
+};
+#endif
+
+int main(int argc, char *argv[])
+{
+	try {
+		double t0 = get_time();
+
+		amap_type args = parse_args(argc, argv);
+
+#ifdef MULTI_SPIN
+		opt<unsigned> width = get_uarg(args, "w", 64);
+		with_word_type(*width, runner{args, t0});
+#else
+		anneal<Algorithm<> >(args, t0);
+#endif
 	} catch (std::exception& e) {
 		std::cerr << "error: " << e.what() << std::endl;
 	} catch (...) {
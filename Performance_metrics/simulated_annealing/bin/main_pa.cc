@@ -0,0 +1,417 @@
+/******************************************************************************
+
+Simulated annealing codes
+v1.0
+
+---------------------------------------------------------------------
+
+Main function for population annealing codes using OPENMP. A
+population of replicas is annealed through the schedule with the
+algorithm given by ALGORITHM and resampled according to Boltzmann
+weights between temperature steps.
+
+---------------------------------------------------------------------
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*******************************************************************************/
+
+#include <cmath>
+#include <limits>
+#include <string>
+#include <vector>
+#include <random>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <stdexcept>
+
+#ifdef _OPENMP
+#	include "omp.h"
+#else
+#	error "openmp is required"
+#endif
+
+#include "sched.h"
+#include "usage.h"
+#include "utils.h"
+#include "output.h"
+
+// the replicas interact and sweep many times at every temperature of
+// the schedule, so the single-spin generic codes draw fresh thresholds
+// for every sweep of every replica instead of sharing stored ones (see
+// thresholds.h)
+#ifndef ONTHEFLY_THRESHOLDS
+#define ONTHEFLY_THRESHOLDS
+#endif
+
+#ifndef ALGORITHM
+#error "Please specify the algorithm"
+#else
+#include ALGORITHM
+#endif
+
+// work space of the resampling shared by the threads; the entries of
+// thread m and lane k are at m * word_size + k, the holes and extras
+// of thread m and lane k at k * nthreads + m
+
+struct resample_data {
+	resample_data(std::size_t ninst, std::size_t ws, unsigned nthreads)
+		: wt(ninst * ws), tmin(nthreads * ws), tsum(nthreads * ws),
+		holes(nthreads * ws), extras(nthreads * ws), kind(ninst) {}
+
+	std::vector<double> wt;
+	std::vector<double> tmin;
+	std::vector<double> tsum;
+	std::vector<std::vector<std::size_t> > holes;
+	std::vector<std::vector<std::size_t> > extras;
+	// 1 if the instance is a hole of some lane, 2 if it has extras, 3 if both
+	std::vector<char> kind;
+};
+
+// resamples the population with weights exp(-db * E) and adds the log
+// of the mean weight of every lane to lnz. Every lane is a population
+// of its own since lanes cannot be moved within an instance; all lanes
+// are resampled at once. Must be called by all threads of the parallel
+// region; thread m owns the instances [ninst * m / n, ninst * (m + 1) / n)
+// and is the only one to write them. spare holds a copy of every instance
+// if word_size > 1 and is empty otherwise.
+
+template <typename alg_type>
+void resample(std::vector<alg_type>& algs, std::vector<alg_type>& spare,
+	const std::vector<typename alg_type::value_type>& en,
+	double db, const std::vector<double>& u, resample_data& rd,
+	std::vector<double>& lnz)
+{
+	const std::size_t ws = alg_type::word_size;
+	const std::size_t ninst = algs.size();
+
+	unsigned n = omp_get_num_threads();
+	unsigned m = omp_get_thread_num();
+
+	std::size_t o0 = ninst * m / n;
+	std::size_t o1 = ninst * (m + 1) / n;
+
+	// weights relative to the lowest energy of every lane
+
+	for (std::size_t k = 0; k < ws; ++k) {
+		double emin = std::numeric_limits<double>::max();
+		for (std::size_t o = o0; o < o1; ++o)
+			emin = std::min(emin, double(en[o * ws + k]));
+		rd.tmin[m * ws + k] = emin;
+	}
+
+	#pragma omp barrier
+
+	std::vector<double> emin(ws, std::numeric_limits<double>::max());
+	for (unsigned l = 0; l < n; ++l)
+		for (std::size_t k = 0; k < ws; ++k)
+			emin[k] = std::min(emin[k], rd.tmin[l * ws + k]);
+
+	for (std::size_t k = 0; k < ws; ++k)
+		rd.tsum[m * ws + k] = 0.0;
+	for (std::size_t o = o0; o < o1; ++o)
+		for (std::size_t k = 0; k < ws; ++k) {
+			rd.wt[o * ws + k] = std::exp(-db * (en[o * ws + k] - emin[k]));
+			rd.tsum[m * ws + k] += rd.wt[o * ws + k];
+		}
+
+	#pragma omp barrier
+
+	// systematic resampling of every lane: instance o gets as many copies
+	// of lane k as there are points (j + u[k]) * total / ninst in its
+	// weight interval; the instances without copies are holes, the
+	// surplus copies extras
+
+	std::vector<double> total(ws, 0.0);
+	for (std::size_t k = 0; k < ws; ++k) {
+		double offs = 0.0;
+		for (unsigned l = 0; l < n; ++l) {
+			if (l == m) offs = total[k];
+			total[k] += rd.tsum[l * ws + k];
+		}
+
+		std::vector<std::size_t>& holes = rd.holes[k * n + m];
+		std::vector<std::size_t>& extras = rd.extras[k * n + m];
+		holes.clear();
+		extras.clear();
+
+		double c = 0.0;
+		std::size_t lo = std::size_t(offs / total[k] * ninst + u[k]);
+		for (std::size_t o = o0; o < o1; ++o) {
+			c += rd.wt[o * ws + k];
+			std::size_t hi = std::size_t((offs + c) / total[k] * ninst + u[k]);
+
+			if (hi == lo)
+				holes.push_back(o);
+			for (std::size_t j = lo + 1; j < hi; ++j)
+				extras.push_back(o);
+
+			lo = hi;
+		}
+	}
+
+	// an instance that is a hole of one lane and has extras of another
+	// is written by its owner while other threads copy from it; they copy
+	// from its spare copy instead. Only instances with several lanes can
+	// be both.
+
+	std::vector<char> all(ws, 1);
+
+	std::fill(rd.kind.begin() + o0, rd.kind.begin() + o1, 0);
+	for (std::size_t k = 0; k < ws; ++k) {
+		for (const auto o : rd.holes[k * n + m]) rd.kind[o] |= 1;
+		for (const auto o : rd.extras[k * n + m]) rd.kind[o] |= 2;
+	}
+	for (std::size_t o = o0; o < o1; ++o)
+		if (rd.kind[o] == 3) spare[o].copy_lanes(algs[o], all);
+
+	#pragma omp barrier
+
+	// every lane has as many holes as extras; hole j of a lane, numbered
+	// across the threads, is filled from extra j of the lane. Every thread
+	// fills the holes among its own instances.
+
+	std::vector<char> lanes(ws, 0);
+
+	for (std::size_t k = 0; k < ws; ++k) {
+		const std::vector<std::size_t>& holes = rd.holes[k * n + m];
+		if (holes.empty()) continue;
+
+		std::size_t ei = 0;
+		for (unsigned l = 0; l < m; ++l)
+			ei += rd.holes[k * n + l].size();
+
+		unsigned el = 0;
+		while (ei >= rd.extras[k * n + el].size())
+			ei -= rd.extras[k * n + el++].size();
+
+		lanes[k] = 1;
+		for (const auto o : holes) {
+			std::size_t src = rd.extras[k * n + el][ei];
+			algs[o].copy_lanes(rd.kind[src] == 3 ? spare[src] : algs[src], lanes);
+
+			if (++ei == rd.extras[k * n + el].size())
+				for (ei = 0, ++el; el < n && rd.extras[k * n + el].empty(); ++el);
+		}
+		lanes[k] = 0;
+	}
+
+	#pragma omp barrier
+
+	if (m == 0)
+		for (std::size_t k = 0; k < ws; ++k)
+			lnz[k] += std::log(total[k] / ninst) - db * emin[k];
+}
+
+template <typename alg_type>
+void anneal(const amap_type& args, double t0)
+{
+	// command line arguments
+
+	opt<std::string> latfile = get_sarg(args, "l");
+	if (!latfile) usage_pa("lattice is not provided");
+	opt<unsigned> nsweeps = get_uarg(args, "s");
+	if (!nsweeps) usage_pa("nsweeps is not provided");
+	opt<unsigned> nreps = get_uarg(args, "r");
+	if (!nreps) usage_pa("nreps is not provided");
+	opt<unsigned> popsize = get_uarg(args, "p", 1000);
+	opt<unsigned> ntemps = get_uarg(args, "nt", 100);
+	opt<double> beta0 = get_darg(args, "b0", 0.1);
+	opt<double> beta1 = get_darg(args, "b1", 3.0);
+	opt<unsigned> rep0 = get_uarg(args, "r0", 0);
+	opt<unsigned> verbose = get_uarg(args, "v", 0);
+	opt<unsigned> lowest = get_uarg(args, "g", 0);
+	opt<unsigned> nthreads = get_uarg(args, "t", omp_get_max_threads());
+	opt<std::string> sched_kind = get_sarg(args, "sched", "lin");
+	opt<std::string> site_order = get_sarg(args, "order", "none");
+	bool def_sched = *sched_kind == "lin" || *sched_kind == "exp";
+
+	typedef typename alg_type::lattice_type lattice_type;
+	typedef typename alg_type::value_type value_type;
+
+	const std::size_t ws = alg_type::word_size;
+
+	// read lattice
+
+	lattice_type lattice(*latfile);
+	lattice.reorder(*site_order);
+
+	// temperature steps; step t is done at the inverse temperature
+	// sched[t].beta
+
+	std::vector<sched_entry> sched = get_sched(*sched_kind, *ntemps, *beta0, *beta1);
+	*ntemps = sched.size();
+	if (*ntemps == 0)
+		usage_pa("at least one temperature is required");
+
+	// init population of instances with word_size replicas each; lane k
+	// of the instances is a population of popsize replicas
+
+	std::size_t ninst = std::max(*popsize, 1u);
+	unsigned n = std::min<std::size_t>(*nthreads, ninst);
+	std::vector<alg_type> algs(ninst);
+
+	// copies share the lattice and thresholds of algs[0]
+	algs[0] = alg_type(lattice, sched);
+	#pragma omp parallel num_threads(n)
+	{
+		unsigned n = omp_get_num_threads();
+		unsigned m = omp_get_thread_num();
+		for (std::size_t o = ninst * m / n; o < ninst * (m + 1) / n; ++o)
+			if (o > 0) algs[o] = algs[0];
+	}
+
+	// copies of the instances that are read while other lanes are filled
+	std::vector<alg_type> spare(ws > 1 ? ninst : 0, algs[0]);
+
+	resample_data rd(ninst, ws, n);
+
+	std::vector<value_type> en(ninst * ws, 0);
+	std::vector<value_type> results;
+	results.reserve(*nreps * ninst * ws);
+
+	std::vector<double> u(ws);
+	std::vector<double> lnz(ws);
+	double free_energy = 0.0;
+
+	if (*verbose) {
+		if (def_sched)
+			std::cout << "#" << *sched_kind << " schedule: ntemps="
+				<< *ntemps << " b0=" << *beta0 << " b1=" << *beta1;
+		else
+			std::cout << "#schedule from file " << *sched_kind
+				<< ": ntemps=" << *ntemps;
+		std::cout << "; nsweeps=" << *nsweeps << " per temperature";
+		std::cout << "; population=" << ninst;
+		if (ws > 1) std::cout << " in each of " << ws << " lanes";
+		std::cout << "; rep0=" << *rep0 << " nreps=" << *nreps << "\n";
+		std::cout << "#" << algs[0].get_info() << "; word size: " << ws << "\n";
+		std::cout << "#running " << n << " omp threads" << "\n";
+	}
+
+	double t1 = get_time();
+	if (*verbose) std::cout << "#init done in " << t1 - t0 << " s\n";
+
+	double t2 = get_time();
+
+	for (std::size_t rep = *rep0; rep < *nreps + *rep0; ++rep) {
+		std::mt19937 rgen(rep + 1);
+		std::uniform_real_distribution<double> uni(0.0, 1.0);
+
+		std::fill(lnz.begin(), lnz.end(), 0.0);
+
+		#pragma omp parallel num_threads(n)
+		{
+			unsigned n = omp_get_num_threads();
+			unsigned m = omp_get_thread_num();
+
+			std::size_t o0 = ninst * m / n;
+			std::size_t o1 = ninst * (m + 1) / n;
+
+			// random start configurations are samples at beta = 0
+
+			for (std::size_t o = o0; o < o1; ++o)
+				algs[o].reset_sites(rep * ninst + o);
+
+			// main loop
+
+			for (std::size_t t = 0; t < *ntemps; ++t) {
+				for (std::size_t o = o0; o < o1; ++o) {
+					std::fill(en.begin() + o * ws, en.begin() + (o + 1) * ws, value_type(0));
+					algs[o].get_energies(en, o * ws);
+				}
+
+				#pragma omp single
+				for (std::size_t k = 0; k < ws; ++k)
+					u[k] = uni(rgen);
+
+				double db = sched[t].beta - (t > 0 ? sched[t - 1].beta : 0.0);
+				resample(algs, spare, en, db, u, rd, lnz);
+
+				for (std::size_t o = o0; o < o1; ++o)
+					for (std::size_t s = 0; s < *nsweeps; ++s)
+						algs[o].do_sweep(t);
+			}
+
+			for (std::size_t o = o0; o < o1; ++o) {
+				std::fill(en.begin() + o * ws, en.begin() + (o + 1) * ws, value_type(0));
+				algs[o].get_energies(en, o * ws);
+			}
+		}
+
+		results.insert(results.end(), en.begin(), en.end());
+
+		// F = -(ln Z(0) + sum of ln mean weights) / beta, ln Z(0) = N ln 2
+
+		double f = 0.0;
+		for (std::size_t k = 0; k < ws; ++k)
+			f += -(lattice.size() * std::log(2.0) + lnz[k]) / sched.back().beta;
+		f /= ws;
+		free_energy += f;
+
+		if (*verbose)
+			std::cout << "#rep " << rep << ": free energy " << f << "\n";
+	}
+
+	double t3 = get_time();
+	if (*verbose) std::cout << "#work done in " << t3 - t2 << " s\n";
+
+	double t4 = get_time();
+
+	// print results
+
+	print_results(results, *latfile, *rep0, *nreps, *lowest);
+
+	std::cout << "#free energy at beta " << sched.back().beta << ": "
+		<< free_energy / *nreps << "\n";
+
+	double t5 = get_time();
+	if (*verbose) std::cout << "#outp done in " << t5 - t4 << " s\n";
+}
+
+#ifdef MULTI_SPIN
+struct runner {
+	const amap_type& args;
+	double t0;
+
+	template <typename W>
+	void run() const
+	{
+		anneal<Algorithm<W> >(args, t0);
+	}
+};
+#endif
+
+int main(int argc, char *argv[])
+{
+	try {
+		double t0 = get_time();
+
+		amap_type args = parse_args(argc, argv);
+
+#ifdef MULTI_SPIN
+		opt<unsigned> width = get_uarg(args, "w", 64);
+		with_word_type(*width, runner{args, t0});
+#else
+		anneal<Algorithm<> >(args, t0);
+#endif
+	} catch (std::exception& e) {
+		std::cerr << "error: " << e.what() << std::endl;
+	} catch (...) {
+		std::cerr << "unknown error" << std::endl;
+	}
+
+	return 0;
+}
@@ -0,0 +1,348 @@
+/******************************************************************************
+
+Simulated annealing codes
+v1.0
+
+---------------------------------------------------------------------
+
+Main function for parallel tempering (replica-exchange) codes using
+OPENMP. Replicas are kept at the fixed inverse temperatures of a
+ladder, swept with the algorithm given by ALGORITHM and exchanged
+between neighboring temperatures.
+
+---------------------------------------------------------------------
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*******************************************************************************/
+
+#include <cmath>
+#include <string>
+#include <vector>
+#include <random>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <stdexcept>
+
+#ifdef _OPENMP
+#	include "omp.h"
+#else
+#	error "openmp is required"
+#endif
+
+#include "sched.h"
+#include "usage.h"
+#include "utils.h"
+#include "output.h"
+
+// the replicas interact and sweep many times at every temperature of
+// the ladder, so the single-spin generic codes draw fresh thresholds
+// for every sweep of every replica instead of sharing stored ones (see
+// thresholds.h)
+#ifndef ONTHEFLY_THRESHOLDS
+#define ONTHEFLY_THRESHOLDS
+#endif
+
+#ifndef ALGORITHM
+#error "Please specify the algorithm"
+#else
+#include ALGORITHM
+#endif
+
+#ifdef LANE_EXCHANGE
+
+// exchanges lanes of instances at neighboring temperatures;
+// instance t always stays at temperature t
+
+template <typename alg_type, typename G>
+void swap_replicas(std::vector<alg_type>& algs,
+	std::vector<typename alg_type::value_type>& en,
+	const std::vector<sched_entry>& ladder, std::vector<unsigned>&,
+	unsigned parity, G& rgen)
+{
+	const std::size_t ws = alg_type::word_size;
+	std::uniform_real_distribution<double> uni(0.0, 1.0);
+	std::vector<char> lanes(ws);
+
+	for (std::size_t t = parity; t + 1 < algs.size(); t += 2) {
+		double db = ladder[t].beta - ladder[t + 1].beta;
+
+		bool any = false;
+		for (std::size_t k = 0; k < ws; ++k) {
+			double d = db * (en[t * ws + k] - en[(t + 1) * ws + k]);
+			lanes[k] = d >= 0 || uni(rgen) < std::exp(d);
+			if (lanes[k]) {
+				std::swap(en[t * ws + k], en[(t + 1) * ws + k]);
+				any = true;
+			}
+		}
+
+		if (any) algs[t].exchange_lanes(algs[t + 1], lanes);
+	}
+}
+
+#else
+
+// exchanges temperatures of instances at neighboring temperatures;
+// instance o is at temperature temp[o]
+
+template <typename alg_type, typename G>
+void swap_replicas(std::vector<alg_type>& algs,
+	std::vector<typename alg_type::value_type>& en,
+	const std::vector<sched_entry>& ladder, std::vector<unsigned>& temp,
+	unsigned parity, G& rgen)
+{
+	static_assert(alg_type::word_size == 1,
+		"algorithms with more than one replica per instance must define LANE_EXCHANGE");
+
+	std::uniform_real_distribution<double> uni(0.0, 1.0);
+
+	std::vector<unsigned> inst(algs.size());
+	for (std::size_t o = 0; o < algs.size(); ++o)
+		inst[temp[o]] = o;
+
+	for (std::size_t t = parity; t + 1 < algs.size(); t += 2) {
+		unsigned a = inst[t];
+		unsigned b = inst[t + 1];
+
+		double d = (ladder[t].beta - ladder[t + 1].beta) * (en[a] - en[b]);
+		if (d >= 0 || uni(rgen) < std::exp(d)) {
+			temp[a] = t + 1;
+			temp[b] = t;
+		}
+	}
+}
+
+#endif
+
+template <typename alg_type>
+void temper(const amap_type& args, double t0)
+{
+	// command line arguments
+
+	opt<std::string> latfile = get_sarg(args, "l");
+	if (!latfile) usage_pt("lattice is not provided");
+	opt<unsigned> nsweeps = get_uarg(args, "s");
+	if (!nsweeps) usage_pt("nsweeps is not provided");
+	opt<unsigned> nreps = get_uarg(args, "r");
+	if (!nreps) usage_pt("nreps is not provided");
+	opt<double> beta0 = get_darg(args, "b0", 0.1);
+	opt<double> beta1 = get_darg(args, "b1", 3.0);
+	opt<unsigned> ntemps = get_uarg(args, "nt", 32);
+	opt<unsigned> nswap = get_uarg(args, "se", 1);
+	opt<double> target = get_darg(args, "target");
+	opt<unsigned> rep0 = get_uarg(args, "r0", 0);
+	opt<unsigned> verbose = get_uarg(args, "v", 0);
+	opt<unsigned> lowest = get_uarg(args, "g", 0);
+	opt<unsigned> nthreads = get_uarg(args, "t", omp_get_max_threads());
+	opt<std::string> sched_kind = get_sarg(args, "sched", "exp");
+	opt<std::string> site_order = get_sarg(args, "order", "none");
+	bool def_sched = *sched_kind == "lin" || *sched_kind == "exp";
+	if (*nswap == 0) *nswap = 1;
+
+	typedef typename alg_type::lattice_type lattice_type;
+	typedef typename alg_type::value_type value_type;
+
+	const std::size_t ws = alg_type::word_size;
+
+	// read lattice
+
+	lattice_type lattice(*latfile);
+	lattice.reorder(*site_order);
+
+	// temperature ladder
+
+	std::vector<sched_entry> ladder = get_sched(*sched_kind, *ntemps, *beta0, *beta1);
+	*ntemps = ladder.size();
+	if (*ntemps < 2)
+		usage_pt("at least two temperatures are required");
+
+	// init instances, one per temperature; sweep t of an instance
+	// is done at the inverse temperature ladder[t].beta
+
+	unsigned n = std::min(*nthreads, *ntemps);
+	std::vector<alg_type> algs(*ntemps);
+
+	// copies share the lattice and thresholds of algs[0]
+	algs[0] = alg_type(lattice, ladder);
+	#pragma omp parallel num_threads(n)
+	{
+		unsigned n = omp_get_num_threads();
+		unsigned m = omp_get_thread_num();
+		for (std::size_t o = *ntemps * m / n; o < *ntemps * (m + 1) / n; ++o)
+			if (o > 0) algs[o] = algs[0];
+	}
+
+	std::vector<value_type> best(*nreps * ws, 0);
+	std::vector<value_type> en(*ntemps * ws, 0);
+	std::vector<unsigned> temp(*ntemps);
+
+	std::vector<std::size_t> tts_sweeps(*nreps, 0);
+	std::vector<double> tts_time(*nreps, 0.0);
+	std::vector<char> reached(*nreps, 0);
+
+	if (*verbose) {
+		if (def_sched)
+			std::cout << "#" << *sched_kind << " ladder: ntemps="
+				<< *ntemps << " b0=" << *beta0 << " b1=" << *beta1;
+		else
+			std::cout << "#ladder from file " << *sched_kind
+				<< ": ntemps=" << *ntemps;
+		std::cout << "; nsweeps=" << *nsweeps << " swap every " << *nswap << " sweeps";
+		std::cout << "; rep0=" << *rep0 << " nreps=" << *nreps << "\n";
+		std::cout << "#" << algs[0].get_info() << "; word size: " << ws << "\n";
+		std::cout << "#running " << n << " omp threads" << "\n";
+	}
+
+	double t1 = get_time();
+	if (*verbose) std::cout << "#init done in " << t1 - t0 << " s\n";
+
+	double t2 = get_time();
+
+	for (std::size_t rep = *rep0; rep < *nreps + *rep0; ++rep) {
+		const std::size_t r = rep - *rep0;
+		std::mt19937 rgen(rep + 1);
+
+		for (std::size_t o = 0; o < *ntemps; ++o)
+			temp[o] = o;
+
+		bool done = false;
+		double tr0 = get_time();
+
+		#pragma omp parallel num_threads(n)
+		{
+			unsigned n = omp_get_num_threads();
+			unsigned m = omp_get_thread_num();
+
+			std::size_t o0 = *ntemps * m / n;
+			std::size_t o1 = *ntemps * (m + 1) / n;
+
+			for (std::size_t o = o0; o < o1; ++o)
+				algs[o].reset_sites(rep * *ntemps + o);
+
+			// main loop
+
+			for (std::size_t sweep = 0; sweep < *nsweeps && !done; sweep += *nswap) {
+				std::size_t s1 = std::min<std::size_t>(sweep + *nswap, *nsweeps);
+
+				for (std::size_t o = o0; o < o1; ++o) {
+					for (std::size_t s = sweep; s < s1; ++s)
+						algs[o].do_sweep(temp[o]);
+
+					std::fill(en.begin() + o * ws, en.begin() + (o + 1) * ws, value_type(0));
+					algs[o].get_energies(en, o * ws);
+				}
+
+				#pragma omp barrier
+
+				#pragma omp single
+				{
+					for (std::size_t o = 0; o < *ntemps; ++o)
+						for (std::size_t k = 0; k < ws; ++k) {
+							value_type e = en[o * ws + k];
+							if ((sweep == 0 && o == 0) || e < best[r * ws + k])
+								best[r * ws + k] = e;
+						}
+
+					if (target)
+						for (std::size_t k = 0; k < ws && !done; ++k)
+							if (best[r * ws + k] <= *target) {
+								reached[r] = 1;
+								tts_sweeps[r] = s1;
+								tts_time[r] = get_time() - tr0;
+								done = true;
+							}
+
+					swap_replicas(algs, en, ladder, temp, (sweep / *nswap) % 2, rgen);
+				}
+			}
+		}
+
+		if (*verbose && target) {
+			if (reached[r])
+				std::cout << "#rep " << rep << ": target reached after " << tts_sweeps[r]
+					<< " sweeps in " << tts_time[r] << " s\n";
+			else
+				std::cout << "#rep " << rep << ": target not reached\n";
+		}
+	}
+
+	double t3 = get_time();
+	if (*verbose) std::cout << "#work done in " << t3 - t2 << " s\n";
+
+	double t4 = get_time();
+
+	// print results
+
+	print_results(best, *latfile, *rep0, *nreps, *lowest);
+
+	if (target) {
+		std::size_t nreached = 0;
+		double sweeps = 0.0;
+		double time = 0.0;
+		for (std::size_t r = 0; r < *nreps; ++r)
+			if (reached[r]) {
+				++nreached;
+				sweeps += tts_sweeps[r];
+				time += tts_time[r];
+			}
+
+		std::cout << "#target " << *target << " reached in " << nreached
+			<< " of " << *nreps << " runs";
+		if (nreached > 0)
+			std::cout << "; mean sweeps to target " << sweeps / nreached
+				<< " (" << sweeps / nreached * *ntemps << " replica sweeps)"
+				<< "; mean time to target " << time / nreached << " s";
+		std::cout << "\n";
+	}
+
+	double t5 = get_time();
+	if (*verbose) std::cout << "#outp done in " << t5 - t4 << " s\n";
+}
+
+#ifdef MULTI_SPIN
+struct runner {
+	const amap_type& args;
+	double t0;
+
+	template <typename W>
+	void run() const
+	{
+		temper<Algorithm<W> >(args, t0);
+	}
+};
+#endif
+
+int main(int argc, char *argv[])
+{
+	try {
+		double t0 = get_time();
+
+		amap_type args = parse_args(argc, argv);
+
+#ifdef MULTI_SPIN
+		opt<unsigned> width = get_uarg(args, "w", 64);
+		with_word_type(*width, runner{args, t0});
+#else
+		temper<Algorithm<> >(args, t0);
+#endif
+	} catch (std::exception& e) {
+		std::cerr << "error: " << e.what() << std::endl;
+	} catch (...) {
+		std::cerr << "unknown error" << std::endl;
+	}
+
+	return 0;
+}
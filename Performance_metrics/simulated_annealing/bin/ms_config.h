@@ -38,6 +38,18 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define USE_5_NEIGHB
 #define USE_6_NEIGHB
 
+// used only by codes generated by gen_ms for more than 6 neighbors
+#define USE_7_NEIGHB
+#define USE_8_NEIGHB
+#define USE_9_NEIGHB
+#define USE_10_NEIGHB
+#define USE_11_NEIGHB
+#define USE_12_NEIGHB
+#define USE_13_NEIGHB
+#define USE_14_NEIGHB
+#define USE_15_NEIGHB
+#define USE_16_NEIGHB
+
 inline bool check_number_of_neighbors(unsigned nneighbs)
 {
 	switch (nneighbs) {
@@ -76,6 +88,66 @@ inline bool check_number_of_neighbors(unsigned nneighbs)
 		return true;
 #else
 		return false;
+#endif
+	case 7:
+#ifdef USE_7_NEIGHB
+		return true;
+#else
+		return false;
+#endif
+	case 8:
+#ifdef USE_8_NEIGHB
+		return true;
+#else
+		return false;
+#endif
+	case 9:
+#ifdef USE_9_NEIGHB
+		return true;
+#else
+		return false;
+#endif
+	case 10:
+#ifdef USE_10_NEIGHB
+		return true;
+#else
+		return false;
+#endif
+	case 11:
+#ifdef USE_11_NEIGHB
+		return true;
+#else
+		return false;
+#endif
+	case 12:
+#ifdef USE_12_NEIGHB
+		return true;
+#else
+		return false;
+#endif
+	case 13:
+#ifdef USE_13_NEIGHB
+		return true;
+#else
+		return false;
+#endif
+	case 14:
+#ifdef USE_14_NEIGHB
+		return true;
+#else
+		return false;
+#endif
+	case 15:
+#ifdef USE_15_NEIGHB
+		return true;
+#else
+		return false;
+#endif
+	case 16:
+#ifdef USE_16_NEIGHB
+		return true;
+#else
+		return false;
 #endif
 	default:
 		return false;
@@ -5,7 +5,9 @@ v1.0
 
 ---------------------------------------------------------------------
 
-Contains a function that prints results.
+Contains the histogram of energies, functions that print results,
+times to target and improvements of the lowest energy, and the writer
+of spin configurations.
 
 ---------------------------------------------------------------------
 
@@ -30,43 +32,386 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define __OUTPUT_H__
 
 #include <map>
+#include <cmath>
+#include <deque>
+#include <mutex>
+#include <limits>
 #include <string>
+#include <thread>
 #include <vector>
+#include <cstdint>
+#include <cstring>
+#include <numeric>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <stdexcept>
+#include <condition_variable>
+
+// histogram of energies that is filled as the repetitions finish;
+// integer energies are counted exactly, others in bins of width 1e-8,
+// which are printed with the lowest energy in them. Histograms of
+// different threads are merged, and the result does not depend on the
+// order in which energies are added or histograms are merged.
+
+template <typename value_type>
+class energy_histogram {
+public:
+	energy_histogram() : total(0) {}
+
+	void add(value_type e, std::size_t count = 1)
+	{
+		bin& b = bins[key(e)];
+		if (b.count == 0 || e < b.emin) b.emin = e;
+		b.count += count;
+		total += count;
+	}
+
+	void merge(const energy_histogram& other)
+	{
+		for (auto it = other.bins.begin(); it != other.bins.end(); ++it)
+			add(it->second.emin, it->second.count);
+	}
+
+	// number of energies
+	std::size_t size() const
+	{
+		return total;
+	}
+
+	void print(const std::string& latfile, bool lowest) const
+	{
+		double scale = 1.0 / total;
+		for (auto it = bins.begin(); it != bins.end(); ++it) {
+			std::cout << std::setw(10) << it->second.emin;
+			std::cout << std::setw(10) << it->second.count;
+			std::cout << std::setw(16) << double(it->second.count) * scale;
+			std::cout << "    " << latfile << "\n";
+
+			if (lowest) break;
+		}
+	}
+private:
+	struct bin {
+		bin() : emin(0), count(0) {}
+
+		value_type emin;
+		std::size_t count;
+	};
+
+	static long long key(value_type e)
+	{
+		if (std::numeric_limits<value_type>::is_integer)
+			return (long long)(e);
+		else
+			return std::llround(e * 1e8);
+	}
+
+	std::map<long long, bin> bins;
+	std::size_t total;
+};
 
 template <typename value_type>
 void print_results(const std::vector<value_type>& en,
 	const std::string& latfile, unsigned rep0, unsigned nreps, bool lowest)
 {
-	std::map<value_type, std::size_t> map;
-	for (std::size_t i = 0; i < en.size(); ++i) {
-		/* typename std::map<value_type, std::size_t>::iterator it = map.find(en[i]); */
+	energy_histogram<value_type> hist;
+	for (std::size_t i = 0; i < en.size(); ++i)
+		hist.add(en[i]);
+
+	hist.print(latfile, lowest);
+}
 
-		auto it = map.begin();
-		while (it != map.end()) {
-			if (std::fabs(it->first - en[i]) < 1e-08)
-				break;
+// a repetition run with -target: whether it finished (-stop and -time
+// cut the others short), whether it reached the target energy, and the number
+// of sweeps and the time it took
+struct target_run {
+	bool done;
+	bool reached;
+	std::size_t sweeps;
+	double time;
+};
 
-			++it;
+// prints in how many of the finished repetitions the target was
+// reached and the mean number of sweeps and time to target; in verbose
+// mode the outcome of every repetition is printed first
+inline void print_target(const std::deque<target_run>& runs, double target,
+	unsigned rep0, bool verbose)
+{
+	std::size_t ndone = 0;
+	std::size_t nreached = 0;
+	double sweeps = 0.0;
+	double time = 0.0;
+	for (std::size_t r = 0; r < runs.size(); ++r) {
+		if (!runs[r].done) continue;
+		++ndone;
+		if (runs[r].reached) {
+			++nreached;
+			sweeps += runs[r].sweeps;
+			time += runs[r].time;
 		}
 
-		if (it == map.end())
-			map[en[i]] = 1;
+		if (!verbose) continue;
+		if (runs[r].reached)
+			std::cout << "#rep " << rep0 + r << ": target reached after " << runs[r].sweeps
+				<< " sweeps in " << runs[r].time << " s\n";
 		else
-			++it->second;
+			std::cout << "#rep " << rep0 + r << ": target not reached\n";
 	}
 
-	double scale = 1.0 / en.size();
-	typename std::map<value_type, std::size_t>::const_iterator it = map.begin();
-	for (; it != map.end(); ++it) {
-		std::cout << std::setw(10) << it->first;
-		std::cout << std::setw(10) << it->second;
-		std::cout << std::setw(16) << double(it->second) * scale;
-//		std::cout << std::setw(10) << rep0 << std::setw(10) << nreps;
-		std::cout << "    " << latfile << "\n";
+	std::cout << "#target " << target << " reached in " << nreached
+		<< " of " << ndone << " repetitions";
+	if (nreached > 0)
+		std::cout << "; mean sweeps to target " << sweeps / nreached
+			<< "; mean time to target " << time / nreached << " s";
+	std::cout << "\n";
+}
+
+// the lowest energy of every instance (lanes are grouped as for the
+// histograms) as it is lowered by the repetitions that finish within
+// the time budget of -time, with the repetition that lowered it and
+// the time it finished, in seconds from the start of the program
+
+template <typename value_type>
+class improvement_log {
+public:
+	improvement_log(std::size_t ngroups = 1) : groups(ngroups) {}
+
+	void add(const std::vector<value_type>& en, std::size_t rep, double time)
+	{
+		for (std::size_t i = 0; i < groups.size(); ++i) {
+			value_type emin = en[i];
+			for (std::size_t k = i; k < en.size(); k += groups.size())
+				emin = std::min(emin, en[k]);
 
-		if (lowest) break;
+			if (groups[i].empty() || emin < groups[i].back().energy)
+				groups[i].push_back(improvement{emin, rep, time});
+		}
 	}
-}
+
+	void print(const std::vector<std::string>& names, std::size_t ndone, double budget) const
+	{
+		for (std::size_t i = 0; i < groups.size(); ++i)
+			for (const auto& imp : groups[i])
+				std::cout << "#energy " << imp.energy << " found in rep " << imp.rep
+					<< " at " << imp.time << " s    " << names[i] << "\n";
+
+		std::cout << "#" << ndone << " repetitions done in the time budget of "
+			<< budget << " s\n";
+	}
+private:
+	struct improvement {
+		value_type energy;
+		std::size_t rep;
+		double time;
+	};
+
+	std::vector<std::vector<improvement> > groups;
+};
+
+// writes spin configurations to a binary file in a background thread;
+// the annealing threads only hand the spins over. The file starts with
+// a header and the labels of the sites in ascending order (nsites
+// uint32); every record is a record header followed by the spins of
+// the sites in the order of the labels, 64 per uint64 word starting
+// with the lowest bit, 1 for up. All numbers are in the byte order of
+// the machine. With lowest set, a configuration is only written if its
+// energy is not above that of the configurations written before it, so
+// the last records of a file (or of every group of lanes, see below)
+// are the lowest energy configurations found.
+
+class spin_writer {
+public:
+	struct file_header {
+		char magic[8];
+		uint64_t nsites;
+		uint64_t reserved;
+	};
+
+	struct record_header {
+		uint64_t rep;
+		uint32_t lane;
+		uint32_t reserved;
+		double energy;
+	};
+
+	static const char* magic()
+	{
+		return "SASPIN01";
+	}
+
+	// lane k belongs to group k % ngroups, e.g. the instance it anneals
+	template <typename L>
+	spin_writer(const std::string& file, const std::vector<L>& labels,
+		bool lowest, std::size_t ngroups = 1)
+	: file(file), lowest(lowest), emin(ngroups), nwritten(ngroups, 0),
+		order(labels.size()), done(false), failed(false)
+	{
+		fout.open(file.c_str(), std::ios_base::out | std::ios_base::binary);
+		if (!fout)
+			throw std::runtime_error("cannot open file " + file + " to write spins");
+
+		std::iota(order.begin(), order.end(), 0);
+		std::sort(order.begin(), order.end(),
+			[&](std::size_t a, std::size_t b) { return labels[a] < labels[b]; });
+
+		file_header h = file_header();
+		std::memcpy(h.magic, magic(), sizeof(h.magic));
+		h.nsites = labels.size();
+
+		std::vector<uint32_t> ls(labels.size());
+		for (std::size_t j = 0; j < order.size(); ++j)
+			ls[j] = labels[order[j]];
+
+		fout.write(reinterpret_cast<const char*>(&h), sizeof(h));
+		fout.write(reinterpret_cast<const char*>(ls.data()), ls.size() * sizeof(uint32_t));
+
+		thread = std::thread(&spin_writer::run, this);
+	}
+
+	~spin_writer()
+	{
+		if (thread.joinable()) stop();
+	}
+
+	// tells whether a configuration of the given lane and energy would be
+	// written, so that its spins need not be collected otherwise
+	bool wanted(std::size_t lane, double energy)
+	{
+		if (!lowest) return true;
+
+		std::lock_guard<std::mutex> guard(lock);
+		return keep(lane % emin.size(), energy);
+	}
+
+	// queues the spins of a replica, one char per site in the order of
+	// the sites; spins is swapped with a used buffer
+	void write(std::size_t rep, std::size_t lane, double energy, std::vector<char>& spins)
+	{
+		std::unique_lock<std::mutex> guard(lock);
+		space.wait(guard, [&]() { return queue.size() < max_queued; });
+
+		queue.push_back(item());
+		item& it = queue.back();
+		it.rep = rep;
+		it.lane = lane;
+		it.energy = energy;
+		it.spins.swap(spins);
+
+		if (!pool.empty()) {
+			spins.swap(pool.back());
+			pool.pop_back();
+		}
+
+		guard.unlock();
+		ready.notify_one();
+	}
+
+	// writes the queued records and closes the file
+	void close()
+	{
+		stop();
+		if (failed)
+			throw std::runtime_error("cannot write spins to file " + file);
+	}
+private:
+	struct item {
+		std::size_t rep;
+		std::size_t lane;
+		double energy;
+		std::vector<char> spins;
+	};
+
+	static const std::size_t max_queued = 1024;
+
+	// energies equal within 1e-8 count as equal, as in energy_histogram;
+	// called under the lock
+	bool keep(std::size_t group, double energy) const
+	{
+		return nwritten[group] == 0 || energy <= emin[group] + 1e-8;
+	}
+
+	void stop()
+	{
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			done = true;
+		}
+		ready.notify_one();
+		thread.join();
+
+		fout.close();
+		if (!fout) failed = true;
+	}
+
+	void run()
+	{
+		std::vector<uint64_t> words((order.size() + 63) / 64);
+
+		std::unique_lock<std::mutex> guard(lock);
+		for (;;) {
+			ready.wait(guard, [&]() { return done || !queue.empty(); });
+			if (queue.empty()) break;
+
+			item it;
+			it.spins.swap(queue.front().spins);
+			it.rep = queue.front().rep;
+			it.lane = queue.front().lane;
+			it.energy = queue.front().energy;
+			queue.pop_front();
+
+			std::size_t group = it.lane % emin.size();
+			bool write = !lowest || keep(group, it.energy);
+			if (write) {
+				if (nwritten[group] == 0 || it.energy < emin[group]) emin[group] = it.energy;
+				++nwritten[group];
+			}
+
+			guard.unlock();
+			space.notify_one();
+
+			if (write) {
+				record_header h = record_header();
+				h.rep = it.rep;
+				h.lane = it.lane;
+				h.energy = it.energy;
+
+				std::fill(words.begin(), words.end(), 0);
+				for (std::size_t j = 0; j < order.size(); ++j)
+					words[j / 64] |= uint64_t(it.spins[order[j]] != 0) << (j % 64);
+
+				fout.write(reinterpret_cast<const char*>(&h), sizeof(h));
+				fout.write(reinterpret_cast<const char*>(words.data()), words.size() * sizeof(uint64_t));
+			}
+
+			guard.lock();
+			pool.push_back(std::vector<char>());
+			pool.back().swap(it.spins);
+		}
+	}
+
+	std::string file;
+	std::ofstream fout;
+	bool lowest;
+
+	// lowest energy and number of configurations written of every group
+	std::vector<double> emin;
+	std::vector<std::size_t> nwritten;
+
+	// order[j] is the site with the j-th lowest label
+	std::vector<std::size_t> order;
+
+	std::mutex lock;
+	std::condition_variable ready;
+	std::condition_variable space;
+	std::deque<item> queue;
+	std::vector<std::vector<char> > pool;
+	bool done;
+	bool failed;
+
+	std::thread thread;
+};
 
 #endif
 
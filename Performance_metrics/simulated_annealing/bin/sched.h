@@ -33,45 +33,56 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <cmath>
 #include <string>
 #include <vector>
-#include <fstream>
 #include <stdexcept>
 
+#include "utils.h"
+
+// gamma is the transverse field of quantum annealing codes;
+// classical codes ignore it
+
 struct sched_entry {
 	double beta;
+	double gamma;
 };
 
 inline std::vector<sched_entry> get_sched(const std::string sched_kind,
-	unsigned nsweeps, double beta0, double beta1)
+	unsigned nsweeps, double beta0, double beta1,
+	double gamma0 = 0.0, double gamma1 = 0.0)
 {
 	std::vector<sched_entry> sched;
 
+	double gscale = nsweeps > 1 ? (gamma1 - gamma0) / (nsweeps - 1) : 0.0;
+
 	if (sched_kind == "lin") {
 		sched.resize(nsweeps);
 		double bscale = nsweeps > 1 ? (beta1 - beta0) / (nsweeps - 1) : 0.0;
-		for (std::size_t i = 0; i < nsweeps; ++i)
+		for (std::size_t i = 0; i < nsweeps; ++i) {
 			sched[i].beta = beta0 + bscale * i;
+			sched[i].gamma = gamma0 + gscale * i;
+		}
 	} else if (sched_kind == "exp") {
 		sched.resize(nsweeps);
 		sched[0].beta = beta0;
 		double db = std::pow(beta1 / beta0, 1.0 / (nsweeps - 1));
 		for (std::size_t i = 1; i < nsweeps; ++i)
 			sched[i].beta = sched[i - 1].beta * db;
+		for (std::size_t i = 0; i < nsweeps; ++i)
+			sched[i].gamma = gamma0 + gscale * i;
 	} else {
-		std::ifstream fin;
-		fin.open(sched_kind.c_str(), std::ios_base::in);
-		if (!fin)
-			throw std::runtime_error("cannot open file " + sched_kind + " to read schedule");
+		text_reader in(sched_kind, "schedule");
 
 		sched.reserve(10000);
 
-		while (1) {
+		// every line is "beta" or "beta gamma"; lines that do not start
+		// with a number are comments
+		while (in.next_line()) {
 			double beta;
-			fin >> beta;
-			if (!fin) break;
-			sched.push_back({beta});
+			double gamma = 0.0;
+			if (!in.at_number()) continue;
+			if (!in.read(beta) || (!in.end_of_line() && !in.read(gamma)) || !in.end_of_line())
+				in.error("expected an inverse temperature and an optional transverse field");
+			sched.push_back({beta, gamma});
 		}
-
-		fin.close();
 	}
 
 	return sched;
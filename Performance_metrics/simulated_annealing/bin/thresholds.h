@@ -0,0 +1,226 @@
+/******************************************************************************
+
+Simulated annealing codes
+v1.0
+
+---------------------------------------------------------------------
+
+Contains the table of acceptance thresholds of the single-spin generic
+codes. A flip is accepted if the energy change is below the threshold
+-ln(u) / (c beta) of the site, where u is a uniform random number and
+c is a constant factor of the code.
+
+By default the thresholds of every sweep and site are drawn in advance,
+which takes nsweeps x nsites doubles. If ONTHEFLY_THRESHOLDS is defined
+(make DEFS=-DONTHEFLY_THRESHOLDS), the thresholds of a sweep are drawn
+at its start from a counter-based generator (splitmix64) keyed by the
+replica, the sweep and the site, which takes O(nsites) memory for any
+number of sweeps. The exponential random numbers are drawn with a ziggurat, so
+they rarely take a logarithm. Every sweep gets fresh and independent
+thresholds, distributed as the stored ones.
+
+A sweep is given by its entry of the schedule, which sets the
+temperature, and by its count since the start of the run of a replica,
+which keys the thresholds drawn on the fly together with the replica.
+Annealing does the entries in order, so the two agree. Tempering and
+population annealing do many sweeps at one entry, and their replicas
+interact, so they must not share thresholds; main_pt.cc and main_pa.cc
+always draw them on the fly.
+
+Copies of a table share the thresholds (or the key and the scales), so
+copying it is cheap; only the thresholds of the current sweep of
+on-the-fly tables belong to the copy.
+
+---------------------------------------------------------------------
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*******************************************************************************/
+
+#ifndef __THRESHOLDS_H__
+#define __THRESHOLDS_H__
+
+#include <cmath>
+#include <vector>
+#include <cstdint>
+#include <memory>
+#include <algorithm>
+
+class threshold_table {
+public:
+	threshold_table() {}
+
+	// thresholds -ln(u) / (c beta) of n sites for every sweep of the
+	// schedule; if twice is set, the thresholds of a sweep are stored
+	// twice in a row, so that every rotation of them is contiguous
+	template <typename SE, typename RNG>
+	threshold_table(const std::vector<SE>& sched0, std::size_t n, double c,
+		bool twice, RNG& rng) : n(n), ncopies(twice ? 2 : 1)
+	{
+#ifdef ONTHEFLY_THRESHOLDS
+		std::shared_ptr<key_type> p = std::make_shared<key_type>();
+
+		p->scale.resize(sched0.size());
+		for (std::size_t sweep = 0; sweep < sched0.size(); ++sweep)
+			p->scale[sweep] = 1 / (c * sched0[sweep].beta);
+
+		p->seed = uint64_t(rng() * 4294967296.0) << 32 | uint64_t(rng() * 4294967296.0);
+
+		key = p;
+		table.resize(ncopies * n);
+		start(0);
+#else
+		std::shared_ptr<std::vector<std::vector<double> > > p =
+			std::make_shared<std::vector<std::vector<double> > >(sched0.size());
+
+		for (std::size_t sweep = 0; sweep < sched0.size(); ++sweep) {
+			std::vector<double>& t = (*p)[sweep];
+			t.resize(ncopies * n);
+			for (std::size_t i = 0; i < n; ++i)
+				t[i] = -std::log(rng()) / (c * sched0[sweep].beta);
+			if (ncopies == 2) std::copy(t.begin(), t.begin() + n, t.begin() + n);
+		}
+
+		tables = p;
+#endif
+	}
+
+	// starts the run of a replica; the thresholds drawn on the fly are
+	// keyed by the replica as well, so that replicas that run together
+	// draw independent thresholds
+	void start(std::size_t replica)
+	{
+#ifdef ONTHEFLY_THRESHOLDS
+		seed = splitmix64(key->seed, replica);
+		cur = cur_count = std::size_t(-1);
+#endif
+	}
+
+	// thresholds of the count-th sweep of the run of a replica, done at
+	// the given entry of the schedule
+	const double* get(std::size_t sweep, std::size_t count)
+	{
+#ifdef ONTHEFLY_THRESHOLDS
+		if (sweep != cur || count != cur_count) fill(sweep, count);
+		return table.data();
+#else
+		return (*tables)[sweep].data();
+#endif
+	}
+
+private:
+	std::size_t n;
+	std::size_t ncopies;
+
+#ifdef ONTHEFLY_THRESHOLDS
+	struct key_type {
+		std::vector<double> scale;
+		uint64_t seed;
+	};
+
+	std::shared_ptr<const key_type> key;
+	std::vector<double> table;
+	std::size_t cur;
+	std::size_t cur_count;
+	uint64_t seed;
+
+	// output of splitmix64 at the given position of its sequence
+	static uint64_t splitmix64(uint64_t seed, uint64_t pos)
+	{
+		uint64_t z = seed + (pos + 1) * 0x9e3779b97f4a7c15ull;
+		z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+		z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+		return z ^ (z >> 31);
+	}
+
+	// uniform random number in (0, 1) from the high 53 bits of z
+	static double uniform(uint64_t z)
+	{
+		return ((z >> 11) + 0.5) / 9007199254740992.0;
+	}
+
+	// ziggurat of the standard exponential distribution with 256 layers
+	// (G. Marsaglia and W. W. Tsang, J. Stat. Softw. 5, 8 (2000)); the
+	// low 8 bits of a random word pick a layer and the high 32 bits the
+	// position in it, so about 99% of the draws take no logarithm. The
+	// rare draws outside the rectangles take more words, by hashing the
+	// last one, and the tail beyond r is sampled exactly.
+	struct ziggurat {
+		uint32_t k[256];
+		double w[256];
+		double f[256];
+
+		ziggurat()
+		{
+			const double m = 4294967296.0;
+			const double v = 3.949659822581572e-3;
+			double d = r(), t = d;
+			double q = v / std::exp(-d);
+
+			k[0] = uint32_t(d / q * m);
+			k[1] = 0;
+			w[0] = q / m;
+			w[255] = d / m;
+			f[0] = 1;
+			f[255] = std::exp(-d);
+
+			for (int i = 254; i >= 1; --i) {
+				d = -std::log(v / d + std::exp(-d));
+				k[i + 1] = uint32_t(d / t * m);
+				t = d;
+				f[i] = std::exp(-d);
+				w[i] = d / m;
+			}
+		}
+
+		static double r() { return 7.697117470131487; }
+
+		double operator()(uint64_t z) const
+		{
+			for (;;) {
+				unsigned i = z & 255;
+				uint32_t j = uint32_t(z >> 32);
+				if (j < k[i]) return j * w[i];
+				if (i == 0) return r() - std::log(uniform(splitmix64(z, 0)));
+
+				double x = j * w[i];
+				z = splitmix64(z, 0);
+				if (f[i] + uniform(z) * (f[i - 1] - f[i]) < std::exp(-x)) return x;
+				z = splitmix64(z, 0);
+			}
+		}
+	};
+
+	// site i of the count-th sweep takes position count * n + i of the
+	// sequence of the replica
+	void fill(std::size_t sweep, std::size_t count)
+	{
+		static const ziggurat exponential;
+
+		const uint64_t pos = uint64_t(count) * n;
+		const double s = key->scale[sweep];
+
+		for (std::size_t i = 0; i < n; ++i)
+			table[i] = exponential(splitmix64(seed, pos + i)) * s;
+		if (ncopies == 2) std::copy(table.begin(), table.begin() + n, table.begin() + n);
+
+		cur = sweep;
+		cur_count = count;
+	}
+#else
+	std::shared_ptr<const std::vector<std::vector<double> > > tables;
+#endif
+};
+
+#endif
@@ -37,8 +37,8 @@ inline void usage(const std::string& msg, bool multi_threaded)
 {
 	std::cerr << "usage: " << "\n";
 	std::cerr << "an.e -l lattice -s nsweeps -r nreps";
-	std::cerr << " [-b0 beta0] [-b1 beta1] [-r0 rep0]";
-	std::cerr << " [-v] [-sched sched_kind] [-t nthreads]\n";
+	std::cerr << " [-b0 beta0] [-b1 beta1] [-G0 gamma0] [-G1 gamma1] [-r0 rep0]";
+	std::cerr << " [-v] [-sched sched_kind] [-order kind] [-t nthreads] [-chunk nchunk] [-pin] [-numa] [-w width] [-nfw rate] [-lanes list] [-spins file] [-target energy] [-stop] [-check k] [-best] [-time seconds]\n";
 	std::cerr << "where optional parameters are in square brackets\n";
 	std::cerr << " -l lattice        --- lattice file\n";
 	std::cerr << " -s nsweeps        --- number of sweeps\n";
@@ -46,15 +46,127 @@ inline void usage(const std::string& msg, bool multi_threaded)
 	std::cerr << " -r0 rep0          --- start repetition; default value: 0\n";
 	std::cerr << " -b0 beta0         --- initial inverse temperature; default value: 0.1\n";
 	std::cerr << " -b1 beta1         --- final inverse temperature; default value: 3.0\n";
+	std::cerr << " -G0 gamma0        --- initial transverse field of quantum annealing codes; default value: 3.0\n";
+	std::cerr << " -G1 gamma1        --- final transverse field of quantum annealing codes; default value: 0.0\n";
 	std::cerr << " -sched sched_kind --- schedule kind: lin or exp or file name; default value: lin\n";
+	std::cerr << " -order kind       --- site order: none, bfs, rcm or label; default value: none\n";
 	std::cerr << " -v                --- verbose mode; prints some info including timing info\n";
     std::cerr << " -g                --- prints only the lowest energy solution\n";
-	if (multi_threaded)
+	std::cerr << " -w width          --- word width in bits of multi-spin codes: 64, 256 or 512; default value: 64\n";
+	std::cerr << " -nfw rate         --- codes with the n-fold way switch to it when the acceptance rate of a sweep\n";
+	std::cerr << "                       drops below rate; default value: 0 (never)\n";
+	std::cerr << " -lanes list       --- an_ms_r1_nf anneals the instances listed in file list, which share one graph,\n";
+	std::cerr << "                       in the lanes of a word instead of lattice\n";
+	std::cerr << " -spins file       --- writes the final spin configurations to file; with -g only those of\n";
+	std::cerr << "                       the lowest energy\n";
+	std::cerr << " -target energy    --- stops a repetition when one of its replicas reaches energy and prints\n";
+	std::cerr << "                       the time to target\n";
+	std::cerr << " -stop             --- with -target, stops the run when the first repetition reaches it\n";
+	std::cerr << " -check k          --- checks the target and the lowest energies of -best every k sweeps and\n";
+	std::cerr << "                       after the last one; a check costs the multi-spin codes 0.3 to 1 sweeps;\n";
+	std::cerr << "                       default value: 20 for multi-spin codes, 1 for the others\n";
+	std::cerr << " -best             --- reports the lowest energy state of every replica, looked at every k sweeps\n";
+	std::cerr << "                       of -check and at the end, instead of the final one\n";
+	std::cerr << " -time seconds     --- runs repetitions until seconds have passed since the start, or nreps are done,\n";
+	std::cerr << "                       and prints when the lowest energy was lowered; -r is then optional\n";
+	if (multi_threaded) {
 		std::cerr << " -t nthreads       --- number of threads\n";
+		std::cerr << " -chunk nchunk     --- number of repetitions a thread takes at a time; default value: 1\n";
+		std::cerr << " -pin              --- binds threads to cpus, spread over the NUMA nodes\n";
+		std::cerr << " -numa             --- like -pin, and keeps a copy of the instance on every NUMA node\n";
+	}
 
 	if (!msg.empty())
 		throw std::runtime_error(msg);
 }
 
-#endif
+inline void usage_pt(const std::string& msg)
+{
+	std::cerr << "usage: " << "\n";
+	std::cerr << "an_pt.e -l lattice -s nsweeps -r nreps";
+	std::cerr << " [-b0 beta0] [-b1 beta1] [-nt ntemps] [-se nswap] [-r0 rep0]";
+	std::cerr << " [-target energy] [-v] [-sched sched_kind] [-order kind] [-t nthreads] [-w width]\n";
+	std::cerr << "where optional parameters are in square brackets\n";
+	std::cerr << " -l lattice        --- lattice file\n";
+	std::cerr << " -s nsweeps        --- number of sweeps at every temperature\n";
+	std::cerr << " -r nreps          --- number of independent runs\n";
+	std::cerr << " -r0 rep0          --- start run; default value: 0\n";
+	std::cerr << " -b0 beta0         --- highest temperature of the ladder; default value: 0.1\n";
+	std::cerr << " -b1 beta1         --- lowest temperature of the ladder; default value: 3.0\n";
+	std::cerr << " -nt ntemps        --- number of temperatures; default value: 32\n";
+	std::cerr << " -sched sched_kind --- ladder kind: lin or exp or file name; default value: exp\n";
+	std::cerr << " -order kind       --- site order: none, bfs, rcm or label; default value: none\n";
+	std::cerr << " -se nswap         --- sweeps between replica exchanges; default value: 1\n";
+	std::cerr << " -target energy    --- stops a run when the energy is reached and prints the time to target\n";
+	std::cerr << " -v                --- verbose mode; prints some info including timing info\n";
+	std::cerr << " -g                --- prints only the lowest energy solution\n";
+	std::cerr << " -w width          --- word width in bits of multi-spin codes: 64, 256 or 512; default value: 64\n";
+	std::cerr << " -t nthreads       --- number of threads\n";
+
+	if (!msg.empty())
+		throw std::runtime_error(msg);
+}
+
+inline void usage_pa(const std::string& msg)
+{
+	std::cerr << "usage: " << "\n";
+	std::cerr << "an_pa.e -l lattice -s nsweeps -r nreps";
+	std::cerr << " [-p popsize] [-nt ntemps] [-b0 beta0] [-b1 beta1] [-r0 rep0]";
+	std::cerr << " [-v] [-sched sched_kind] [-order kind] [-t nthreads] [-w width]\n";
+	std::cerr << "where optional parameters are in square brackets\n";
+	std::cerr << " -l lattice        --- lattice file\n";
+	std::cerr << " -s nsweeps        --- number of sweeps at every temperature\n";
+	std::cerr << " -r nreps          --- number of independent populations\n";
+	std::cerr << " -r0 rep0          --- start repetition; default value: 0\n";
+	std::cerr << " -p popsize        --- population size, of every lane of multi-spin codes; default value: 1000\n";
+	std::cerr << " -nt ntemps        --- number of temperatures; default value: 100\n";
+	std::cerr << " -b0 beta0         --- initial inverse temperature; default value: 0.1\n";
+	std::cerr << " -b1 beta1         --- final inverse temperature; default value: 3.0\n";
+	std::cerr << " -sched sched_kind --- schedule kind: lin or exp or file name; default value: lin\n";
+	std::cerr << " -order kind       --- site order: none, bfs, rcm or label; default value: none\n";
+	std::cerr << " -v                --- verbose mode; prints some info including timing info\n";
+	std::cerr << " -g                --- prints only the lowest energy solution\n";
+	std::cerr << " -w width          --- word width in bits of multi-spin codes: 64, 256 or 512; default value: 64\n";
+	std::cerr << " -t nthreads       --- number of threads\n";
 
+	if (!msg.empty())
+		throw std::runtime_error(msg);
+}
+
+inline void usage_batch(const std::string& msg)
+{
+	std::cerr << "usage: " << "\n";
+	std::cerr << "an_batch.e -m manifest [-s nsweeps] [-r nreps]";
+	std::cerr << " [-b0 beta0] [-b1 beta1] [-G0 gamma0] [-G1 gamma1] [-r0 rep0]";
+	std::cerr << " [-v] [-sched sched_kind] [-order kind] [-t nthreads] [-chunk nchunk] [-w width] [-nfw rate] [-best] [-check k]\n";
+	std::cerr << "where optional parameters are in square brackets\n";
+	std::cerr << " -m manifest       --- file with a lattice file and its options on every line; -s, -r, -r0,\n";
+	std::cerr << "                       -b0, -b1, -G0, -G1, -sched, -nfw, -best and -check given there override\n";
+	std::cerr << "                       those below, and -spins file writes the final spin configurations of the instance to file\n";
+	std::cerr << " -s nsweeps        --- number of sweeps\n";
+	std::cerr << " -r nreps          --- number of repetitions\n";
+	std::cerr << " -r0 rep0          --- start repetition; default value: 0\n";
+	std::cerr << " -b0 beta0         --- initial inverse temperature; default value: 0.1\n";
+	std::cerr << " -b1 beta1         --- final inverse temperature; default value: 3.0\n";
+	std::cerr << " -G0 gamma0        --- initial transverse field of quantum annealing codes; default value: 3.0\n";
+	std::cerr << " -G1 gamma1        --- final transverse field of quantum annealing codes; default value: 0.0\n";
+	std::cerr << " -sched sched_kind --- schedule kind: lin or exp or file name; default value: lin\n";
+	std::cerr << " -order kind       --- site order: none, bfs, rcm or label; default value: none\n";
+	std::cerr << " -v                --- verbose mode; prints some info including timing info\n";
+	std::cerr << " -g                --- prints only the lowest energy solution\n";
+	std::cerr << " -w width          --- word width in bits of multi-spin codes: 64, 256 or 512; default value: 64\n";
+	std::cerr << " -nfw rate         --- codes with the n-fold way switch to it when the acceptance rate of a sweep\n";
+	std::cerr << "                       drops below rate; default value: 0 (never)\n";
+	std::cerr << " -best             --- reports the lowest energy state of every replica, looked at every k sweeps\n";
+	std::cerr << "                       of -check and at the end, instead of the final one\n";
+	std::cerr << " -check k          --- sweeps between two looks at the lowest energies of -best; a look costs\n";
+	std::cerr << "                       the multi-spin codes 0.3 to 1 sweeps; default value: 20 for multi-spin\n";
+	std::cerr << "                       codes, 1 for the others\n";
+	std::cerr << " -t nthreads       --- number of threads\n";
+	std::cerr << " -chunk nchunk     --- number of repetitions a thread takes at a time; default value: 1\n";
+
+	if (!msg.empty())
+		throw std::runtime_error(msg);
+}
+
+#endif
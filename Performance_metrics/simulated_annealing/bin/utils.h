@@ -32,12 +32,24 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define __UTILS_H__
 
 #include <map>
+#include <algorithm>
 #include <string>
+#include <cctype>
+#include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <sstream>
+#include <stdexcept>
 #include <vector>
-#include <sys/time.h>
-#include <time.h>
+#include <new>
+#include <chrono>
+#include <thread>
+
+#ifdef __linux__
+#	include <sched.h>
+#	include <dirent.h>
+#	include <sys/mman.h>
+#endif
 
 /*** strings ******************************************************************/
 
@@ -116,14 +128,16 @@ typedef std::map<std::string, std::string> amap_type;
 
 inline amap_type parse_args(int argc, char *argv[])
 {
-	// note: negative numbers cannot be parsed
+	// note: a negative number is parsed as a value if it follows a key
 
 	amap_type args;
 
 	bool have_key = false;
 	std::string key;
 	for (std::size_t i = 1; i < std::size_t(argc); ++i) {
-		if (argv[i][0] == '-') {
+		bool number = argv[i][0] == '-'
+			&& (std::isdigit(argv[i][1]) || argv[i][1] == '.');
+		if (argv[i][0] == '-' && !(have_key && number)) {
 			if (have_key)
 				args[key] = "1";
 			else
@@ -204,15 +218,370 @@ inline opt<double> get_darg(const amap_type& args, const std::string& o, double
 	return opt<double>(std::atof(it->second.c_str()));
 }
 
+/*** memory *******************************************************************/
+
+// allocator of memory aligned to cache lines; arrays allocated with it
+// do not share a cache line with other data. On Linux, arrays of at
+// least one huge page are aligned to huge pages and marked for
+// transparent huge pages, which saves TLB misses on large instances.
+
+template <typename T, std::size_t alignment = 64>
+struct aligned_allocator {
+	typedef T value_type;
+
+	template <typename U>
+	struct rebind {
+		typedef aligned_allocator<U, alignment> other;
+	};
+
+	aligned_allocator() {}
+
+	template <typename U>
+	aligned_allocator(const aligned_allocator<U, alignment>&) {}
+
+	T* allocate(std::size_t n)
+	{
+		void* p = 0;
+#ifdef MADV_HUGEPAGE
+		const std::size_t huge_page_size = 1 << 21;
+		std::size_t size = n * sizeof(T);
+		if (size >= huge_page_size) {
+			size = (size + huge_page_size - 1) & ~(huge_page_size - 1);
+			if (posix_memalign(&p, huge_page_size, size) != 0)
+				throw std::bad_alloc();
+			madvise(p, size, MADV_HUGEPAGE);
+			return static_cast<T*>(p);
+		}
+#endif
+		if (posix_memalign(&p, alignment, n * sizeof(T)) != 0)
+			throw std::bad_alloc();
+		return static_cast<T*>(p);
+	}
+
+	void deallocate(T* p, std::size_t)
+	{
+		std::free(p);
+	}
+};
+
+template <typename T, typename U, std::size_t alignment>
+inline bool operator==(const aligned_allocator<T, alignment>&,
+	const aligned_allocator<U, alignment>&)
+{
+	return true;
+}
+
+template <typename T, typename U, std::size_t alignment>
+inline bool operator!=(const aligned_allocator<T, alignment>&,
+	const aligned_allocator<U, alignment>&)
+{
+	return false;
+}
+
+template <typename T>
+using aligned_vector = std::vector<T, aligned_allocator<T> >;
+
+/*** text files ***************************************************************/
+
+// reads a text file in blocks of 1 MB and hands it out line by line;
+// the fields of a line are parsed in place without streams, and errors
+// report the file and the line number. Blanks are spaces, tabs and
+// carriage returns, and a '#' starts a comment that ends the line.
+
+class text_reader {
+public:
+	enum { block_size = 1 << 20 };
+
+	text_reader(const std::string& file, const std::string& what)
+		: file(file), fp(std::fopen(file.c_str(), "rb")), buf(block_size + 1),
+		p(0), next(0), end(0), nline(0), nbytes(0), eof(false)
+	{
+		if (!fp)
+			throw std::runtime_error("cannot open file " + file + " to read " + what);
+	}
+
+	~text_reader()
+	{
+		std::fclose(fp);
+	}
+
+	// advances to the next line; false at the end of the file
+	bool next_line()
+	{
+		char* nl = next < end ?
+			static_cast<char*>(std::memchr(&buf[next], '\n', end - next)) : 0;
+
+		while (!nl) {
+			if (eof) {
+				// the last line need not end with a newline
+				if (next >= end) return false;
+				nl = &buf[end];
+				break;
+			}
+
+			// keep the start of the current line and read another block
+			std::size_t rest = end - next;
+			std::memmove(&buf[0], &buf[next], rest);
+			next = 0;
+			end = rest;
+			if (buf.size() < end + block_size + 1)
+				buf.resize(end + block_size + 1);
+
+			std::size_t n = std::fread(&buf[end], 1, block_size, fp);
+			if (std::ferror(fp))
+				throw std::runtime_error("cannot read file " + file);
+			eof = n < std::size_t(block_size);
+			nbytes += n;
+			end += n;
+
+			nl = static_cast<char*>(std::memchr(&buf[rest], '\n', n));
+		}
+
+		*nl = '\0';
+		p = &buf[next];
+		next = nl - &buf[0] + 1;
+		++nline;
+
+		return true;
+	}
+
+	// skips blanks; true if nothing but a comment is left in the line
+	bool end_of_line()
+	{
+		while (*p == ' ' || *p == '\t' || *p == '\r') ++p;
+		return *p == '\0' || *p == '#';
+	}
+
+	// true if the next field starts like a number
+	bool at_number()
+	{
+		return !end_of_line() && (is_digit(*p) || *p == '-' || *p == '+' || *p == '.');
+	}
+
+	// reads an unsigned decimal integer
+	bool read(unsigned long& v)
+	{
+		if (end_of_line() || !is_digit(*p)) return false;
+
+		const unsigned long max = ~0ul;
+		v = 0;
+		for (; is_digit(*p); ++p) {
+			unsigned d = *p - '0';
+			if (v > (max - d) / 10) return false;
+			v = 10 * v + d;
+		}
+
+		return is_delimiter(*p);
+	}
+
+	// reads a word up to the next blank
+	bool read(std::string& v)
+	{
+		if (end_of_line()) return false;
+
+		char* q = p;
+		while (!is_delimiter(*q)) ++q;
+		v.assign(p, q);
+		p = q;
+
+		return true;
+	}
+
+	// reads a number; integers of up to 15 digits are converted
+	// directly, other numbers by strtod
+	bool read(double& v)
+	{
+		if (end_of_line()) return false;
+
+		char* q = p;
+		bool negative = *q == '-';
+		if (*q == '-' || *q == '+') ++q;
+
+		char* first = q;
+		unsigned long long n = 0;
+		for (; is_digit(*q) && q - first < 15; ++q)
+			n = 10 * n + (*q - '0');
+
+		if (q != first && is_delimiter(*q)) {
+			v = negative ? -double(n) : double(n);
+			p = q;
+			return true;
+		}
+
+		char* e;
+		v = std::strtod(p, &e);
+		if (e == p) return false;
+		p = e;
+
+		return is_delimiter(*p);
+	}
+
+	// throws an error about the current line
+	void error(const std::string& msg) const
+	{
+		std::ostringstream ss;
+		ss << file << ", line " << nline << ": " << msg;
+		throw std::runtime_error(ss.str());
+	}
+
+	// number of bytes read so far
+	std::size_t size() const
+	{
+		return nbytes;
+	}
+private:
+	text_reader(const text_reader&);
+	text_reader& operator=(const text_reader&);
+
+	static bool is_digit(char c)
+	{
+		return c >= '0' && c <= '9';
+	}
+
+	static bool is_delimiter(char c)
+	{
+		return c == ' ' || c == '\t' || c == '\r' || c == '\0' || c == '#';
+	}
+
+	std::string file;
+	std::FILE* fp;
+	std::vector<char> buf;
+	char* p;
+	std::size_t next;
+	std::size_t end;
+	std::size_t nline;
+	std::size_t nbytes;
+	bool eof;
+};
+
+// reads a list of file names, one per line
+inline std::vector<std::string> read_file_list(const std::string& file)
+{
+	text_reader in(file, "list of files");
+
+	std::vector<std::string> files;
+	while (in.next_line()) {
+		std::string name;
+		if (in.end_of_line()) continue;
+		if (!in.read(name) || !in.end_of_line())
+			in.error("expected one file name");
+		files.push_back(name);
+	}
+
+	if (files.empty())
+		throw std::runtime_error("no files listed in " + file);
+
+	return files;
+}
+
+/*** threads ****************************************************************/
+
+// cpus of the NUMA nodes that this process may run on; a single node
+// with all cpus if the nodes are not known
+
+inline std::vector<std::vector<int> > get_numa_cpus()
+{
+	std::vector<std::vector<int> > nodes;
+
+#ifdef __linux__
+	cpu_set_t allowed;
+	CPU_ZERO(&allowed);
+	bool have_allowed = sched_getaffinity(0, sizeof(allowed), &allowed) == 0;
+
+	std::vector<int> ids;
+	if (DIR* dir = opendir("/sys/devices/system/node")) {
+		while (dirent* e = readdir(dir))
+			if (std::strncmp(e->d_name, "node", 4) == 0 && std::isdigit(e->d_name[4]))
+				ids.push_back(std::atoi(e->d_name + 4));
+		closedir(dir);
+	}
+	std::sort(ids.begin(), ids.end());
+
+	for (int id : ids) {
+		// cpulist is e.g. "0-7,16-23"
+		std::string file = "/sys/devices/system/node/node" + to_s(id) + "/cpulist";
+		std::FILE* fp = std::fopen(file.c_str(), "r");
+		if (!fp) continue;
+		char buf[4096];
+		char* line = std::fgets(buf, sizeof(buf), fp);
+		std::fclose(fp);
+		if (!line) continue;
+
+		std::vector<int> cpus;
+		for (char* p = line; std::isdigit(*p); ) {
+			int c0 = std::strtol(p, &p, 10);
+			int c1 = *p == '-' ? std::strtol(p + 1, &p, 10) : c0;
+			for (int c = c0; c <= c1; ++c)
+				if (!have_allowed || (c < CPU_SETSIZE && CPU_ISSET(c, &allowed)))
+					cpus.push_back(c);
+			if (*p == ',') ++p;
+		}
+
+		if (!cpus.empty()) nodes.push_back(cpus);
+	}
+
+	if (nodes.empty() && have_allowed) {
+		nodes.resize(1);
+		for (int c = 0; c < CPU_SETSIZE; ++c)
+			if (CPU_ISSET(c, &allowed)) nodes[0].push_back(c);
+	}
+#endif
+
+	if (nodes.empty()) {
+		nodes.resize(1);
+		unsigned n = std::max(1u, std::thread::hardware_concurrency());
+		for (unsigned c = 0; c < n; ++c) nodes[0].push_back(c);
+	}
+
+	return nodes;
+}
+
+// cpu and NUMA node of a thread
+struct thread_place {
+	int cpu;
+	unsigned node;
+};
+
+// places n threads round robin on the NUMA nodes, so that all memory
+// controllers are used, and on the cpus within a node
+inline std::vector<thread_place> place_threads(unsigned n)
+{
+	std::vector<std::vector<int> > nodes = get_numa_cpus();
+
+	std::vector<thread_place> place(n);
+	for (unsigned m = 0; m < n; ++m) {
+		unsigned node = m % nodes.size();
+		const std::vector<int>& cpus = nodes[node];
+		place[m].cpu = cpus[m / nodes.size() % cpus.size()];
+		place[m].node = node;
+	}
+
+	return place;
+}
+
+// binds the calling thread to a cpu; false if that is not supported
+inline bool pin_thread(int cpu)
+{
+#ifdef __linux__
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(cpu, &set);
+	return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+	(void)cpu;
+	return false;
+#endif
+}
+
 /*** time *********************************************************************/
 
+// seconds from a monotonic clock, which does not jump when the system
+// time is set, so that intervals and the deadline of -time hold
 inline double get_time()
 {
-	struct timeval tv;
-	if (gettimeofday(&tv, NULL) != 0)
-		return 0.0;
-	else
-		return tv.tv_sec + 1e-6 * tv.tv_usec;
+	typedef std::chrono::duration<double> seconds;
+	return std::chrono::duration_cast<seconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
 }
 
 #endif
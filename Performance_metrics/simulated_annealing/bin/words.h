@@ -0,0 +1,509 @@
+/******************************************************************************
+
+Simulated annealing codes
+v1.0
+
+---------------------------------------------------------------------
+
+Contains 256-bit (AVX2) and 512-bit (AVX-512) word types for
+multi-spin codes, a function that selects the word type at run time,
+and the energies and lowest energy states of the lanes of multi-spin
+replicas.
+
+---------------------------------------------------------------------
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*******************************************************************************/
+
+#ifndef __WORDS_H__
+#define __WORDS_H__
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <stdexcept>
+
+#if defined(__AVX2__) || defined(__AVX512F__)
+#	include <immintrin.h>
+#endif
+
+#include "utils.h"
+
+// word type of the random number generator used to pick thresholds;
+// wide words use a 64-bit generator since only depth bits are needed
+
+template <typename T>
+struct word_traits {
+	typedef T rand_type;
+};
+
+template <typename T>
+inline unsigned word_bit(const T& word, std::size_t k)
+{
+	return unsigned((word >> k) & 1);
+}
+
+template <typename T>
+inline bool word_any(const T& word)
+{
+	return word != 0;
+}
+
+// word with bit k set for every nonzero lanes[k]
+
+template <typename T>
+inline T lanes_to_word(const std::vector<char>& lanes)
+{
+	T word = 0;
+	for (std::size_t k = 0; k < lanes.size(); ++k)
+		if (lanes[k]) word |= T(1) << k;
+
+	return word;
+}
+
+// integer constants are broadcast to every 64-bit element,
+// so word_type(0) and word_type(-1) behave as for scalar words
+
+#ifdef __AVX2__
+
+class word256 {
+public:
+	word256() {}
+	word256(__m256i v) : v(v) {}
+	word256(int c) : v(_mm256_set1_epi64x(c)) {}
+
+	static word256 load(const uint64_t* p)
+	{
+		return _mm256_loadu_si256((const __m256i*) p);
+	}
+
+	void store(uint64_t* p) const
+	{
+		_mm256_storeu_si256((__m256i*) p, v);
+	}
+
+	word256 operator~() const { return _mm256_xor_si256(v, _mm256_set1_epi64x(-1)); }
+
+	word256 operator&(const word256& w) const { return _mm256_and_si256(v, w.v); }
+	word256 operator|(const word256& w) const { return _mm256_or_si256(v, w.v); }
+	word256 operator^(const word256& w) const { return _mm256_xor_si256(v, w.v); }
+
+	word256& operator&=(const word256& w) { v = _mm256_and_si256(v, w.v); return *this; }
+	word256& operator|=(const word256& w) { v = _mm256_or_si256(v, w.v); return *this; }
+	word256& operator^=(const word256& w) { v = _mm256_xor_si256(v, w.v); return *this; }
+
+	bool any() const { return !_mm256_testz_si256(v, v); }
+private:
+	__m256i v;
+};
+
+template <>
+struct word_traits<word256> {
+	typedef uint64_t rand_type;
+};
+
+template <>
+inline bool word_any(const word256& word)
+{
+	return word.any();
+}
+
+template <>
+inline unsigned word_bit(const word256& word, std::size_t k)
+{
+	uint64_t w[4];
+	word.store(w);
+	return unsigned((w[k / 64] >> (k % 64)) & 1);
+}
+
+template <>
+inline word256 lanes_to_word(const std::vector<char>& lanes)
+{
+	uint64_t w[4] = {};
+	for (std::size_t k = 0; k < lanes.size(); ++k)
+		if (lanes[k]) w[k / 64] |= uint64_t(1) << (k % 64);
+
+	return word256::load(w);
+}
+
+template <typename G>
+inline word256 random_word(G& rgen, const word256&)
+{
+	uint64_t w[4];
+	for (unsigned i = 0; i < 4; ++i)
+		w[i] = random_word(rgen, w[i]);
+
+	return word256::load(w);
+}
+
+#endif
+
+#ifdef __AVX512F__
+
+class word512 {
+public:
+	word512() {}
+	word512(__m512i v) : v(v) {}
+	word512(int c) : v(_mm512_set1_epi64(c)) {}
+
+	static word512 load(const uint64_t* p)
+	{
+		return _mm512_loadu_si512((const void*) p);
+	}
+
+	void store(uint64_t* p) const
+	{
+		_mm512_storeu_si512((void*) p, v);
+	}
+
+	word512 operator~() const { return _mm512_xor_si512(v, _mm512_set1_epi64(-1)); }
+
+	word512 operator&(const word512& w) const { return _mm512_and_si512(v, w.v); }
+	word512 operator|(const word512& w) const { return _mm512_or_si512(v, w.v); }
+	word512 operator^(const word512& w) const { return _mm512_xor_si512(v, w.v); }
+
+	word512& operator&=(const word512& w) { v = _mm512_and_si512(v, w.v); return *this; }
+	word512& operator|=(const word512& w) { v = _mm512_or_si512(v, w.v); return *this; }
+	word512& operator^=(const word512& w) { v = _mm512_xor_si512(v, w.v); return *this; }
+
+	bool any() const { return _mm512_test_epi64_mask(v, v) != 0; }
+private:
+	__m512i v;
+};
+
+template <>
+struct word_traits<word512> {
+	typedef uint64_t rand_type;
+};
+
+template <>
+inline bool word_any(const word512& word)
+{
+	return word.any();
+}
+
+template <>
+inline unsigned word_bit(const word512& word, std::size_t k)
+{
+	uint64_t w[8];
+	word.store(w);
+	return unsigned((w[k / 64] >> (k % 64)) & 1);
+}
+
+template <>
+inline word512 lanes_to_word(const std::vector<char>& lanes)
+{
+	uint64_t w[8] = {};
+	for (std::size_t k = 0; k < lanes.size(); ++k)
+		if (lanes[k]) w[k / 64] |= uint64_t(1) << (k % 64);
+
+	return word512::load(w);
+}
+
+template <typename G>
+inline word512 random_word(G& rgen, const word512&)
+{
+	uint64_t w[8];
+	for (unsigned i = 0; i < 8; ++i)
+		w[i] = random_word(rgen, w[i]);
+
+	return word512::load(w);
+}
+
+#endif
+
+// calls f.run<W>() with the word type W of the given width in bits; the
+// whole executable is built for the instruction set of SIMDFLAGS, so it
+// is not checked again at run time
+
+template <typename F>
+inline void with_word_type(unsigned width, const F& f)
+{
+	if (width == 64) {
+		f.template run<uint64_t>();
+		return;
+	}
+#ifdef __AVX2__
+	if (width == 256) {
+		f.template run<word256>();
+		return;
+	}
+#endif
+#ifdef __AVX512F__
+	if (width == 512) {
+		f.template run<word512>();
+		return;
+	}
+#endif
+
+	throw std::runtime_error("word width " + to_s(width)
+		+ " is not available; available widths depend on SIMDFLAGS in Makefile");
+}
+
+// sweeps between two checks of the lane energies with -target and
+// -best unless -check is given; a check counts all terms of all lanes, which costs
+// 0.3 to 1 sweeps, so checking every sweep would slow down the codes by
+// up to half
+#define DEFAULT_CHECK 20
+
+// energies of the lanes of multi-spin replicas with integer couplings
+// and fields. Every term adds its weight |c| to the lanes in which it
+// is not satisfied; the sums are kept bit-sliced, counts[p] holding bit
+// p of the sum of every lane, so that all lanes are counted and
+// compared at once. The energy of a lane is twice its sum less the sum
+// of all weights.
+
+template <typename word_type>
+class lane_energies {
+public:
+	lane_energies() : wsum(0) {}
+
+	// coupling c between the spins i and j, or field c on spin i if i == j
+	void add(std::size_t i, std::size_t j, long c)
+	{
+		if (c == 0) return;
+
+		// a coupling is not satisfied if c * s_i * s_j > 0, a field if
+		// c * s_i > 0; the flag is kept in the highest bit of j
+		const uint32_t flip = uint32_t(i != j ? c > 0 : c < 0) << 31;
+		const unsigned long weight = std::abs(c);
+
+		// every bit of the weight is a level of terms of weight 1
+		for (std::size_t b = 0; weight >> b; ++b) {
+			if (b == levels.size()) levels.resize(b + 1);
+			if (((weight >> b) & 1) == 0) continue;
+			if (i != j)
+				levels[b].pairs.push_back(pair_term{uint32_t(i), uint32_t(j) | flip});
+			else
+				levels[b].fields.push_back(uint32_t(i) | flip);
+		}
+
+		wsum += weight;
+	}
+
+	// couplings of weight 1 whose sign differs between the lanes; the
+	// coupling is positive in the lanes set in positive
+	void add_lanes(std::size_t i, std::size_t j, const word_type& positive)
+	{
+		lane_pairs.push_back(pair_term{uint32_t(i), uint32_t(j)});
+		lane_signs.push_back(positive);
+
+		wsum += 1;
+	}
+
+	// fields and couplings of the sites of a multi-spin code; site i has
+	// spin spin(i), and its neighbors are given by their spins
+	template <typename S, typename F>
+	void add_sites(const S& sites, const F& spin)
+	{
+		for (std::size_t i = 0; i < sites.size(); ++i) {
+			const std::size_t s = spin(i);
+			add(s, s, sites[i].hzv);
+			for (std::size_t l = 0; l < sites[i].nneighbs; ++l)
+				if (s < sites[i].neighbs[l])
+					add(s, sites[i].neighbs[l], sites[i].jzv[l]);
+		}
+	}
+
+	template <typename S>
+	void add_sites(const S& sites)
+	{
+		add_sites(sites, [](std::size_t i) { return i; });
+	}
+
+	std::size_t nplanes() const
+	{
+		std::size_t n = 1;
+		while (wsum >> n) ++n;
+		return n;
+	}
+
+	// sums of the weights of the terms not satisfied by the spins s
+	void count(const word_type* s, aligned_vector<word_type>& counts) const
+	{
+		counts.assign(nplanes(), word_type(0));
+
+		const word_type masks[2] = { word_type(0), word_type(-1) };
+		const uint32_t index = ~(uint32_t(1) << 31);
+
+		for (std::size_t b = 0; b < levels.size(); ++b) {
+			const std::vector<pair_term>& pairs = levels[b].pairs;
+			const std::vector<uint32_t>& fields = levels[b].fields;
+
+			add_words(counts, b, pairs.size(), [&](std::size_t n) {
+				const pair_term& t = pairs[n];
+				return s[t.i] ^ s[t.j & index] ^ masks[t.j >> 31];
+			});
+			add_words(counts, b, fields.size(), [&](std::size_t n) {
+				return s[fields[n] & index] ^ masks[fields[n] >> 31];
+			});
+		}
+
+		add_words(counts, 0, lane_pairs.size(), [&](std::size_t n) {
+			const pair_term& t = lane_pairs[n];
+			return s[t.i] ^ s[t.j] ^ lane_signs[n];
+		});
+	}
+
+	// lanes whose energy is at most e
+	word_type at_most(const aligned_vector<word_type>& counts, double e) const
+	{
+		// the energy is 2 * sum - wsum
+		double m = std::floor((e + wsum) / 2);
+		if (m < 0) return word_type(0);
+		if (m >= double(1ul << counts.size())) return word_type(-1);
+
+		unsigned long max = (unsigned long)(m);
+
+		// compares the sums with max from the highest bit down
+		word_type less = word_type(0);
+		word_type equal = word_type(-1);
+		for (std::size_t p = counts.size(); p-- > 0; ) {
+			if ((max >> p) & 1) {
+				less |= equal & ~counts[p];
+				equal &= counts[p];
+			} else
+				equal &= ~counts[p];
+		}
+
+		return less | equal;
+	}
+
+	// energy of lane k
+	long energy(const aligned_vector<word_type>& counts, std::size_t k) const
+	{
+		long sum = 0;
+		for (std::size_t p = 0; p < counts.size(); ++p)
+			sum += long(word_bit(counts[p], k)) << p;
+
+		return 2 * sum - wsum;
+	}
+private:
+	struct pair_term {
+		uint32_t i;
+		uint32_t j;
+	};
+
+	// the terms of weight 2^b
+	struct level {
+		std::vector<pair_term> pairs;
+		std::vector<uint32_t> fields;
+	};
+
+	// carry-save adder: adds a and b to the sum bit l, leaving the carry
+	// in h
+	static void csa(word_type& h, word_type& l, const word_type& a, const word_type& b)
+	{
+		word_type u = l ^ a;
+		h = (l & a) | (u & b);
+		l = u ^ b;
+	}
+
+	// adds u times 2^p to counts
+	static void add_word(aligned_vector<word_type>& counts, word_type u, std::size_t p)
+	{
+		for (; word_any(u); ++p) {
+			word_type c = counts[p] & u;
+			counts[p] ^= u;
+			u = c;
+		}
+	}
+
+	// adds the words u(0), ..., u(n - 1) times 2^b to counts; they are
+	// added eight at a time by a tree of carry-save adders, which has no
+	// data-dependent branches, and only every eighth word is added to
+	// counts
+	template <typename F>
+	static void add_words(aligned_vector<word_type>& counts, std::size_t b,
+		std::size_t n, const F& u)
+	{
+		word_type ones(0), twos(0), fours(0);
+		word_type twos_a, twos_b, fours_a, fours_b, eights;
+
+		std::size_t k = 0;
+		for (; k + 8 <= n; k += 8) {
+			csa(twos_a, ones, u(k), u(k + 1));
+			csa(twos_b, ones, u(k + 2), u(k + 3));
+			csa(fours_a, twos, twos_a, twos_b);
+			csa(twos_a, ones, u(k + 4), u(k + 5));
+			csa(twos_b, ones, u(k + 6), u(k + 7));
+			csa(fours_b, twos, twos_a, twos_b);
+			csa(eights, fours, fours_a, fours_b);
+			add_word(counts, eights, b + 3);
+		}
+		for (; k < n; ++k)
+			add_word(counts, u(k), b);
+
+		add_word(counts, ones, b);
+		add_word(counts, twos, b + 1);
+		add_word(counts, fours, b + 2);
+	}
+
+	std::vector<level> levels;
+	std::vector<pair_term> lane_pairs;
+	aligned_vector<word_type> lane_signs;
+	long wsum;
+};
+
+// lowest energy state of every lane of a multi-spin replica seen so
+// far; the sums of lane_energies of the lanes are kept bit-sliced with
+// their spins, and lanes of lower sums are taken over by masks
+
+template <typename word_type>
+class lane_best {
+public:
+	void reset()
+	{
+		counts.clear();
+	}
+
+	// takes over the lanes of the spins s (n words) whose sums are lower
+	void update(const aligned_vector<word_type>& c, const word_type* s, std::size_t n)
+	{
+		if (counts.empty()) {
+			counts = c;
+			spins.assign(s, s + n);
+			return;
+		}
+
+		// compares the sums from the highest bit down
+		word_type lower = word_type(0);
+		word_type equal = word_type(-1);
+		for (std::size_t p = c.size(); p-- > 0; ) {
+			lower |= equal & ~c[p] & counts[p];
+			equal &= ~(c[p] ^ counts[p]);
+		}
+
+		if (!word_any(lower)) return;
+
+		for (std::size_t p = 0; p < c.size(); ++p)
+			counts[p] ^= (counts[p] ^ c[p]) & lower;
+		for (std::size_t i = 0; i < n; ++i)
+			spins[i] ^= (spins[i] ^ s[i]) & lower;
+	}
+
+	// spins of the lowest energy state, n words as given to update
+	const aligned_vector<word_type>& get_spins() const
+	{
+		return spins;
+	}
+private:
+	aligned_vector<word_type> counts;
+	aligned_vector<word_type> spins;
+};
+
+#endif
@@ -71,7 +71,6 @@ def SA(directory, instance, solver="an_ms_r1_nf", solver_params={"-s":200,"-r":1
     # Necessary imports
     from subprocess import Popen, PIPE
     from os import remove
-    from re import split
     
     # Perfom parameter checks
     if type(directory) != str:
@@ -176,8 +175,109 @@ def SA(directory, instance, solver="an_ms_r1_nf", solver_params={"-s":200,"-r":1
         
     # Format output to return only lowest energy and sweep number s used for
     # timing? To be adjusted as we figure out optimal annealing time etc.
-    output = split("\r\n|\t| ", stdout)
-    output = list(filter(None, output))
+    # Lines starting with "#" are verbose output, the first other line is
+    # the lowest energy
+    from re import search
+    work = float(search(r"#work done in (\S+) s", stdout).group(1))
+    lowest = [line.split() for line in stdout.splitlines() if line.strip() and not line.startswith("#")][0]
     
     # Return lowest energy, successrate, work-time, repetition number
-    return float(output[output.index('#work')+5]), float(output[output.index('#work')+7]), float(output[output.index('#work')+3]), solver_params['-r']
+    return float(lowest[0]), float(lowest[2]), work, solver_params['-r']
+
+
+def SA_batch(directory, instances, solver="an_ms_r1_nf", solver_params={"-s":200,"-r":1000}, verbose=False, solverDir=None):
+    
+    """
+    SA_batch solves several problem instances with a single run of the batch
+    version of a C++ simulated annealing solver (the solver name followed by
+    "_batch", see the README). The instances are listed in a manifest file
+    and share one pool of threads, so no process is started and no file is
+    copied per instance.
+    
+    Parameters:
+    -----------
+    directory: (raw str) the directory containing the problem instances; the
+               manifest is written there, and the solver runs in it.
+    instances: (list) the file names of the instances in directory (without
+               spaces). An entry can also be a tuple of a file name and a
+               dictionary of parameters for that instance only, e.g.
+               ("big.txt", {"-s": 1000, "-r": 100, "-sched": "exp"}).
+    solver: (str, optional) the name of the solver, without "_batch".
+            Defaults to an_ms_r1_nf.
+    solver_params: (dict, optional) the parameters of all instances, as in SA;
+                   "-s" and "-r" are required here or for every instance.
+    verbose: (bool, optional) if True, the output of the solver is printed
+    solverDir: (raw str, optional) the directory of the solver, if it is not
+               directory
+          
+    Returns:
+    --------
+    A list with a tuple (lowest energy, success rate, work time, repetitions)
+    for every instance, in the order of instances, as returned by SA. The work
+    time is the time the threads spent on the instance, in seconds; None
+    stands for an instance the solver could not read.
+    """
+    
+    # Necessary imports
+    from subprocess import Popen, PIPE
+    from os import remove, path
+    from tempfile import mkstemp
+    
+    # Write the manifest, one instance and its parameters per line
+    fd, manifest = mkstemp(suffix=".txt", dir=directory)
+    names = []
+    reps = []
+    with open(fd, "w") as f:
+        for entry in instances:
+            name, params = (entry, {}) if type(entry) == str else entry
+            line = name
+            for param in params.keys():
+                line = line + " " + param + " " + str(params[param])
+            f.write(line + "\n")
+            names.append(name)
+            reps.append(params.get("-r", solver_params.get("-r")))
+    
+    # Build string; -v is needed for the work time of every instance
+    solver_path = path.join(solverDir if solverDir != None else directory, solver + "_batch")
+    command = [solver_path, "-m", manifest, "-v"]
+    for param in solver_params.keys():
+        if param == "-v":
+            continue
+        command.append(param)
+        if param != "-g":
+            command.append(str(solver_params[param]))
+    
+    # Run the C++ solver
+    p = Popen(command, cwd=directory, stdout=PIPE, stderr=PIPE)
+    stdout, stderr = p.communicate()
+    stdout, stderr = stdout.decode("utf-8"), stderr.decode("utf-8")
+    remove(manifest)
+    
+    if verbose:
+        print(stdout, end="\n\n")
+        if stderr != '':
+            print("Error: ", stderr)
+    
+    # Every instance starts with a line "#instance <file>: ... work done
+    # in <time> thread s" followed by its energies, the lowest first
+    results = {}
+    current = None
+    for line in stdout.splitlines():
+        words = line.split()
+        if line.startswith("#instance "):
+            current = line[len("#instance "):line.index(": nsites=")]
+            results[current] = [None, None, float(words[-3])]
+        elif current != None and words and not line.startswith("#"):
+            if results[current][0] is None:
+                results[current][0] = float(words[0])
+                results[current][1] = float(words[2])
+    
+    output = []
+    for name, r in zip(names, reps):
+        if name in results:
+            output.append((results[name][0], results[name][1], results[name][2], r))
+        else:
+            output.append(None)
+    
+    return output
+